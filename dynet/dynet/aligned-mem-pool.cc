@@ -32,6 +32,19 @@ AlignedMemoryPool::~AlignedMemoryPool() {
 
 void* AlignedMemoryPool::allocate(size_t n) {
   void *res = pools[current]->allocate(n);
+  if (res == 0 && current + 1 < (int)pools.size()) {
+    // reuse the next pool, left empty by set_used(), if it is large enough; drop the empty ones otherwise
+    res = pools[current + 1]->allocate(n);
+    if (res != 0) {
+      current++;
+    } else {
+      for (int c = current + 1; c < (int)pools.size(); ++c) {
+        cap -= pools[c]->get_capacity();
+        delete pools[c];
+      }
+      pools.resize(current + 1);
+    }
+  }
   if (res == 0) {
     // round up to the nearest multiple of expanding_unit
     size_t new_pool_size  = (n + expanding_unit-1) / expanding_unit * expanding_unit;
@@ -67,18 +80,16 @@ size_t AlignedMemoryPool::used() {
 }
 
 void AlignedMemoryPool::set_used(size_t s) {
-  if(s != pools.back()->used) {
-    DYNET_ARG_CHECK(pools.size() == 1, "Dynet does not support both dynamic increasing of memory pool size, and automatic batching or memory checkpointing. If you want to use automatic batching or checkpointing, please pre-allocate enough memory using the --dynet-mem command line option (details http://dynet.readthedocs.io/en/latest/commandline.html).");
-    pools[0]->used = s;
+  // s is a value of used(), i.e. the pools before the one it falls in are kept as they are
+  int c = 0;
+  while (c < current && s > pools[c]->used) {
+    s -= pools[c]->used;
+    c++;
   }
-  // TODO: This is disabled for now, because it would require freeing all the memory pools to do properly
-  // int c = 0;
-  // while (s > pools[c]->used) {
-  //   s -= pools[c]->used;
-  //   c++;
-  //   DYNET_ASSERT(c <= current, "attempt to set_used to a larger value than used().");
-  // }
-  // // s <= pools[c]->used
-  // pools[c]->used = s;
-  // current = c;
+  DYNET_ARG_CHECK(s <= pools[c]->used, "Attempt to set_used to a larger value than used() in AlignedMemoryPool " << name);
+  pools[c]->used = s;
+  // the following pools are kept (empty) for reuse by allocate()
+  for (int i = c + 1; i <= current; ++i)
+    pools[i]->used = 0;
+  current = c;
 }
@@ -31,6 +31,7 @@ class InternalMemoryPool {
     a->zero(mem, used);
   }
 
+  size_t get_capacity() const { return capacity; }
   size_t used;
  private:
   void sys_alloc(size_t cap);
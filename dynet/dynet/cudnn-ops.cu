@@ -40,7 +40,7 @@ CudnnConvOp::~CudnnConvOp() noexcept(false) {
 }
 
 void CudnnConvOp::forward_impl(const Device_GPU& dev, const std::vector<const Tensor*>& xs, Tensor& fx) {
-  AlignedMemoryPool* scratch_allocator = dev.pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   const Tensor* x = xs[0]; 
   const Tensor* filter = xs[1];
   Tensor* y = &fx;
@@ -130,7 +130,7 @@ void CudnnConvOp::backward_impl(const Device_GPU & dev,
              const Tensor& dEdf,
              unsigned i,
              Tensor& dEdxi) {
-  AlignedMemoryPool* scratch_allocator = dev.pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = dEdxi.device->scratch_pool();
   const Tensor* x = xs[0]; 
   const Tensor* filter = xs[1];
   const Tensor* dy = &dEdf;
@@ -261,7 +261,7 @@ void CudnnMaxPooling2DOp::forward_impl(const Device_GPU & dev,
   const Tensor* x = xs[0];
   Tensor* y = &fx;
 
-  AlignedMemoryPool* scratch_allocator = dev.pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   unsigned XN = x->d.bd;
   unsigned XC = x->d[2];
   unsigned XH = x->d[0];
@@ -298,7 +298,7 @@ void CudnnMaxPooling2DOp::backward_impl(const Device_GPU & dev,
   const Tensor* dy = &dEdf;
   void* dxi = NULL;
 
-  AlignedMemoryPool* scratch_allocator = dev.pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = dEdxi.device->scratch_pool();
   unsigned XN = x->d.bd;
   unsigned XC = x->d[2];
   unsigned XH = x->d[0];
@@ -1,7 +1,13 @@
 #include "dynet/devices.h"
 
 #include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
 #include <string>
+#ifndef EIGEN_USE_THREADS
+#define EIGEN_USE_THREADS
+#endif
 #include <unsupported/Eigen/CXX11/Tensor>
 
 #include "dynet/cuda.h"
@@ -56,37 +62,98 @@ DeviceMempoolSizes::DeviceMempoolSizes(const std::string & descriptor) {
   }
 }
 
-Device::~Device() {}
+Device::~Device() {
+  for (auto scratch : worker_scratch) delete scratch;
+}
 
 DeviceMempoolSizes Device::mark(ComputationGraph *cg) {
   cg->incremental_forward({cg, (VariableIndex)(cg->nodes.size() - 1)}); // needed so that we actually allocate the needed memory
   // for all existing nodes.
-  return DeviceMempoolSizes(pools[0]->used(), pools[1]->used(), pools[2]->used(), pools[3]->used());
+  return DeviceMempoolSizes(pool(DeviceMempool::FXS)->used(), pool(DeviceMempool::DEDFS)->used(), pool(DeviceMempool::PS)->used(), pool(DeviceMempool::SCS)->used());
 }
 
 void Device::revert(const DeviceMempoolSizes & cp) {
-  if(cp.used[0] > pools[0]->used())
-    DYNET_INVALID_ARG("Saved value greater than original value in Device::revert (" << cp.used[0] << " > " << pools[0]->used() << ")");
-  pools[0]->set_used(cp.used[0]);
-  if(cp.used[1] > pools[1]->used())
-    DYNET_INVALID_ARG("Saved value greater than original value in Device::revert (" << cp.used[1] << " > " << pools[1]->used() << ")");
-  pools[1]->set_used(cp.used[1]);
-  if(cp.used[2] > pools[2]->used())
-    DYNET_INVALID_ARG("Saved value greater than original value in Device::revert (" << cp.used[2] << " > " << pools[2]->used() << ")");
-  pools[2]->set_used(cp.used[2]);
-  if(cp.used[3] > pools[3]->used())
-    DYNET_INVALID_ARG("Saved value greater than original value in Device::revert (" << cp.used[3] << " > " << pools[3]->used() << ")");
-  pools[3]->set_used(cp.used[3]);
+  for (int i = 0; i < 4; ++i) {
+    AlignedMemoryPool* p = pool((DeviceMempool)i);
+    if(cp.used[i] > p->used())
+      DYNET_INVALID_ARG("Saved value greater than original value in Device::revert (" << cp.used[i] << " > " << p->used() << ")");
+    p->set_used(cp.used[i]);
+  }
 }
 
 void Device::allocate_tensor(DeviceMempool mp, Tensor & tens) {
   DYNET_ASSERT(mp != DeviceMempool::NONE, "Attempt to allocate tensor for NONE DeviceMempool");
-  DYNET_ASSERT(pools[(int)mp] != nullptr, "Attempt to allocate tensor for null DeviceMempool");
-  tens.v = (float*)pools[(int)mp]->allocate(tens.d.size() * sizeof(float));
+  DYNET_ASSERT(pool(mp) != nullptr, "Attempt to allocate tensor for null DeviceMempool");
+  tens.v = (float*)pool(mp)->allocate(tens.d.size() * sizeof(float));
   DYNET_ASSERT(tens.v != nullptr, "Allocated tensor is zero");
   tens.mem_pool = mp;
 }
 
+// worker id of the calling thread in a parallel execution engine, -1 otherwise
+static thread_local int scratch_worker_id = -1;
+
+AlignedMemoryPool* Device::pool(DeviceMempool mp) {
+  ExecutionContext* ctx = ExecutionContext::current();
+  if (ctx == nullptr || mp == DeviceMempool::PS) return pools[(int)mp];
+  return ctx->pool(this, mp);
+}
+
+AlignedMemoryPool* Device::scratch_pool() {
+  if (scratch_worker_id < 0) return pool(DeviceMempool::SCS);
+  DYNET_ASSERT((size_t)scratch_worker_id < worker_scratch.size(), "Missing worker scratch pool in Device::scratch_pool");
+  return worker_scratch[scratch_worker_id];
+}
+
+void Device::reserve_worker_scratch(unsigned n) {
+  static std::mutex reserve_mutex;
+  std::lock_guard<std::mutex> lock(reserve_mutex);
+  while (worker_scratch.size() < n) {
+    ostringstream name; name << this->name << " worker " << worker_scratch.size() << " scratch memory";
+    worker_scratch.push_back(new AlignedMemoryPool(name.str(), 1 << 20, mem));
+  }
+}
+
+void Device::set_scratch_worker(int id) {
+  scratch_worker_id = id;
+}
+
+static thread_local ExecutionContext* current_context = nullptr;
+
+ExecutionContext::ExecutionContext(unsigned random_seed, size_t pool_mb) : pool_size(pool_mb << 20) {
+  DYNET_ARG_CHECK(pool_mb > 0, "ExecutionContext needs memory pools of at least 1MB");
+  if (random_seed == 0) {
+    random_device rd;
+    random_seed = rd();
+  }
+  rndeng.seed(random_seed);
+}
+
+ExecutionContext::~ExecutionContext() {
+  DYNET_ASSERT(current_context != this, "Destroying an ExecutionContext that is still active");
+  for (auto & dp : device_pools)
+    for (auto p : dp.second) delete p;
+}
+
+ExecutionContext* ExecutionContext::current() {
+  return current_context;
+}
+
+void ExecutionContext::set_current(ExecutionContext* ctx) {
+  current_context = ctx;
+}
+
+AlignedMemoryPool* ExecutionContext::pool(Device* d, DeviceMempool mp) {
+  DYNET_ASSERT(mp != DeviceMempool::PS && mp != DeviceMempool::NONE, "Bad memory pool requested from ExecutionContext");
+  auto & dp = device_pools[d];
+  if (dp.empty()) {
+    dp.push_back(new AlignedMemoryPool(d->name + " context forward memory", pool_size, d->mem));
+    dp.push_back(new AlignedMemoryPool(d->name + " context backward memory", pool_size, d->mem));
+    dp.push_back(nullptr);
+    dp.push_back(new AlignedMemoryPool(d->name + " context scratch memory", pool_size, d->mem));
+  }
+  return dp[(int)mp];
+}
+
 #if HAVE_CUDA
 Device_GPU::Device_GPU(int my_id, const DeviceMempoolSizes & mbs, int device_id) :
   Device(my_id, DeviceType::GPU, &gpu_mem), cuda_device_id(device_id), gpu_mem(device_id) {
@@ -121,8 +188,9 @@ Device_GPU::Device_GPU(int my_id, const DeviceMempoolSizes & mbs, int device_id)
 Device_GPU::~Device_GPU() {}
 #endif
 
-Device_CPU::Device_CPU(int my_id, const DeviceMempoolSizes & mbs, bool shared) :
-  Device(my_id, DeviceType::CPU, &cpu_mem), shmem(mem) {
+Device_CPU::Device_CPU(int my_id, const DeviceMempoolSizes & mbs, bool shared, unsigned num_threads) :
+  Device(my_id, DeviceType::CPU, &cpu_mem), num_threads(num_threads), shmem(mem) {
+  DYNET_ARG_CHECK(num_threads > 0, "Device_CPU needs at least one thread");
   if (shared) shmem = new SharedAllocator();
   kSCALAR_MINUSONE = (float*) mem->malloc(sizeof(float));
   *kSCALAR_MINUSONE = -1;
@@ -132,8 +200,10 @@ Device_CPU::Device_CPU(int my_id, const DeviceMempoolSizes & mbs, bool shared) :
   *kSCALAR_ZERO = 0;
   name = "CPU";
 
-  // Initialize the Eigen device
-  edevice = new Eigen::DefaultDevice;
+  // Initialize the Eigen device, backed by a pool of intra-op threads
+  // (with a single thread, Eigen evaluates everything inline in the caller)
+  tpool = new Eigen::ThreadPool(num_threads);
+  edevice = new Eigen::ThreadPoolDevice(tpool, num_threads);
 
   // this is the big memory allocation.
   pools[0] = new AlignedMemoryPool("CPU forward memory", (mbs.used[0] << 20), &cpu_mem);
@@ -144,6 +214,14 @@ Device_CPU::Device_CPU(int my_id, const DeviceMempoolSizes & mbs, bool shared) :
 
 Device_CPU::~Device_CPU() {}
 
+void Device_CPU::parallel_for(size_t n, size_t item_size, const std::function<void(size_t, size_t)> & f) const {
+  if (n == 0) return;
+  if (num_threads == 1 || n == 1) { f(0, n); return; }
+  const double bytes = (double)item_size * sizeof(float);
+  edevice->parallelFor((Eigen::Index)n, Eigen::TensorOpCost(bytes, bytes, 4.0 * item_size),
+                       [&f](Eigen::Index begin, Eigen::Index end) { f((size_t)begin, (size_t)end); });
+}
+
 
 DeviceManager::DeviceManager() {}
 
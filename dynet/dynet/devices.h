@@ -4,12 +4,17 @@
 #include <unordered_map>
 #include <string>
 #include <exception>
+#include <functional>
+#include <random>
+#include <vector>
 #include "dynet/aligned-mem-pool.h"
 #include "dynet/cuda.h"
 #include "dynet/globals.h"
 
 namespace Eigen {
   struct DefaultDevice;
+  struct ThreadPoolDevice;
+  class ThreadPoolInterface;
   class CudaStreamDevice;
   struct GpuDevice;
 }
@@ -56,7 +61,25 @@ class Device {
   virtual DeviceMempoolSizes mark(ComputationGraph *cg);
   virtual void revert(const DeviceMempoolSizes & cp);
   void allocate_tensor(DeviceMempool mem_pool, Tensor & tensor);
+  /**
+   * \brief Memory pool used by the calling thread
+   * \details This is pools[mp], unless the thread has an active ExecutionContext,
+   *          which then provides the FXS, DEDFS and SCS pools (PS is always shared).
+   */
+  AlignedMemoryPool* pool(DeviceMempool mp);
+  /**
+   * \brief Scratch (SCS) memory for temporary calculations of the calling thread
+   * \details This is pool(SCS), except on the worker threads of a parallel
+   *          execution engine, which each get a private scratch pool so that
+   *          nodes running concurrently do not free each other's memory.
+   */
+  AlignedMemoryPool* scratch_pool();
+  // make sure that n private worker scratch pools exist (call from the main thread only)
+  void reserve_worker_scratch(unsigned n);
+  // declare the calling thread as worker id (-1 for none) of a parallel execution engine
+  static void set_scratch_worker(int id);
   std::vector<AlignedMemoryPool*> pools;
+  std::vector<AlignedMemoryPool*> worker_scratch;
 };
 
 #if HAVE_CUDA
@@ -78,14 +101,73 @@ class Device_GPU : public Device {
 
 class Device_CPU : public Device {
  public:
-  typedef Eigen::DefaultDevice EigenDevice;
-  explicit Device_CPU(int my_id, const DeviceMempoolSizes & mb, bool shared);
+  typedef Eigen::ThreadPoolDevice EigenDevice;
+  explicit Device_CPU(int my_id, const DeviceMempoolSizes & mb, bool shared, unsigned num_threads = 1);
   ~Device_CPU();
+  /**
+   * \brief Run f(begin, end) over sub-ranges of [0, n) on the intra-op thread pool
+   * \details Used to parallelise the per-column loops in CPU node implementations.
+   *          The work is only split when num_threads > 1 and the range is worth it.
+   *          Note: f must not evaluate expressions on edevice itself, use plain Eigen
+   *          (or Eigen::DefaultDevice) inside.
+   *
+   * \param n Number of items
+   * \param item_size Approximate number of floats read and written per item
+   * \param f Function called with half-open sub-ranges of [0, n)
+   */
+  void parallel_for(size_t n, size_t item_size, const std::function<void(size_t, size_t)> & f) const;
   CPUAllocator cpu_mem;
-  Eigen::DefaultDevice* edevice;
+  unsigned num_threads;
+  Eigen::ThreadPoolInterface* tpool;
+  Eigen::ThreadPoolDevice* edevice;
   MemAllocator* shmem;
 };
 
+/**
+ * \brief Per-thread memory and random engine for computation graphs
+ * \details By default, all computation graphs use the devices' own FXS, DEDFS
+ *          and SCS pools and the global random engine, which only allows one
+ *          live ComputationGraph per process. While an ExecutionContext is
+ *          active on a thread (see ExecutionContext::Scope), the graphs of that
+ *          thread allocate from the context's own pools instead, and stochastic
+ *          nodes draw from the context's random engine. Parameter memory (PS)
+ *          stays shared, so several threads, each with its own context, can run
+ *          inference concurrently against one ParameterCollection. Updating
+ *          the shared parameters from several threads is not supported.
+ */
+class ExecutionContext {
+ public:
+  /**
+   * \param random_seed Seed of the context's random engine (0 for a random seed)
+   * \param pool_mb Initial size (in MB) of each memory pool; pools grow on demand
+   */
+  explicit ExecutionContext(unsigned random_seed = 0, size_t pool_mb = 32);
+  ~ExecutionContext();
+  ExecutionContext(const ExecutionContext&) = delete;
+  ExecutionContext& operator=(const ExecutionContext&) = delete;
+
+  // the context active on the calling thread, nullptr if none
+  static ExecutionContext* current();
+  static void set_current(ExecutionContext* ctx);
+
+  // activates a context on the calling thread for the lifetime of the scope
+  class Scope {
+   public:
+    explicit Scope(ExecutionContext& ctx) : prev(current()) { set_current(&ctx); }
+    ~Scope() { set_current(prev); }
+   private:
+    ExecutionContext* prev;
+  };
+
+  // the context's pool of type mp on device d (created on first use)
+  AlignedMemoryPool* pool(Device* d, DeviceMempool mp);
+  std::mt19937 rndeng;
+
+ private:
+  size_t pool_size;
+  std::unordered_map<const Device*, std::vector<AlignedMemoryPool*>> device_pools;
+};
+
 class DeviceManager final {
  public:
   DeviceManager();
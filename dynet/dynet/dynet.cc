@@ -1,4 +1,5 @@
 #include <iomanip>
+#include <atomic>
 
 #include "dynet/dynet.h"
 
@@ -15,11 +16,16 @@ namespace dynet {
 float* kSCALAR_MINUSONE;
 float* kSCALAR_ONE;
 float* kSCALAR_ZERO;
-int n_hgs = 0;
-unsigned n_cumul_hgs = 0;
+// graphs are counted per thread, since each thread may have its own
+// ExecutionContext; graphs using the devices' shared memory are also counted
+// process-wide, as only one of them can be alive at a time
+thread_local int n_hgs = 0;
+thread_local unsigned current_graph_id = 0;
+std::atomic<unsigned> n_cumul_hgs(0);
+std::atomic<int> n_shared_memory_hgs(0);
 
 int get_number_of_active_graphs() {return n_hgs;};
-unsigned get_current_graph_id() {return n_cumul_hgs;};
+unsigned get_current_graph_id() {return current_graph_id;};
 
 Node::~Node() {}
 size_t Node::aux_storage_size() const { return 0; }
@@ -110,40 +116,47 @@ void Node::autobatch_reshape_concatonly(const ComputationGraph & cg,
 ComputationGraph::ComputationGraph() {
   if(autobatch_flag) {
     ee.reset(new BatchedExecutionEngine(*this));
+  } else if(graph_threads_flag > 1) {
+    ee.reset(new ParallelExecutionEngine(*this, graph_threads_flag));
   } else {
     ee.reset(new SimpleExecutionEngine(*this));
   }
-  if (n_hgs > 0) {
-    cerr << "Memory allocator assumes only a single ComputationGraph at a time.\n";
-    throw std::runtime_error("Attempted to create >1 CG");
-  }
-  ++n_hgs;
-  immediate_compute = false;
-  check_validity = false;
-  ++n_cumul_hgs;
-  graph_id = n_cumul_hgs;
+  register_graph();
 }
 
 ComputationGraph::ComputationGraph(bool batched) {
   if(batched) {
     ee.reset(new BatchedExecutionEngine(*this));
+  } else if(graph_threads_flag > 1) {
+    ee.reset(new ParallelExecutionEngine(*this, graph_threads_flag));
   } else {
     ee.reset(new SimpleExecutionEngine(*this));
   }
+  register_graph();
+}
+
+void ComputationGraph::register_graph() {
   if (n_hgs > 0) {
-    cerr << "Memory allocator assumes only a single ComputationGraph at a time.\n";
+    cerr << "Memory allocator assumes only a single ComputationGraph at a time (per thread).\n";
+    throw std::runtime_error("Attempted to create >1 CG");
+  }
+  shared_memory = (ExecutionContext::current() == nullptr);
+  if (shared_memory && n_shared_memory_hgs++ > 0) {
+    --n_shared_memory_hgs;
+    cerr << "Memory allocator assumes only a single ComputationGraph at a time, use one ExecutionContext per thread to run graphs concurrently.\n";
     throw std::runtime_error("Attempted to create >1 CG");
   }
   ++n_hgs;
   immediate_compute = false;
   check_validity = false;
-  ++n_cumul_hgs;
-  graph_id = n_cumul_hgs;
+  graph_id = ++n_cumul_hgs;
+  current_graph_id = graph_id;
 }
 
 ComputationGraph::~ComputationGraph() {
   this->clear();
   --n_hgs;
+  if (shared_memory) --n_shared_memory_hgs;
 }
 
 void ComputationGraph::clear() {
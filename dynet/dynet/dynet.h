@@ -30,6 +30,7 @@ extern float* kSCALAR_ZERO;
  * \ingroup compgraph
  * \brief Gets the number of active graphs
  * \details This is 0 or 1, you can't create more than one graph at once
+ *          (per thread, see ExecutionContext)
  * \return Number of active graphs
  */
 int get_number_of_active_graphs();
@@ -491,6 +492,10 @@ struct ComputationGraph {
   bool check_validity;
   VariableIndex add_function_node(Node *node);
   void set_dim_for_new_node(const VariableIndex& i);
+  // check and count a newly created graph
+  void register_graph();
+  // whether the graph uses the devices' own memory pools (no ExecutionContext)
+  bool shared_memory;
 
   std::vector<CGCheckpoint> checkpoints;
   CGCheckpoint _get_checkpoint();
@@ -620,6 +625,14 @@ struct Node {
    */
   virtual bool supports_multibatch() const { return false; }
 
+  /**
+   * \brief Whether forward repoints fx to existing memory instead of writing to it
+   * \details If true (e.g., for parameters that can be read in place), the
+   * execution engine does not allocate memory for fx before calling forward.
+   * \return Whether the value of this node aliases existing memory
+   */
+  virtual bool forward_aliases_value() const { return false; }
+
   /**
    * \brief Whether this node supports processing inputs/outputs on multiple
    * devices. \details DyNet will throw an error if you try to process inputs
@@ -628,6 +641,14 @@ struct Node {
    */
   virtual bool supports_multidevice() const { return false; }
 
+  /**
+   * \brief Whether forward draws from the global random engine
+   * \details Execution engines that run nodes concurrently keep these nodes in
+   * graph order, so that random draws stay reproducible for a given seed.
+   * \return Whether forward uses the random number generator
+   */
+  virtual bool is_stochastic() const { return false; }
+
   // perform the forward/backward passes in one or multiple calls
   /**
    * \brief perform the forward/backward passes in one or multiple calls
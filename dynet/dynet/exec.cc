@@ -2,6 +2,11 @@
 
 #include <unordered_map>
 #include <queue>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unsupported/Eigen/CXX11/ThreadPool>
 
 #include "dynet/param-nodes.h"
 #include "dynet/globals.h"
@@ -85,7 +90,7 @@ const Tensor& SimpleExecutionEngine::incremental_forward(VariableIndex i) {
   // free any old memory if this is a new CG
   if (num_nodes_evaluated == 0)
     for (Device* dev : device_manager->get_devices())
-      dev->pools[(int)DeviceMempool::FXS]->free();
+      dev->pool(DeviceMempool::FXS)->free();
 
   if (i >= num_nodes_evaluated) {
     nfxs.resize(i + 1);
@@ -98,46 +103,8 @@ const Tensor& SimpleExecutionEngine::incremental_forward(VariableIndex i) {
         current_node_name = "fwd " + node->as_dummy_string();
         timer.start(current_node_name);
       }
-      xs.resize(node->arity());
-      unsigned ai = 0;
-      for (VariableIndex arg : node->args) {
-        xs[ai] = &nfxs[arg];
-        DYNET_ARG_CHECK(xs[ai]->device == node->device ||
-            node->supports_multidevice(),
-            "Attempt to do tensor forward in different devices (nodes " <<
-            arg << " and " << num_nodes_evaluated << ")");
-        ++ai;
-      }
-      auto& node_fx = nfxs[num_nodes_evaluated];
-      node_fx.d = node->dim;
-      // Get the device
-      DYNET_ASSERT(node->device != nullptr,
-          "Attempt to access null device in "
-          "SimpleExecutionEngine::incremental_forward");
-      node_fx.device = node->device;
-      node_fx.mem_pool = DeviceMempool::FXS;
-      // Get the memory to store f(xs)
-      auto& node_fx_pools = node_fx.device->pools;
-      node_fx.v = static_cast<float*>(
-          node_fx_pools[(int)DeviceMempool::FXS]->allocate(
-              node->dim.size() * sizeof(float)));
-      if (node_fx.v == nullptr)
-        DYNET_RUNTIME_ERR("Ran out of memory when executing node " <<
-                          num_nodes_evaluated);
-      void* aux_mem = nullptr;
-      // Is the node requesting extra memory?
-      size_t aux_size = node->aux_storage_size();
-      if (aux_size) {
-        aux_mem = node_fx_pools[(int)DeviceMempool::FXS]->allocate(aux_size);
-        if (aux_mem == nullptr)
-          DYNET_RUNTIME_ERR("Ran out of auxiliary memory when executing node "
-                            << num_nodes_evaluated);
-      }
-      node->aux_mem = aux_mem;
-
-      // Compute f(xs) and store to node_fx.
-      node->forward(xs, node_fx);
-
+      allocate_value(num_nodes_evaluated);
+      forward_node(num_nodes_evaluated, xs);
       if (profiling_flag) { timer.stop(current_node_name); }
     }
   }
@@ -145,6 +112,56 @@ const Tensor& SimpleExecutionEngine::incremental_forward(VariableIndex i) {
   return nfxs[i];
 }
 
+void SimpleExecutionEngine::allocate_value(VariableIndex ni) {
+  const Node* node = cg.nodes[ni];
+  auto& node_fx = nfxs[ni];
+  node_fx.d = node->dim;
+  // Get the device
+  DYNET_ASSERT(node->device != nullptr,
+      "Attempt to access null device in "
+      "SimpleExecutionEngine::incremental_forward");
+  node_fx.device = node->device;
+  node_fx.mem_pool = DeviceMempool::FXS;
+  // Get the memory to store f(xs), unless forward points to existing memory
+  AlignedMemoryPool* fxs_pool = node_fx.device->pool(DeviceMempool::FXS);
+  if (node->forward_aliases_value()) {
+    node_fx.v = nullptr;
+  } else {
+    node_fx.v = static_cast<float*>(
+        fxs_pool->allocate(
+            node->dim.size() * sizeof(float)));
+    if (node_fx.v == nullptr)
+      DYNET_RUNTIME_ERR("Ran out of memory when executing node " << ni);
+  }
+  void* aux_mem = nullptr;
+  // Is the node requesting extra memory?
+  size_t aux_size = node->aux_storage_size();
+  if (aux_size) {
+    aux_mem = fxs_pool->allocate(aux_size);
+    if (aux_mem == nullptr)
+      DYNET_RUNTIME_ERR("Ran out of auxiliary memory when executing node "
+                        << ni);
+  }
+  node->aux_mem = aux_mem;
+}
+
+void SimpleExecutionEngine::forward_node(VariableIndex ni,
+                                         vector<const Tensor*>& xs) {
+  const Node* node = cg.nodes[ni];
+  xs.resize(node->arity());
+  unsigned ai = 0;
+  for (VariableIndex arg : node->args) {
+    xs[ai] = &nfxs[arg];
+    DYNET_ARG_CHECK(xs[ai]->device == node->device ||
+        node->supports_multidevice(),
+        "Attempt to do tensor forward in different devices (nodes " <<
+        arg << " and " << ni << ")");
+    ++ai;
+  }
+  // Compute f(xs) and store to node_fx.
+  node->forward(xs, nfxs[ni]);
+}
+
 void SimpleExecutionEngine::backward(bool full) {
   DYNET_ASSERT(nfxs.size() >= cg.nodes.size(),
                "Mismatched array sizes in SimpleExecutionEngine::backward");
@@ -152,6 +169,35 @@ void SimpleExecutionEngine::backward(bool full) {
 }
 
 void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
+  vector<bool> needs_derivative;
+  allocate_gradients(from_where, full, needs_derivative);
+
+  // Loop in reverse topological order (nodes stored in topological order),
+  // considering only nodes that participate in the computation.
+  const unsigned num_nodes = from_where + 1;
+  vector<bool> in_computation(num_nodes, false);
+  in_computation[num_nodes - 1] = true;
+  vector<const Tensor*> xs(16);
+  string current_node_name;  // Optionally used for debugging (reused).
+  for (int i = num_nodes - 1; i >= 0; --i) {
+    if (!in_computation[i]) continue;
+    const Node* node = cg.nodes[i];
+    if (profiling_flag) {
+      current_node_name = "BWD " + node->as_dummy_string();
+      timer.start(current_node_name);
+    }
+    for (VariableIndex arg : node->args)
+      in_computation[arg] = true;
+    backward_node(i, needs_derivative, xs);
+    if (profiling_flag) { timer.stop(current_node_name); }
+  }
+
+  accumulate_parameter_gradients(from_where);
+}
+
+void SimpleExecutionEngine::allocate_gradients(VariableIndex from_where,
+                                               bool full,
+                                               vector<bool>& needs_derivative) {
   if (from_where >= nfxs.size()) { incremental_forward(from_where); }
   if (nfxs[from_where].d.size() != 1) {
     DYNET_INVALID_ARG(
@@ -163,7 +209,7 @@ void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
   ndEdfs.resize(num_nodes);
   const vector<Device*> &devices = device_manager->get_devices();
   for(Device* device : devices)
-    device->pools[(int)DeviceMempool::DEDFS]->free();
+    device->pool(DeviceMempool::DEDFS)->free();
 
   // This loop allocates memory on the appropriate devices for the nodes whose
   // derivatives will be computed.
@@ -174,7 +220,7 @@ void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
     node_dEdfx.device = nfxs[i].device;
     node_dEdfx.mem_pool = DeviceMempool::DEDFS;
     node_dEdfx.v = static_cast<float*>(
-        node_dEdfx.device->pools[(int)DeviceMempool::DEDFS]->allocate(
+        node_dEdfx.device->pool(DeviceMempool::DEDFS)->allocate(
             dim.size() * sizeof(float)));
     if (node_dEdfx.v == nullptr) {
       DYNET_RUNTIME_ERR(
@@ -184,7 +230,7 @@ void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
   }
   // Zero all derivative memory (which is contiguous on each device)
   for (Device* device : devices)
-    device->pools[(int)DeviceMempool::DEDFS]->zero_allocated_memory();
+    device->pool(DeviceMempool::DEDFS)->zero_allocated_memory();
 
   // initialize dE/dE = 1
   ndEdfs.back().v = cg.nodes.back()->device->kSCALAR_ONE;
@@ -195,7 +241,7 @@ void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
   //   2) it depends on a non-constant node
   // (thus, functions of constants and inputs end up being
   //  false in this computation)
-  vector<bool> needs_derivative(num_nodes, full);
+  needs_derivative.assign(num_nodes, full);
   if (!full) {
     for (auto i : cg.parameter_nodes)
       if (i <= from_where)
@@ -208,45 +254,36 @@ void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
       needs_derivative[ni] = nd;
     }
   }
+}
 
-  // Loop in reverse topological order (nodes stored in topological order),
-  // considering only nodes that participate in the computation.
-  vector<bool> in_computation(num_nodes, false);
-  in_computation[num_nodes - 1] = true;
-  vector<const Tensor*> xs(16);
-  string current_node_name;  // Optionally used for debugging (reused).
-  for (int i = num_nodes - 1; i >= 0; --i) {
-    if (!in_computation[i]) continue;
-    const Node* node = cg.nodes[i];
-    if (profiling_flag) {
-      current_node_name = "BWD " + node->as_dummy_string();
-      timer.start(current_node_name);
-    }
-    const auto& node_fx = nfxs[i];  // f(x_1, x_2, ..., x_arity), which
-                                    // was previously computed by forward.
-    const auto& node_dEdfx = ndEdfs[i];  // dE/df(x_1, x_2, ..., x_arity)
-    xs.resize(node->arity());
-    unsigned ai = 0;
-    for (VariableIndex arg : node->args) {
-      in_computation[arg] = true;
-      xs[ai] = &nfxs[arg];
-      ++ai;
-    }
-    ai = 0;
-    for (VariableIndex arg : node->args) {
-      if (needs_derivative[arg]) {
-        auto& node_dEdxai = ndEdfs[arg];  // where to store dE/dx_{ai}.
-        DYNET_ASSERT(node_fx.device == node_dEdfx.device,
-                     "Attempt to do tensor backward in different devices");
-        DYNET_ASSERT(node_fx.device == node_dEdxai.device,
-                     "Attempt to do tensor backward in different devices");
-        node->backward(xs, node_fx, node_dEdfx, ai, node_dEdxai);
-      }
-      ++ai;
+void SimpleExecutionEngine::backward_node(VariableIndex ni,
+                                          const vector<bool>& needs_derivative,
+                                          vector<const Tensor*>& xs) {
+  const Node* node = cg.nodes[ni];
+  const auto& node_fx = nfxs[ni];  // f(x_1, x_2, ..., x_arity), which
+                                   // was previously computed by forward.
+  const auto& node_dEdfx = ndEdfs[ni];  // dE/df(x_1, x_2, ..., x_arity)
+  xs.resize(node->arity());
+  unsigned ai = 0;
+  for (VariableIndex arg : node->args) {
+    xs[ai] = &nfxs[arg];
+    ++ai;
+  }
+  ai = 0;
+  for (VariableIndex arg : node->args) {
+    if (needs_derivative[arg]) {
+      auto& node_dEdxai = ndEdfs[arg];  // where to store dE/dx_{ai}.
+      DYNET_ASSERT(node_fx.device == node_dEdfx.device,
+                   "Attempt to do tensor backward in different devices");
+      DYNET_ASSERT(node_fx.device == node_dEdxai.device,
+                   "Attempt to do tensor backward in different devices");
+      node->backward(xs, node_fx, node_dEdfx, ai, node_dEdxai);
     }
-    if (profiling_flag) { timer.stop(current_node_name); }
+    ++ai;
   }
+}
 
+void SimpleExecutionEngine::accumulate_parameter_gradients(VariableIndex from_where) {
   // Accumulate gradients into parameters.
   for (VariableIndex i : cg.parameter_nodes) {
     if (i <= from_where) {
@@ -257,6 +294,168 @@ void SimpleExecutionEngine::backward(VariableIndex from_where, bool full) {
   backward_computed = from_where;
 }
 
+// The worker threads shared by all ParallelExecutionEngines
+static Eigen::ThreadPool* graph_thread_pool(unsigned num_threads) {
+  static std::mutex pool_mutex;
+  static std::unique_ptr<Eigen::ThreadPool> pool;
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  if (!pool)
+    pool.reset(new Eigen::ThreadPool(num_threads));
+  return pool.get();
+}
+
+bool ParallelExecutionEngine::runs_in_parallel(VariableIndex first,
+                                               VariableIndex last) const {
+  if (num_threads < 2 || profiling_flag || last <= first) return false;
+  for (VariableIndex ni = first; ni <= last; ++ni)
+    if (cg.nodes[ni]->device->type != DeviceType::CPU) return false;
+  return true;
+}
+
+void ParallelExecutionEngine::run_dag(
+    const vector<vector<unsigned>>& successors,
+    const vector<int>& pending,
+    const std::function<void(unsigned, vector<const Tensor*>&)>& f) {
+  Eigen::ThreadPool* pool = graph_thread_pool(num_threads);
+  for (Device* dev : device_manager->get_devices())
+    dev->reserve_worker_scratch(num_threads);
+
+  const unsigned n = pending.size();
+  unsigned num_tasks = 0;
+  vector<std::atomic<int>> counts(n);
+  for (unsigned k = 0; k < n; ++k) {
+    counts[k].store(pending[k]);
+    if (pending[k] >= 0) ++num_tasks;
+  }
+  Eigen::Barrier done(num_tasks);
+  // workers draw random numbers from the caller's execution context
+  ExecutionContext* context = ExecutionContext::current();
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  // run task k, then keep going with one of the successors it made ready and
+  // hand the others over to the pool (where idle workers steal them)
+  std::function<void(unsigned)> run = [&](unsigned k) {
+    Device::set_scratch_worker(pool->CurrentThreadId());
+    ExecutionContext::set_current(context);
+    vector<const Tensor*> xs(16);
+    while (true) {
+      if (!failed) {
+        try {
+          f(k, xs);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) error = std::current_exception();
+          failed = true;
+        }
+      }
+      int next = -1;
+      for (unsigned succ : successors[k]) {
+        if (counts[succ].fetch_sub(1) == 1) {
+          if (next >= 0) pool->Schedule([&run, next] { run(next); });
+          next = succ;
+        }
+      }
+      done.Notify();
+      if (next < 0) break;
+      k = next;
+    }
+  };
+  for (unsigned k = 0; k < n; ++k)
+    if (pending[k] == 0)
+      pool->Schedule([&run, k] { run(k); });
+  done.Wait();
+  if (error) std::rethrow_exception(error);
+}
+
+const Tensor& ParallelExecutionEngine::incremental_forward(VariableIndex i) {
+  DYNET_ASSERT(i < cg.nodes.size(),
+    "Out-of-bounds variable access in "
+    "ParallelExecutionEngine::incremental_forward()");
+  const VariableIndex first = num_nodes_evaluated;
+  if (i < first || !runs_in_parallel(first, i))
+    return SimpleExecutionEngine::incremental_forward(i);
+
+  // free any old memory if this is a new CG
+  if (first == 0)
+    for (Device* dev : device_manager->get_devices())
+      dev->pool(DeviceMempool::FXS)->free();
+
+  // allocate in graph order, exactly as the sequential engine does
+  nfxs.resize(i + 1);
+  for (VariableIndex ni = first; ni <= i; ++ni)
+    allocate_value(ni);
+
+  // a node is ready once its new arguments (and the previous stochastic node) are done
+  const unsigned n = i + 1 - first;
+  vector<vector<unsigned>> successors(n);
+  vector<int> pending(n, 0);
+  int last_stochastic = -1;
+  for (unsigned k = 0; k < n; ++k) {
+    const Node* node = cg.nodes[first + k];
+    for (VariableIndex arg : node->args) {
+      if (arg >= first) {
+        successors[arg - first].push_back(k);
+        ++pending[k];
+      }
+    }
+    if (node->is_stochastic()) {
+      if (last_stochastic >= 0) {
+        successors[last_stochastic].push_back(k);
+        ++pending[k];
+      }
+      last_stochastic = k;
+    }
+  }
+  run_dag(successors, pending, [&](unsigned k, vector<const Tensor*>& xs) {
+    forward_node(first + k, xs);
+  });
+  num_nodes_evaluated = i + 1;
+
+  return nfxs[i];
+}
+
+void ParallelExecutionEngine::backward(VariableIndex from_where, bool full) {
+  if (!runs_in_parallel(0, from_where)) {
+    SimpleExecutionEngine::backward(from_where, full);
+    return;
+  }
+  vector<bool> needs_derivative;
+  allocate_gradients(from_where, full, needs_derivative);
+
+  // a node is ready once all the nodes using it have added their contributions
+  // to its gradient; the users of an argument that needs a derivative are
+  // chained in reverse graph order, as in the sequential engine, so that the
+  // accumulation into its gradient is race-free and deterministic
+  const unsigned num_nodes = from_where + 1;
+  vector<bool> in_computation(num_nodes, false);
+  in_computation[from_where] = true;
+  vector<vector<unsigned>> successors(num_nodes);
+  vector<int> pending(num_nodes, 0);
+  vector<int> last_user(num_nodes, -1);
+  for (int ni = from_where; ni >= 0; --ni) {
+    if (!in_computation[ni]) { pending[ni] = -1; continue; }
+    for (VariableIndex arg : cg.nodes[ni]->args) {
+      in_computation[arg] = true;
+      successors[ni].push_back(arg);
+      ++pending[arg];
+      if (needs_derivative[arg]) {
+        if (last_user[arg] >= 0 && last_user[arg] != ni) {
+          successors[last_user[arg]].push_back(ni);
+          ++pending[ni];
+        }
+        last_user[arg] = ni;
+      }
+    }
+  }
+  run_dag(successors, pending, [&](unsigned k, vector<const Tensor*>& xs) {
+    backward_node(k, needs_derivative, xs);
+  });
+
+  accumulate_parameter_gradients(from_where);
+}
+
 // To minimize the number of host-to-device memory copies, we put a bunch of
 // data in contiguous memory. Since we need to pass both pointers and sizes,
 // we use this union.
@@ -273,7 +472,7 @@ void BatchedExecutionEngine::combine_tensors(
     const std::vector<VariableIndex>& batch_ids,
     int aid,
     Tensor &tout) {
-  AlignedMemoryPool *mempool = tout.device->pools[(int)DeviceMempool::FXS];
+  AlignedMemoryPool *mempool = tout.device->pool(DeviceMempool::FXS);
   // Determine needed memory for tout and get list of nodes corresponding to
   // specified argument.
   unsigned total_dsize = 0;
@@ -369,7 +568,7 @@ void BatchedExecutionEngine::accumulate_tensors(
       src += sz; // pointer arith
     }
     size_t req_sz = batch_ids.size() * 3 * sizeof(CopyArgs);
-    AlignedMemoryPool *mempool = tin.device->pools[(int)DeviceMempool::DEDFS];
+    AlignedMemoryPool *mempool = tin.device->pool(DeviceMempool::DEDFS);
     void* basemem = mempool->allocate(req_sz);
     float** srcs = static_cast<float**>(basemem);
     float** trgs = static_cast<float**>(basemem) + TRG;
@@ -448,7 +647,7 @@ void BatchedExecutionEngine::garbage_collect() {
     }
   }
   for (Device* dev : device_manager->get_devices())
-    dev->pools[(int)DeviceMempool::FXS]->free();
+    dev->pool(DeviceMempool::FXS)->free();
   batches.clear();
 }
 
@@ -712,13 +911,17 @@ const Tensor& BatchedExecutionEngine::incremental_forward_no_update(
         nfx.d = node->dim;
         nfx.device = node->device;
         nfx.mem_pool = DeviceMempool::FXS;
-        // Allocate memory
-        auto mempool = node->device->pools[(int)DeviceMempool::FXS];
-        nfx.v = static_cast<float*>(
-            mempool->allocate(node2size[curr_node] * sizeof(float)));
-        if (nfx.v == nullptr)
-          DYNET_RUNTIME_ERR("Ran out of memory when allocating for node "
-                            << curr_node);
+        // Allocate memory, unless forward points to existing memory
+        auto mempool = node->device->pool(DeviceMempool::FXS);
+        if (node->forward_aliases_value()) {
+          nfx.v = nullptr;
+        } else {
+          nfx.v = static_cast<float*>(
+              mempool->allocate(node2size[curr_node] * sizeof(float)));
+          if (nfx.v == nullptr)
+            DYNET_RUNTIME_ERR("Ran out of memory when allocating for node "
+                              << curr_node);
+        }
         const size_t aux_size = node->aux_storage_size();
         if (aux_size) {
           node->aux_mem = mempool->allocate(aux_size);
@@ -744,7 +947,7 @@ const Tensor& BatchedExecutionEngine::incremental_forward_no_update(
         }
 
         // Allocate main/auxiliary memory for the batch
-        auto mempool = node->device->pools[(int)DeviceMempool::FXS];
+        auto mempool = node->device->pool(DeviceMempool::FXS);
         float *head_main = static_cast<float*>(
             mempool->allocate(tot_main * sizeof(float)));
         if (head_main == nullptr)
@@ -923,14 +1126,14 @@ void BatchedExecutionEngine::backward(VariableIndex from_where, bool full) {
   vector<Tensor> batched_ndEdfs(num_batches);
   ndEdfs.resize(node2batch.size());
   for(Device* device : device_manager->get_devices())
-    device->pools[(int)DeviceMempool::DEDFS]->free();
+    device->pool(DeviceMempool::DEDFS)->free();
   for (unsigned i = 0; i < num_batches; ++i) {
     const auto & my_batch = batches[i];
     const auto & dim = my_batch.nfx.d;
     batched_ndEdfs[i].d = dim;
     batched_ndEdfs[i].device = cg.nodes[my_batch.ids[0]]->device;
     batched_ndEdfs[i].mem_pool = DeviceMempool::DEDFS;
-    batched_ndEdfs[i].v = static_cast<float*>(batched_ndEdfs[i].device->pools[(int)DeviceMempool::DEDFS]->allocate(dim.size() * sizeof(float)));
+    batched_ndEdfs[i].v = static_cast<float*>(batched_ndEdfs[i].device->pool(DeviceMempool::DEDFS)->allocate(dim.size() * sizeof(float)));
     if (!batched_ndEdfs[i].v)
       DYNET_RUNTIME_ERR("out of memory while attempting to allocate space for derivatives of node " << i);
     // Assign the memory within the batch
@@ -942,7 +1145,7 @@ void BatchedExecutionEngine::backward(VariableIndex from_where, bool full) {
     }
   }
   for(Device* device : device_manager->get_devices())
-    device->pools[(int)DeviceMempool::DEDFS]->zero_allocated_memory();
+    device->pool(DeviceMempool::DEDFS)->zero_allocated_memory();
 
   // initialize dE/dE = 1
   size_t final_size = batched_ndEdfs.back().d.size();
@@ -1041,15 +1244,15 @@ void BatchedExecutionEngine::backward(VariableIndex from_where, bool full) {
             // Non-contiguous
             Tensor my_ndEdf = *xs[ai];
             if (my_batch.concat[ai] == 1) {
-              size_t used = node->device->pools[(int)DeviceMempool::DEDFS]->used();
-              my_ndEdf.v = static_cast<float*>(batched_ndEdfs[i].device->pools[(int)DeviceMempool::DEDFS]->allocate(my_ndEdf.d.size() * sizeof(float)));
+              size_t used = node->device->pool(DeviceMempool::DEDFS)->used();
+              my_ndEdf.v = static_cast<float*>(batched_ndEdfs[i].device->pool(DeviceMempool::DEDFS)->allocate(my_ndEdf.d.size() * sizeof(float)));
               my_ndEdf.mem_pool = DeviceMempool::DEDFS;
               TensorTools::zero(my_ndEdf);
               node->backward(xs, my_batch.nfx, batched_ndEdfs[i], ai, my_ndEdf);
               // cerr << "noncontig backward[" << i << "](" << ai << ")->" << node2batch[arg] << " == "; for(auto id : my_batch.ids) cerr << " ndEdfs[" << cg.nodes[id]->args[ai] << "] == " << print_vec(as_vector(ndEdfs[cg.nodes[id]->args[ai]])); cerr << " + " << print_vec(as_vector(my_ndEdf)) << " == ";
               accumulate_tensors(my_ndEdf, my_batch.ids, ai);
               // for(auto id : my_batch.ids) cerr << " ndEdfs[" << cg.nodes[id]->args[ai] << "] == " << print_vec(as_vector(ndEdfs[cg.nodes[id]->args[ai]])); cerr << endl;
-              node->device->pools[(int)DeviceMempool::DEDFS]->set_used(used);
+              node->device->pool(DeviceMempool::DEDFS)->set_used(used);
             // Contiguous
             } else {
               VariableIndex aid = cg.nodes[my_batch.ids[0]]->args[ai];
@@ -1,6 +1,8 @@
 #ifndef DYNET_EXEC_H
 #define DYNET_EXEC_H
 
+#include <functional>
+
 #include "dynet/dynet.h"
 
 namespace dynet {
@@ -45,12 +47,55 @@ class SimpleExecutionEngine : public ExecutionEngine {
   const Tensor& get_gradient(VariableIndex i) override;
   void backward(bool full = false) override;
   void backward(VariableIndex from_where, bool full = false) override;
- private:
+ protected:
+  // allocate the value (and auxiliary memory) of node ni in FXS
+  void allocate_value(VariableIndex ni);
+  // compute the value of node ni, whose arguments must be available
+  void forward_node(VariableIndex ni, std::vector<const Tensor*>& xs);
+  // allocate and zero the gradients of nodes [0, from_where] in DEDFS, and
+  // find the nodes that need a derivative
+  void allocate_gradients(VariableIndex from_where, bool full,
+                          std::vector<bool>& needs_derivative);
+  // add the contributions of node ni to the gradients of its arguments
+  void backward_node(VariableIndex ni,
+                     const std::vector<bool>& needs_derivative,
+                     std::vector<const Tensor*>& xs);
+  void accumulate_parameter_gradients(VariableIndex from_where);
   std::vector<Tensor> nfxs;
   std::vector<Tensor> ndEdfs;
   VariableIndex num_nodes_evaluated;
 };
 
+/**
+ * \brief Execution engine that runs independent nodes concurrently
+ * \details Nodes are dispatched to a work-stealing thread pool as soon as
+ *          the nodes they depend on are done, in forward as well as backward.
+ *          Memory is still allocated in graph order before any node runs, so
+ *          FXS and DEDFS layouts are identical to the SimpleExecutionEngine.
+ *          Stochastic nodes run in graph order, and the contributions to the
+ *          gradient of a shared argument are added in the same (reverse graph)
+ *          order as the SimpleExecutionEngine, so results are reproducible.
+ *          Graphs on GPU devices, and profiling runs, are executed sequentially.
+ */
+class ParallelExecutionEngine : public SimpleExecutionEngine {
+ public:
+  explicit ParallelExecutionEngine(const ComputationGraph& cg, unsigned num_threads) :
+    SimpleExecutionEngine(cg), num_threads(num_threads) {}
+  using SimpleExecutionEngine::incremental_forward;
+  using SimpleExecutionEngine::backward;
+  const Tensor& incremental_forward(VariableIndex i) override;
+  void backward(VariableIndex from_where, bool full = false) override;
+ private:
+  // whether nodes [first, last] can run concurrently
+  bool runs_in_parallel(VariableIndex first, VariableIndex last) const;
+  // run f(k) for every task k with pending[k] >= 0, each one once its
+  // pending[k] predecessors have listed it in their successors and finished
+  void run_dag(const std::vector<std::vector<unsigned>>& successors,
+               const std::vector<int>& pending,
+               const std::function<void(unsigned, std::vector<const Tensor*>&)>& f);
+  unsigned num_threads;
+};
+
 struct BatchInfo {
 public:
   BatchInfo() : pseudo_node(nullptr) { }
@@ -48,9 +48,14 @@ Expression operator-(const Expression& x, const Expression& y) { return x + (-y)
 Expression operator-(real x, const Expression& y) { return Expression(y.pg, y.pg->add_function<ConstantMinusX>({y.i}, x)); }
 Expression operator-(const Expression& x, real y) { return -(y - x); }
 Expression operator*(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<MatrixMultiply>({x.i, y.i})); }
+Expression matmul_tn(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<MatrixTranspMultiply>({x.i, y.i})); }
+Expression matmul_nt(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<MatrixMultiplyTransp>({x.i, y.i})); }
 Expression operator*(const Expression& x, float y) { return Expression(x.pg, x.pg->add_function<ConstScalarMultiply>({x.i}, y)); }
 Expression cmult(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<CwiseMultiply>({x.i, y.i})); }
 Expression cdiv(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<CwiseQuotient>({x.i, y.i})); }
+Expression int8_matmul(const QuantizedMatrix& W, const Expression& x, const std::vector<unsigned>& rows) { return Expression(x.pg, x.pg->add_function<Int8AffineTransform>({x.i}, &W, rows)); }
+Expression int8_affine_transform(const Expression& b, const QuantizedMatrix& W, const Expression& x, const std::vector<unsigned>& rows) { return Expression(x.pg, x.pg->add_function<Int8AffineTransform>({x.i, b.i}, &W, rows)); }
+Expression feed_forward(const Expression& x, const Expression& W1, const Expression& b1, const Expression& W2, const Expression& b2, FeedForward::Activation activation, bool keep_hidden) { return Expression(x.pg, x.pg->add_function<FeedForward>({x.i, W1.i, b1.i, W2.i, b2.i}, activation, keep_hidden)); }
 Expression colwise_add(const Expression& x, const Expression& bias) { return Expression(x.pg, x.pg->add_function<AddVectorToAllColumns>({x.i, bias.i})); }
 Expression contract3d_1d_1d(const Expression& x, const Expression& y, const Expression& z) { return Expression(x.pg, x.pg->add_function<InnerProduct3D_1D_1D>({x.i, y.i, z.i})); }
 Expression contract3d_1d_1d(const Expression& x, const Expression& y, const Expression& z, const Expression& b) { return Expression(x.pg, x.pg->add_function<InnerProduct3D_1D_1D>({x.i, y.i, z.i, b.i})); }
@@ -97,6 +102,11 @@ Expression sparsemax(const Expression& x) { return Expression(x.pg, x.pg->add_fu
 Expression sparsemax_loss(const Expression& x, const vector<unsigned>& target_support) { return Expression(x.pg, x.pg->add_function<SparsemaxLoss>({x.i}, target_support)); }
 Expression sparsemax_loss(const Expression& x, const vector<unsigned>* ptarget_support) { return Expression(x.pg, x.pg->add_function<SparsemaxLoss>({x.i}, ptarget_support)); }
 Expression softmax(const Expression& x, unsigned d) { return Expression(x.pg, x.pg->add_function<Softmax>({x.i}, d)); }
+Expression masked_softmax(const Expression& x, const vector<unsigned>& key_lengths, const vector<unsigned>& query_lengths, bool causal) { return Expression(x.pg, x.pg->add_function<MaskedSoftmax>({x.i}, key_lengths, query_lengths, causal)); }
+Expression multi_head_attention(const Expression& q, const Expression& k, const Expression& v, unsigned nheads, float scale,
+                                bool causal, const vector<unsigned>& key_lengths, const vector<unsigned>& query_lengths, float dropout, unsigned block_size) {
+  return Expression(q.pg, q.pg->add_function<MultiHeadAttention>({q.i, k.i, v.i}, nheads, scale, causal, key_lengths, query_lengths, dropout, block_size));
+}
 Expression constrained_softmax(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<ConstrainedSoftmax>({x.i, y.i})); }
 Expression softsign(const Expression& x) { return Expression(x.pg, x.pg->add_function<SoftSign>({x.i})); }
 Expression pow(const Expression& x, const Expression& y) { return Expression(x.pg, x.pg->add_function<Pow>({x.i, y.i})); }
@@ -170,6 +180,7 @@ Expression pickneglogsoftmax(const Expression& x, unsigned v) { return Expressio
 Expression pickneglogsoftmax(const Expression& x, const vector<unsigned> & v) { return Expression(x.pg, x.pg->add_function<PickNegLogSoftmax>({x.i}, v)); }
 Expression pickneglogsoftmax(const Expression& x, const unsigned* pv) { return Expression(x.pg, x.pg->add_function<PickNegLogSoftmax>({x.i}, pv)); }
 Expression pickneglogsoftmax(const Expression& x, const vector<unsigned> * pv) { return Expression(x.pg, x.pg->add_function<PickNegLogSoftmax>({x.i}, pv)); }
+Expression softmax_cross_entropy(const Expression& x, const vector<unsigned> & targets, const vector<float> & mask, float smoothing) { return Expression(x.pg, x.pg->add_function<SoftmaxCrossEntropy>({x.i}, targets, mask, smoothing)); }
 
 Expression average_cols(const Expression& x) { return Expression(x.pg, x.pg->add_function<AverageColumns>({x.i})); }
 Expression sum_dim(const Expression& x, const vector<unsigned>& dims, bool b) { return Expression(x.pg, x.pg->add_function<SumDimension>({x.i}, dims, b)); }
@@ -214,6 +225,9 @@ Expression layer_norm(const Expression& x, const Expression& g, const Expression
     return cmult(g, cdiv(x_centered,sigma + 1e-8)) + b;
 }
 
+Expression layer_norm_colwise(const Expression& x, const Expression& g, const Expression& b, float epsilon) { return Expression(x.pg, x.pg->add_function<LayerNorm>({x.i, g.i, b.i}, epsilon)); }
+Expression residual_layer_norm_colwise(const Expression& x, const Expression& f, const Expression& g, const Expression& b, real p, bool dropout_colwise, float epsilon) { return Expression(x.pg, x.pg->add_function<LayerNorm>({x.i, g.i, b.i, f.i}, epsilon, p, dropout_colwise)); }
+
 Expression weight_norm(const Expression& w, const Expression& g){return Expression(w.pg, w.pg->add_function<WeightNormalization>({w.i,g.i}));}
 
 Expression vanilla_lstm_gates_concat(const std::vector<Expression>& x_t, const Expression& h_tm1, const Expression& Wx, const Expression& Wh, const Expression& b, real weightnoise_std){
@@ -30,6 +30,9 @@
 #include "dynet/nodes-minmax.h"
 #include "dynet/nodes-moments.h"
 #include "dynet/nodes-contract.h"
+#include "dynet/nodes-quantize.h"
+#include "dynet/nodes-attention.h"
+#include "dynet/nodes-feedforward.h"
 
 #include "dynet/devices.h"
 
@@ -591,6 +594,32 @@ Expression operator-(const Expression& x, real y);
  */
 Expression operator*(const Expression& x, const Expression& y);
 
+/**
+ * \ingroup arithmeticoperations
+ * \brief Matrix multiplication with a transposed left operand
+ * \details Calculates transpose(x) * y without materializing the transpose;
+ *          the first dimensions of x and y must match.
+ *
+ * \param x The left-hand matrix (transposed)
+ * \param y The right-hand matrix
+ *
+ * \return An expression transpose(x) times y
+ */
+Expression matmul_tn(const Expression& x, const Expression& y);
+
+/**
+ * \ingroup arithmeticoperations
+ * \brief Matrix multiplication with a transposed right operand
+ * \details Calculates x * transpose(y) without materializing the transpose;
+ *          the second dimensions of x and y must match.
+ *
+ * \param x The left-hand matrix
+ * \param y The right-hand matrix (transposed)
+ *
+ * \return An expression x times transpose(y)
+ */
+Expression matmul_nt(const Expression& x, const Expression& y);
+
 /**
  * \ingroup arithmeticoperations
  * \brief Matrix-scalar multiplication
@@ -646,6 +675,73 @@ inline Expression affine_transform(const std::initializer_list<Expression>& xs)
 template <typename T>
 inline Expression affine_transform(const T& xs) { return detail::f<AffineTransform>(xs); }
 
+/**
+ * \ingroup arithmeticoperations
+ * \brief Affine transform with a transposed weight matrix
+ * \details Calculates b + transpose(W) * z, passing the transpose directly to
+ *          the matrix multiply. This is useful when W is stored in the opposite
+ *          orientation, e.g. an output layer tied to a (dim x vocab) embedding matrix.
+ *
+ * \param xs An initializer list containing exactly three expressions b, W and z
+ *
+ * \return An expression equal to: xs[0] + transpose(xs[1])*xs[2]
+ */
+inline Expression affine_transform_t(const std::initializer_list<Expression>& xs) { return detail::f<AffineTransformTransp>(xs); }
+template <typename T>
+inline Expression affine_transform_t(const T& xs) { return detail::f<AffineTransformTransp>(xs); }
+
+/**
+ * \ingroup arithmeticoperations
+ * \brief Int8 matrix multiplication
+ * \details Calculates W * x with W quantised ahead of time (int8, one scale per
+ *          row) and x quantised per column on the fly, accumulating in int32
+ *          and rescaling the result to fp32. For inference on CPU only: the
+ *          node has no backward pass.
+ *
+ * \param W The quantised weight matrix, which must outlive the graph
+ * \param x The input of dimension ((W.cols, N), B)
+ * \param rows Compute only these rows of W (e.g. a vocabulary shortlist); all rows if empty
+ *
+ * \return An expression equal to: W * x (restricted to rows)
+ */
+Expression int8_matmul(const QuantizedMatrix& W, const Expression& x, const std::vector<unsigned>& rows = {});
+
+/**
+ * \ingroup arithmeticoperations
+ * \brief Int8 affine transform
+ * \details Same as int8_matmul, with the bias added to every column of the result.
+ *
+ * \param b The bias, a vector of W.rows elements (restricted to rows along with W)
+ * \param W The quantised weight matrix, which must outlive the graph
+ * \param x The input of dimension ((W.cols, N), B)
+ * \param rows Compute only these rows of W and b; all rows if empty
+ *
+ * \return An expression equal to: b + W * x (restricted to rows)
+ */
+Expression int8_affine_transform(const Expression& b, const QuantizedMatrix& W, const Expression& x, const std::vector<unsigned>& rows = {});
+
+/**
+ * \ingroup arithmeticoperations
+ * \brief Position-wise feed-forward network
+ * \details Calculates W2 * act(W1 * x + b1) + b2 in one node. The columns of x are
+ *          processed in tiles small enough for their hidden activations to stay in
+ *          cache between the two matrix multiplies, so the (H x N) hidden layer is
+ *          never materialised as a graph node. Only implemented on CPU.
+ *
+ * \param x The input of dimension ((D, N), B)
+ * \param W1 The inner weight matrix of dimension (H, D)
+ * \param b1 The inner bias of dimension (H)
+ * \param W2 The outer weight matrix of dimension (D', H)
+ * \param b2 The outer bias of dimension (D')
+ * \param activation The hidden activation, FeedForward::RELU or FeedForward::SILU
+ * \param keep_hidden Keep the pre-activations (H x N floats) for backward; if false,
+ *                    backward recomputes them, which suits graphs that are rarely differentiated
+ *
+ * \return An expression of dimension ((D', N), B)
+ */
+Expression feed_forward(const Expression& x, const Expression& W1, const Expression& b1, const Expression& W2, const Expression& b2,
+                        FeedForward::Activation activation=FeedForward::RELU, bool keep_hidden=true);
+
 /**
  * \ingroup arithmeticoperations
  * \brief Sum
@@ -1289,6 +1385,58 @@ Expression colwise_add(const Expression& x, const Expression& bias);
  */
 Expression softmax(const Expression& x, unsigned d=0);
 
+/**
+ * \ingroup lossoperations
+ * \brief Masked softmax
+ * \details Column-wise softmax of attention scores restricted to the visible entries,
+ *          which are given by lengths rather than mask tensors. Batch element n sees the
+ *          first key_lengths[n % key_lengths.size()] rows of its columns, and its columns
+ *          from query_lengths[n % query_lengths.size()] on are empty (all 0). Taking the
+ *          lengths modulo their number lets B lengths apply to the (B * nheads) batch
+ *          elements of heads concatenated to the batch. Masked entries of the result are 0.
+ *
+ * \param x The scores, of dimension ((Lx, Ly), N)
+ * \param key_lengths Number of visible rows of each batch element (all rows if empty)
+ * \param query_lengths Number of non-empty columns of each batch element (all columns if empty)
+ * \param causal Column j only sees rows 0..j
+ *
+ * \return The probabilities, of dimension ((Lx, Ly), N)
+ */
+Expression masked_softmax(const Expression& x, const std::vector<unsigned>& key_lengths,
+                          const std::vector<unsigned>& query_lengths = {}, bool causal = false);
+
+/**
+ * \ingroup lossoperations
+ * \brief Multi-head attention
+ * \details Scaled dot-product attention over all heads in one node. Head h uses
+ *          rows [h*D/nheads, (h+1)*D/nheads) of q, k and v in place, so neither the
+ *          per-head slices nor the (Lx x Ly) score matrices become graph nodes.
+ *          For each head: A = softmax(scale * k_h^T q_h) over the visible keys
+ *          (softmax over keys, i.e. per column, masked as in masked_softmax), then y_h = v_h A.
+ *          Only the visible block of the scores is computed. With block_size > 0, keys are
+ *          processed in blocks with an online softmax when there are more than block_size of
+ *          them, so the (Lx x Ly) matrices are never stored: memory is O(L * block_size) per
+ *          head, and backward recomputes the scores of each block.
+ *          Only implemented on CPU.
+ *
+ * \param q The queries, of dimension ((D, Ly), B)
+ * \param k The keys, of dimension ((D, Lx), B)
+ * \param v The values, of dimension ((D, Lx), B)
+ * \param nheads The number of heads, which must divide D
+ * \param scale The factor applied to the scores (usually 1/sqrt(D/nheads))
+ * \param causal Query j only attends to keys 0..j (requires Lx == Ly)
+ * \param key_lengths Number of visible keys of each batch element (B or 1 values, all keys if empty)
+ * \param query_lengths Number of non-padding queries of each batch element (B or 1 values, all queries if empty); the output of the others is 0
+ * \param dropout Rate at which key positions are dropped from the probabilities of each head (inverted dropout)
+ * \param block_size Number of keys per block of the chunked computation (0: the full score matrices are used)
+ *
+ * \return The attention output of dimension ((D, Ly), B)
+ */
+Expression multi_head_attention(const Expression& q, const Expression& k, const Expression& v, unsigned nheads, float scale,
+                                bool causal = false, const std::vector<unsigned>& key_lengths = {},
+                                const std::vector<unsigned>& query_lengths = {}, float dropout = 0.f,
+                                unsigned block_size = 0);
+
 /**
  * \ingroup lossoperations
  * \brief Log softmax
@@ -1402,6 +1550,25 @@ Expression pickneglogsoftmax(const Expression& x, const std::vector<unsigned> &
  */
 Expression pickneglogsoftmax(const Expression& x, const std::vector<unsigned> * pv);
 
+/**
+ * \ingroup lossoperations
+ * \brief Fused softmax cross-entropy over a matrix of scores
+ * \details This function computes the (optionally label-smoothed and masked) negative log
+ *          likelihood of every column of ``x`` and sums the result, in a single node. It gives
+ *          the same value as summing ``pickneglogsoftmax`` over all columns and batch elements,
+ *          but neither the per-column expressions nor the log-probabilities are materialised.
+ *          With smoothing weight \f$\epsilon\f$ the loss of a column is
+ *          \f$(1-\epsilon)(-\log p_y) + \frac{\epsilon}{V-1}\sum_v -\log p_v\f$.
+ *
+ * \param x An expression with scores of dimension ((V, C), B)
+ * \param targets A size C*B vector of target indices, column c of batch element b at b*C+c
+ * \param mask A vector of per-column weights with the same layout as ``targets`` (e.g. 0 for padding), or empty for none
+ * \param smoothing The label smoothing weight \f$\epsilon\f$
+ *
+ * \return A scalar with the summed loss
+ */
+Expression softmax_cross_entropy(const Expression& x, const std::vector<unsigned> & targets, const std::vector<float> & mask = {}, float smoothing = 0.f);
+
 /**
  * \ingroup lossoperations
  * \brief Hinge loss
@@ -2414,6 +2581,42 @@ Expression trace_of_product(const Expression& x, const Expression& y);
  */
 Expression layer_norm(const Expression& x, const Expression& g, const Expression& b);
 
+/**
+ * \ingroup normoperations
+ * \brief Column-wise layer normalization
+ * \details Performs layer normalization (see layer_norm) on each column of x,
+ *          with the same gain and bias for all columns, in a single node.
+ *          Only the mean and standard deviation of each column are kept for
+ *          the backward pass.
+ *
+ * \param x Input expression of dimension ((n, m), B)
+ * \param g Gain (n elements, no batch dimension)
+ * \param b Bias (n elements, no batch dimension)
+ * \param epsilon Added to the standard deviation for numerical stability
+ * \return An expression of the same dimension as `x`
+ */
+Expression layer_norm_colwise(const Expression& x, const Expression& g, const Expression& b, float epsilon = 1e-8f);
+
+/**
+ * \ingroup normoperations
+ * \brief Column-wise layer normalization of a residual connection
+ * \details Calculates layer_norm_colwise(x + dropout(f), g, b) in a single node,
+ *          e.g. the epilogue of a transformer sub-layer f with input x. The sum
+ *          is never stored: only the dropout mask and the mean and standard
+ *          deviation of each column are kept for the backward pass.
+ *
+ * \param x Input expression of dimension ((n, m), B)
+ * \param f Residual input of the same dimension as `x`
+ * \param g Gain (n elements, no batch dimension)
+ * \param b Bias (n elements, no batch dimension)
+ * \param p Dropout rate applied to `f` (inverted dropout); none if 0
+ * \param dropout_colwise Use the same dropout mask for all columns (as dropout_dim(f, 1, p))
+ * \param epsilon Added to the standard deviation for numerical stability
+ * \return An expression of the same dimension as `x`
+ */
+Expression residual_layer_norm_colwise(const Expression& x, const Expression& f, const Expression& g, const Expression& b,
+                                       real p = 0.f, bool dropout_colwise = false, float epsilon = 1e-8f);
+
 /**
  * \ingroup normoperations
  * \brief Weight normalization
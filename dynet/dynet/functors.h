@@ -345,6 +345,22 @@ struct FSILUBackward {
   float beta;
 };
 
+// generator of the (key, query, batch) mask of MaskedSoftmax: 1 if visible, 0 if masked
+struct FLengthMask {
+  FLengthMask(const float* key_lengths, unsigned num_key_lengths, const float* query_lengths, unsigned num_query_lengths, bool causal)
+    : key_lengths(key_lengths), query_lengths(query_lengths), num_key_lengths(num_key_lengths), num_query_lengths(num_query_lengths), causal(causal) {}
+  template <typename Coords>
+  DYNET_DEVICE_FUNC inline float operator()(const Coords& c) const {
+    return ((num_key_lengths == 0 || c[0] < key_lengths[c[2] % num_key_lengths])
+            && (num_query_lengths == 0 || c[1] < query_lengths[c[2] % num_query_lengths])
+            && (!causal || c[0] <= c[1])) ? 1.f : 0.f;
+  }
+  const float* key_lengths;
+  const float* query_lengths;
+  unsigned num_key_lengths, num_query_lengths;
+  bool causal;
+};
+
 
 } // namespace dynet
 
@@ -9,6 +9,12 @@ Device* default_device = nullptr;
 float weight_decay_lambda;
 int autobatch_flag; 
 int profiling_flag = 0;
+int graph_threads_flag = 1;
 NamedTimer timer;
 
+std::mt19937& random_engine() {
+  ExecutionContext* ctx = ExecutionContext::current();
+  return ctx ? ctx->rndeng : *rndeng;
+}
+
 }
@@ -9,6 +9,8 @@ class Device;
 class NamedTimer;
 
 extern std::mt19937* rndeng;
+// random engine for the calling thread: that of its ExecutionContext, or *rndeng
+std::mt19937& random_engine();
 extern Device* default_device;
 extern NamedTimer timer; // debug timing in executors.
 
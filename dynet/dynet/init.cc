@@ -18,7 +18,7 @@ using namespace std;
 
 namespace dynet {
 
-DynetParams::DynetParams() : random_seed(0), mem_descriptor("512"), weight_decay(0), autobatch(0), profiling(0),
+DynetParams::DynetParams() : random_seed(0), mem_descriptor("512"), weight_decay(0), autobatch(0), profiling(0), cpu_threads(1), graph_threads(1),
   shared_parameters(false), ngpus_requested(false), ids_requested(false), cpu_requested(false), requested_gpus(-1)
 {
 #if HAVE_CUDA
@@ -93,6 +93,26 @@ DynetParams extract_dynet_params(int& argc, char**& argv, bool shared_parameters
         remove_args(argc, argv, argi, 2);
       }
     }
+    // Intra-op CPU threads
+    else if (arg == "--dynet-threads" || arg == "--dynet_threads") {
+      if ((argi + 1) >= argc) {
+        throw std::invalid_argument("[dynet] --dynet-threads expects an argument (the number of CPU threads per operation)");
+      } else {
+        string a2 = argv[argi + 1];
+        istringstream c(a2); c >> params.cpu_threads;
+        remove_args(argc, argv, argi, 2);
+      }
+    }
+    // Inter-op (graph) threads
+    else if (arg == "--dynet-graph-threads" || arg == "--dynet_graph_threads") {
+      if ((argi + 1) >= argc) {
+        throw std::invalid_argument("[dynet] --dynet-graph-threads expects an argument (the number of threads running independent nodes concurrently)");
+      } else {
+        string a2 = argv[argi + 1];
+        istringstream c(a2); c >> params.graph_threads;
+        remove_args(argc, argv, argi, 2);
+      }
+    }
     else if (arg == "--dynet-profiling" || arg == "--dynet_profiling") {
       string a2 = argv[argi + 1];
       istringstream c(a2); c >> params.profiling;
@@ -205,15 +225,25 @@ void initialize(DynetParams& params) {
     cerr << "[dynet] using profiling level " << params.profiling << endl;
   profiling_flag = params.profiling;
 
+  if (params.cpu_threads == 0)
+    throw std::invalid_argument("[dynet] --dynet-threads must be at least 1\n");
+  if (params.cpu_threads > 1)
+    cerr << "[dynet] using " << params.cpu_threads << " CPU threads" << endl;
+  if (params.graph_threads == 0)
+    throw std::invalid_argument("[dynet] --dynet-graph-threads must be at least 1\n");
+  if (params.graph_threads > 1)
+    cerr << "[dynet] running independent nodes on " << params.graph_threads << " threads" << endl;
+  graph_threads_flag = params.graph_threads;
+
   // Allocate memory
   cerr << "[dynet] allocating memory: " << params.mem_descriptor << "MB\n";
   int default_index = 0;
 
   Device *d;
   if (gpudevices.size()) {
-    d = new Device_CPU(device_manager->num_devices(), std::string("128"), params.shared_parameters);
+    d = new Device_CPU(device_manager->num_devices(), std::string("128"), params.shared_parameters, params.cpu_threads);
   } else {
-    d = new Device_CPU(device_manager->num_devices(), params.mem_descriptor, params.shared_parameters);
+    d = new Device_CPU(device_manager->num_devices(), params.mem_descriptor, params.shared_parameters, params.cpu_threads);
   }
   device_manager->add(d);
   default_device = device_manager->get(default_index);
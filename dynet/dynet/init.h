@@ -9,6 +9,7 @@ namespace dynet {
 extern float weight_decay_lambda;
 extern int autobatch_flag;
 extern int profiling_flag;
+extern int graph_threads_flag;
 
 /**
  * \brief Represents general parameters for dynet
@@ -22,6 +23,8 @@ struct DynetParams {
   float weight_decay; /**< Weight decay rate for L2 regularization */
   int autobatch; /**< Whether to autobatch or not */
   int profiling; /**< Whether to show autobatch debug info or not */
+  unsigned cpu_threads; /**< Number of intra-op threads used by the CPU device */
+  unsigned graph_threads; /**< Number of threads running independent nodes of a graph concurrently */
   bool shared_parameters; /**< TO DOCUMENT */
   bool ngpus_requested; /**< GPUs requested by number */
   bool ids_requested; /**< GPUs requested by ids */
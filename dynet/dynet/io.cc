@@ -3,6 +3,15 @@
 #include "dynet/except.h"
 #include "dynet/str-util.h"
 
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 // Normally DyNet style permits using namespace std, but to make compatibility
 // possible with some external code, it is simpler if types are fully
 // qualified in dynet/io.cc. Please do not uncomment the following:
@@ -15,6 +24,9 @@
 static const int FLOAT32_PRECISION = 8;
 static const int FLOAT32_EXPONENT = 2;
 
+static const char BINARY_MAGIC[8] = {'D', 'Y', 'N', 'E', 'T', 'B', 'I', 'N'};
+static const uint32_t BINARY_VERSION = 1;
+
 namespace dynet {
 namespace {
 
@@ -50,6 +62,29 @@ void read_param_header(std::string line, std::string &type, std::string &name, D
   }
 }
 
+BinaryFileHeader make_binary_header(uint64_t num_entries, uint64_t index_offset) {
+  BinaryFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  header.version = BINARY_VERSION;
+  header.alignment = DYNET_BINARY_ALIGNMENT;
+  header.num_entries = num_entries;
+  header.index_offset = index_offset;
+  return header;
+}
+
+template <class T>
+void write_pod(std::ostream & os, const T & val) {
+  os.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+void write_padding(std::ostream & os) {
+  static const char zeros[DYNET_BINARY_ALIGNMENT] = {0};
+  size_t pos = static_cast<size_t>(os.tellp());
+  size_t pad = (DYNET_BINARY_ALIGNMENT - pos % DYNET_BINARY_ALIGNMENT) % DYNET_BINARY_ALIGNMENT;
+  os.write(zeros, pad);
+}
+
 } // anyonymous namespace
 
 Saver::~Saver() {}
@@ -331,4 +366,304 @@ LookupParameter TextFileLoader::load_lookup_param(ParameterCollection & model,
   DYNET_RUNTIME_ERR("Could not find key " << key << " in the model file");
 }
 
+bool is_binary_model_file(const std::string & filename) {
+  std::ifstream datastream(filename, std::ios_base::in | std::ios_base::binary);
+  char magic[sizeof(BINARY_MAGIC)];
+  if(!datastream.read(magic, sizeof(magic))) return false;
+  return std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+BinaryFileSaver::BinaryFileSaver(const std::string & filename) :
+        filename(filename),
+        datastream((filename + ".tmp").c_str(), std::ios_base::out | std::ios_base::binary) {
+  if(!datastream)
+    DYNET_RUNTIME_ERR("Could not write model to " << filename << ".tmp");
+  // Placeholder, filled in once the index has been written
+  write_pod(datastream, make_binary_header(0, 0));
+}
+
+BinaryFileSaver::~BinaryFileSaver() {
+  write_padding(datastream);
+  uint64_t index_offset = static_cast<uint64_t>(datastream.tellp());
+  for (auto & entry : index) {
+    write_pod(datastream, static_cast<uint32_t>(entry.is_lookup));
+    write_pod(datastream, static_cast<uint32_t>(entry.name.size()));
+    datastream.write(entry.name.data(), entry.name.size());
+    write_pod(datastream, static_cast<uint32_t>(entry.dim.nd));
+    for (unsigned i = 0; i < entry.dim.nd; ++i)
+      write_pod(datastream, static_cast<uint32_t>(entry.dim.d[i]));
+    write_pod(datastream, static_cast<uint32_t>(entry.dim.bd));
+    write_pod(datastream, entry.offset);
+  }
+  datastream.seekp(0);
+  write_pod(datastream, make_binary_header(index.size(), index_offset));
+  datastream.close();
+#ifdef _WIN32
+  // rename() does not replace an existing file there
+  std::remove(filename.c_str());
+#endif
+  // Destructors cannot throw, so a failed write or rename is only reported
+  if(!datastream || std::rename((filename + ".tmp").c_str(), filename.c_str()) != 0)
+    std::cerr << "Could not write model to " << filename << std::endl;
+}
+
+void BinaryFileSaver::save(const ParameterCollection & model,
+                           const std::string & key) {
+  if (!valid_pc_key(key))
+    DYNET_INVALID_ARG("Key should start with '/' and could not include ' ' or '#': " << key);
+  std::string key_ = key;
+  if (key_.size() != 0 && key_.back() != '/') key_ += "/";
+  const ParameterCollectionStorage & storage = model.get_storage();
+  if(key.size() == 0) {
+    for (auto & p : storage.params) save(*p, key);
+    for (auto & p : storage.lookup_params) save(*p, key);
+  } else {
+    size_t strip_size = model.get_fullname().size();
+    for (auto & p : storage.params)
+      save(*p, key_ + p->name.substr(strip_size));
+    for (auto & p : storage.lookup_params)
+      save(*p, key_ + p->name.substr(strip_size));
+  }
+}
+
+void BinaryFileSaver::save(const Parameter & param,
+                           const std::string & key) {
+  if (!valid_key(key))
+    DYNET_INVALID_ARG("Key could not include ' ' or '#': " << key);
+  save(*param.p, key);
+}
+
+void BinaryFileSaver::save(const LookupParameter & param,
+                           const std::string & key) {
+  if (!valid_key(key))
+    DYNET_INVALID_ARG("Key could not include ' ' or '#': " << key);
+  save(*param.p, key);
+}
+
+void BinaryFileSaver::save(const ParameterStorage & p,
+                           const std::string & key) {
+  write_values(p.values, false, (key.size() > 0 ? key : p.name), p.dim);
+}
+
+void BinaryFileSaver::save(const LookupParameterStorage & p,
+                           const std::string & key) {
+  write_values(p.all_values, true, (key.size() > 0 ? key : p.name), p.all_dim);
+}
+
+void BinaryFileSaver::write_values(const Tensor & values, bool is_lookup,
+                                   const std::string & name, const Dim & dim) {
+  write_padding(datastream);
+  BinaryIndexEntry entry;
+  entry.is_lookup = is_lookup;
+  entry.name = name;
+  entry.dim = dim;
+  entry.offset = static_cast<uint64_t>(datastream.tellp());
+  if(values.device->type == DeviceType::CPU) {
+    datastream.write(reinterpret_cast<const char*>(values.v), sizeof(float) * dim.size());
+  } else {
+    std::vector<float> host_values = dynet::as_vector(values);
+    datastream.write(reinterpret_cast<const char*>(host_values.data()), sizeof(float) * host_values.size());
+  }
+  if(!datastream)
+    DYNET_RUNTIME_ERR("Could not write values of " << name << " to the binary model file");
+  index.push_back(entry);
+}
+
+BinaryFileLoader::BinaryFileLoader(const std::string & filename, bool zero_copy) :
+        dataname(filename), zero_copy(zero_copy), mapping_size(0) {
+#ifdef _WIN32
+  std::ifstream datastream(filename, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+  if(!datastream) DYNET_RUNTIME_ERR("Could not read model from " << filename);
+  mapping_size = static_cast<size_t>(datastream.tellg());
+  datastream.seekg(0);
+  char* buffer = new char[mapping_size];
+  mapping.reset(buffer, [](void* ptr) { delete[] static_cast<char*>(ptr); });
+  if(!datastream.read(buffer, mapping_size))
+    DYNET_RUNTIME_ERR("Could not read model from " << filename);
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0) DYNET_RUNTIME_ERR("Could not read model from " << filename);
+  struct stat st;
+  if(fstat(fd, &st) != 0) {
+    close(fd);
+    DYNET_RUNTIME_ERR("Could not read model from " << filename);
+  }
+  mapping_size = static_cast<size_t>(st.st_size);
+  // A private mapping never modifies the file: pages are shared with the page
+  // cache and only copied if a parameter update writes to them.
+  void* addr = (mapping_size > 0 ?
+                mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) :
+                MAP_FAILED);
+  close(fd);
+  if(addr == MAP_FAILED) DYNET_RUNTIME_ERR("Could not map model file " << filename);
+  size_t size = mapping_size;
+  mapping.reset(addr, [size](void* ptr) { munmap(ptr, size); });
+#endif
+
+  const char* base = static_cast<const char*>(mapping.get());
+  if(mapping_size < sizeof(BinaryFileHeader))
+    DYNET_RUNTIME_ERR("Model file " << filename << " is too short to be a binary model file");
+  BinaryFileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if(std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0)
+    DYNET_RUNTIME_ERR("Model file " << filename << " is not a binary model file");
+  if(header.version != BINARY_VERSION)
+    DYNET_RUNTIME_ERR("Unsupported binary model file version " << header.version << " in " << filename);
+  if(header.index_offset < sizeof(BinaryFileHeader) || header.index_offset > mapping_size)
+    DYNET_RUNTIME_ERR("Corrupted or truncated binary model file " << filename);
+
+  // Read the index
+  const char* ptr = base + header.index_offset;
+  const char* end = base + mapping_size;
+  auto read_bytes = [&](void* dst, size_t n) {
+    if(static_cast<size_t>(end - ptr) < n)
+      DYNET_RUNTIME_ERR("Corrupted or truncated binary model file " << filename);
+    std::memcpy(dst, ptr, n);
+    ptr += n;
+  };
+  index.resize(header.num_entries);
+  for (auto & entry : index) {
+    uint32_t is_lookup, name_size, nd, d, bd;
+    read_bytes(&is_lookup, sizeof(is_lookup));
+    read_bytes(&name_size, sizeof(name_size));
+    entry.is_lookup = (is_lookup != 0);
+    entry.name.resize(name_size);
+    read_bytes(&entry.name[0], name_size);
+    read_bytes(&nd, sizeof(nd));
+    if(nd > DYNET_MAX_TENSOR_DIM)
+      DYNET_RUNTIME_ERR("Bad dimensions of " << entry.name << " in binary model file " << filename);
+    std::vector<long> dims(nd);
+    for (auto & dim : dims) { read_bytes(&d, sizeof(d)); dim = d; }
+    read_bytes(&bd, sizeof(bd));
+    entry.dim = Dim(dims, bd);
+    read_bytes(&entry.offset, sizeof(entry.offset));
+    if(entry.offset % DYNET_BINARY_ALIGNMENT != 0 ||
+       entry.offset + sizeof(float) * entry.dim.size() > header.index_offset)
+      DYNET_RUNTIME_ERR("Bad offset of " << entry.name << " in binary model file " << filename);
+  }
+}
+
+BinaryFileLoader::~BinaryFileLoader() {}
+
+const BinaryIndexEntry & BinaryFileLoader::find_entry(bool is_lookup,
+                                                      const std::string & key) const {
+  for (auto & entry : index)
+    if(entry.is_lookup == is_lookup && entry.name == key)
+      return entry;
+  DYNET_RUNTIME_ERR("Could not find key " << key << " in the model file");
+}
+
+float* BinaryFileLoader::entry_values(const BinaryIndexEntry & entry) const {
+  return reinterpret_cast<float*>(static_cast<char*>(mapping.get()) + entry.offset);
+}
+
+void BinaryFileLoader::copy_values(const BinaryIndexEntry & entry, Tensor & values) const {
+  const float* src = entry_values(entry);
+  if(values.device->type == DeviceType::CPU)
+    std::memcpy(values.v, src, sizeof(float) * entry.dim.size());
+  else
+    TensorTools::set_elements(values, std::vector<float>(src, src + entry.dim.size()));
+}
+
+void BinaryFileLoader::populate(ParameterCollection & model, const std::string & key) {
+  size_t param_id = 0, lookup_id = 0;
+  bool aliased = false;
+  ParameterCollectionStorage & storage = model.get_storage();
+  std::string key_ = key;
+  if (key_.size() != 0 && key_.back() != '/') key_ += "/";
+  for (auto & entry : index) {
+    // Skip ones that don't match
+    if(key.size() != 0 && entry.name.substr(0, key_.size()) != key_) {
+      continue;
+    // Load a parameter
+    } else if(!entry.is_lookup) {
+      if(param_id >= storage.params.size())
+        DYNET_RUNTIME_ERR("Too many parameters to load in populated model at " << entry.name);
+      ParameterStorage & param = *storage.params[param_id++];
+      if(param.dim != entry.dim)
+        DYNET_RUNTIME_ERR("Dimensions of parameter " << entry.name << " looked up from file (" << entry.dim <<
+                            ") do not match parameters to be populated (" << param.dim << ")");
+      if(zero_copy && param.values.device->type == DeviceType::CPU) {
+        param.values.v = entry_values(entry);
+        aliased = true;
+      } else {
+        copy_values(entry, param.values);
+      }
+      TensorTools::zero(param.g);
+    // Load a lookup parameter
+    } else {
+      if(lookup_id >= storage.lookup_params.size())
+        DYNET_RUNTIME_ERR("Too many lookup parameters in populated model at " << entry.name);
+      LookupParameterStorage & param = *storage.lookup_params[lookup_id++];
+      if(param.all_dim != entry.dim)
+        DYNET_RUNTIME_ERR("Dimensions of lookup parameter " << entry.name << " lookup up from file (" << entry.dim <<
+                            ") do not match parameters to be populated (" << param.all_dim << ")");
+      if(zero_copy && param.all_values.device->type == DeviceType::CPU) {
+        param.all_values.v = entry_values(entry);
+        size_t dim_size = param.dim.size();
+        for (size_t i = 0; i < param.values.size(); ++i)
+          param.values[i].v = param.all_values.v + i * dim_size;
+        aliased = true;
+      } else {
+        copy_values(entry, param.all_values);
+      }
+      TensorTools::zero(param.all_grads);
+    }
+  }
+  if(param_id != storage.params.size() || lookup_id != storage.lookup_params.size())
+    DYNET_RUNTIME_ERR("Number of parameter/lookup parameter objects loaded from file (" <<
+                      param_id << '/' << lookup_id << ") did not match number to be populated (" <<
+                      storage.params.size() << '/' << storage.lookup_params.size() << ')');
+  // The parameters now point into the mapping, so it must live as long as they do
+  if(aliased) storage.mapped_files.push_back(mapping);
+}
+
+void BinaryFileLoader::populate(Parameter & param,
+                                const std::string & key) {
+  if(key == "")
+    DYNET_INVALID_ARG("BinaryFileLoader.populate() requires non-empty key");
+  const BinaryIndexEntry & entry = find_entry(false, key);
+  if(param.p->dim != entry.dim)
+    DYNET_RUNTIME_ERR("Attempted to populate parameter where arguments don't match (" << param.p->dim << " != " << entry.dim << ")");
+  copy_values(entry, param.get_storage().values);
+  TensorTools::zero(param.get_storage().g);
+}
+
+void BinaryFileLoader::populate(LookupParameter & lookup_param,
+                                const std::string & key) {
+  if(key == "")
+    DYNET_INVALID_ARG("BinaryFileLoader.populate() requires non-empty key");
+  const BinaryIndexEntry & entry = find_entry(true, key);
+  if(lookup_param.p->all_dim != entry.dim)
+    DYNET_RUNTIME_ERR("Attempted to populate lookup parameter where arguments don't match (" << lookup_param.p->all_dim << " != " << entry.dim << ")");
+  copy_values(entry, lookup_param.get_storage().all_values);
+  TensorTools::zero(lookup_param.get_storage().all_grads);
+}
+
+Parameter BinaryFileLoader::load_param(ParameterCollection & model,
+                                       const std::string & key) {
+  if(key == "")
+    DYNET_INVALID_ARG("BinaryFileLoader.load_param() requires non-empty key");
+  const BinaryIndexEntry & entry = find_entry(false, key);
+  Parameter param = model.add_parameters(entry.dim);
+  param.get_storage().name = entry.name;
+  copy_values(entry, param.get_storage().values);
+  TensorTools::zero(param.get_storage().g);
+  return param;
+}
+
+LookupParameter BinaryFileLoader::load_lookup_param(ParameterCollection & model,
+                                                    const std::string & key) {
+  if(key == "")
+    DYNET_INVALID_ARG("BinaryFileLoader.load_lookup_param() requires non-empty key");
+  const BinaryIndexEntry & entry = find_entry(true, key);
+  Dim dim = entry.dim;
+  size_t size = dim[dim.nd-1]; dim.nd--;
+  LookupParameter lookup_param = model.add_lookup_parameters(size, dim);
+  lookup_param.get_storage().name = entry.name;
+  copy_values(entry, lookup_param.get_storage().all_values);
+  TensorTools::zero(lookup_param.get_storage().all_grads);
+  return lookup_param;
+}
+
 } // namespace dynet
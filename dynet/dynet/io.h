@@ -9,6 +9,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <iterator>
+#include <cstdint>
 
 #include "dynet/dim.h"
 #include "dynet/model.h"
@@ -173,6 +174,93 @@ class TextFileLoader : public Loader {
   std::string dataname;
 }; // class TextFileLoader
 
+/**
+ * Binary model file format
+ *
+ * The file starts with a fixed-size BinaryFileHeader, followed by the raw
+ * float32 values of each parameter (host byte order), each block starting at a
+ * multiple of DYNET_BINARY_ALIGNMENT bytes. An index describing every block
+ * (type, name, dimensions, offset) is written after the last block and
+ * located through BinaryFileHeader::index_offset. Gradients are not stored.
+ */
+#define DYNET_BINARY_ALIGNMENT 64
+
+struct BinaryFileHeader {
+  char magic[8]; /**< "DYNETBIN" */
+  uint32_t version;
+  uint32_t alignment;
+  uint64_t num_entries;
+  uint64_t index_offset;
+  char reserved[32];
+};
+
+struct BinaryIndexEntry {
+  bool is_lookup;
+  std::string name;
+  Dim dim;
+  uint64_t offset; /**< Byte offset of the values from the start of the file */
+};
+
+/**
+ * @brief Check whether a file starts with the binary model file header
+ */
+bool is_binary_model_file(const std::string & filename);
+
+class BinaryFileSaver : public Saver {
+ public:
+  BinaryFileSaver(const std::string & filename);
+  // Writes the index and fills in the header
+  ~BinaryFileSaver() override;
+  void save(const ParameterCollection & model,
+            const std::string & key = "") override;
+  void save(const Parameter & param, const std::string & key = "") override;
+  void save(const LookupParameter & param, const std::string & key = "") override;
+
+protected:
+  void save(const ParameterStorage & param, const std::string & key = "");
+  void save(const LookupParameterStorage & param, const std::string & key = "");
+  void write_values(const Tensor & values, bool is_lookup, const std::string & name, const Dim & dim);
+
+  // The model is written to filename + ".tmp" and renamed over filename once complete,
+  // so a model that is still mapped from filename is never truncated under its reader
+  std::string filename;
+  std::ofstream datastream;
+  std::vector<BinaryIndexEntry> index;
+
+}; // class BinaryFileSaver
+
+class BinaryFileLoader : public Loader {
+ public:
+  /**
+   * @brief Map a binary model file into memory
+   *
+   * @param filename: the file written by BinaryFileSaver
+   * @param zero_copy: when populating a ParameterCollection on the CPU, point the
+   *                   parameter values directly at the (copy-on-write) mapped pages
+   *                   instead of copying them. The mapping is then kept alive by the
+   *                   ParameterCollection.
+   */
+  BinaryFileLoader(const std::string & filename, bool zero_copy = true);
+  ~BinaryFileLoader() override;
+  void populate(ParameterCollection & model, const std::string & key = "") override;
+  void populate(Parameter & param, const std::string & key = "") override;
+  void populate(LookupParameter & lookup_param,
+                const std::string & key = "") override;
+  Parameter load_param(ParameterCollection & model, const std::string & key) override;
+  LookupParameter load_lookup_param(ParameterCollection & model, const std::string & key) override;
+
+ private:
+  const BinaryIndexEntry & find_entry(bool is_lookup, const std::string & key) const;
+  float* entry_values(const BinaryIndexEntry & entry) const;
+  void copy_values(const BinaryIndexEntry & entry, Tensor & values) const;
+
+  std::string dataname;
+  bool zero_copy;
+  std::shared_ptr<void> mapping;
+  size_t mapping_size;
+  std::vector<BinaryIndexEntry> index;
+}; // class BinaryFileLoader
+
 } // namespace dynet
 
 #endif
@@ -66,10 +66,45 @@ inline void MatrixMultiply(const Device_CPU & dev, const Tensor& l, const Tensor
 
 #endif
 
+#ifdef __CUDACC__
+inline void MatrixMultiplyAcc(const dynet::Device_GPU & dev, const dynet::Tensor& l, const dynet::Tensor& r, dynet::Tensor& y) {
+  // computes l * r
+  int max_b = std::max(std::max(l.d.bd, r.d.bd), y.d.bd);
+  // Do a single multiply if l has one batch
+  if(l.d.bd == 1 && y.d.bd == r.d.bd) {
+    CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_N, CUBLAS_OP_N,
+          y.d.rows(), y.d.cols()*y.d.batch_elems(), l.d.cols(),
+          dev.kSCALAR_ONE,
+          l.v, l.d.rows(),
+          r.v, r.d.rows(),
+          dev.kSCALAR_ONE, y.v, y.d.rows()));
+  } else {
+    for(int b = 0; b < max_b; ++b)
+      CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_N, CUBLAS_OP_N,
+            y.d.rows(), y.d.cols(), l.d.cols(),
+            dev.kSCALAR_ONE,
+            l.batch_ptr(b), l.d.rows(),
+            r.batch_ptr(b), r.d.rows(),
+            dev.kSCALAR_ONE, y.batch_ptr(b), y.d.rows()));
+  }
+}
+# else
+inline void MatrixMultiplyAcc(const dynet::Device_CPU & dev, const dynet::Tensor& l, const dynet::Tensor& r, dynet::Tensor& y) {
+  // computes l * r
+  int max_b = std::max(std::max(l.d.bd, r.d.bd), y.d.bd);
+  if(l.d.bd == 1 && y.d.bd == r.d.bd) {
+    y.colbatch_matrix().noalias() += *l * r.colbatch_matrix();
+  } else {
+    for(int b = 0; b < max_b; ++b)
+      y.batch_matrix(b).noalias() += l.batch_matrix(b) * r.batch_matrix(b);
+  }
+}
+#endif
+
 #ifdef __CUDACC__
 inline void MatrixTranspMultiplyAcc(const dynet::Device_GPU & dev, const dynet::Tensor& l, const dynet::Tensor& r, dynet::Tensor& y) {
   // computes l^T * r
-  int max_b = std::max(l.d.bd, r.d.bd);
+  int max_b = std::max(std::max(l.d.bd, r.d.bd), y.d.bd);
   // Do a single multiply if l has one batch
   if(l.d.bd == 1 && y.d.bd == r.d.bd) {
     CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_T, CUBLAS_OP_N,
@@ -92,7 +127,8 @@ inline void MatrixTranspMultiplyAcc(const dynet::Device_GPU & dev, const dynet::
 # else
 inline void MatrixTranspMultiplyAcc(const dynet::Device_CPU & dev, const dynet::Tensor& l, const dynet::Tensor& r, dynet::Tensor& y) {
   // computes l^T * r
-  int max_b = std::max(l.d.bd, r.d.bd);
+  // y can be batched when l and r are not (batched bias of affine_transform_t)
+  int max_b = std::max(std::max(l.d.bd, r.d.bd), y.d.bd);
   if(l.d.bd == 1 && y.d.bd == r.d.bd) {
     y.colbatch_matrix().noalias() += (*l).transpose() * r.colbatch_matrix();
   } else {
@@ -104,7 +140,7 @@ inline void MatrixTranspMultiplyAcc(const dynet::Device_CPU & dev, const dynet::
 
 #ifdef __CUDACC__
 inline void MatrixMultiplyTranspAcc(const dynet::Device_GPU & dev, const dynet::Tensor& l, const dynet::Tensor& r, dynet::Tensor& y) {
-  int max_b = std::max(l.d.bd, r.d.bd);
+  int max_b = std::max(std::max(l.d.bd, r.d.bd), y.d.bd);
   if(y.d.bd == 1 && (l.d.bd == r.d.bd)) {
     CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_N, CUBLAS_OP_T,
           y.d.rows(), y.d.cols(), l.d.cols() * l.d.batch_elems(),
@@ -124,7 +160,7 @@ inline void MatrixMultiplyTranspAcc(const dynet::Device_GPU & dev, const dynet::
 }
 # else
 inline void MatrixMultiplyTranspAcc(const dynet::Device_CPU & dev, const dynet::Tensor& l, const dynet::Tensor& r, dynet::Tensor& y) {
-  int max_b = std::max(l.d.bd, r.d.bd);
+  int max_b = std::max(std::max(l.d.bd, r.d.bd), y.d.bd);
   if(y.d.bd == 1 && (l.d.bd == r.d.bd)) {
     (*y).noalias() += l.colbatch_matrix() * r.colbatch_matrix().transpose();
   } else {
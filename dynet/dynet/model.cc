@@ -507,14 +507,24 @@ const ParameterCollectionStorage& ParameterCollection::get_storage() const {
   return *storage;
 }
 
-void save_dynet_model(std::string filename, ParameterCollection* model) {
-  TextFileSaver saver(filename);
-  saver.save(*model, "/model");
+void save_dynet_model(std::string filename, ParameterCollection* model, bool binary) {
+  if (binary) {
+    BinaryFileSaver saver(filename);
+    saver.save(*model, "/model");
+  } else {
+    TextFileSaver saver(filename);
+    saver.save(*model, "/model");
+  }
 };
 
 void load_dynet_model(std::string filename, ParameterCollection* model) {
-  TextFileLoader loader(filename);
-  loader.populate(*model, "/model");
+  if (is_binary_model_file(filename)) {
+    BinaryFileLoader loader(filename);
+    loader.populate(*model, "/model");
+  } else {
+    TextFileLoader loader(filename);
+    loader.populate(*model, "/model");
+  }
 };
 
 Model::Model() : ParameterCollection() {
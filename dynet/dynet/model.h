@@ -478,6 +478,7 @@ struct ParameterCollectionStorage {
 
   mutable float* gradient_norm_scratch;
   L2WeightDecay weight_decay;
+  std::vector<std::shared_ptr<void>> mapped_files; /**< Memory-mapped model files that parameter values point into */
 
  private:
   DeviceManager* const device_manager;
@@ -734,7 +735,8 @@ private:
   ParameterCollection * parent;
 }; // class ParameterCollection
 
-void save_dynet_model(std::string filename, ParameterCollection* model);
+void save_dynet_model(std::string filename, ParameterCollection* model, bool binary = false);
+// Reads either the text or the binary format, detected from the file header
 void load_dynet_model(std::string filename, ParameterCollection* model);
 
 class Model : public ParameterCollection {
@@ -71,6 +71,59 @@ std::vector<int> AffineTransform::autobatch_concat(const ComputationGraph & cg)
 
 #endif
 
+// Copies the bias b into fx, broadcasting it over columns and batches if necessary
+template<class MyDevice>
+static void affine_bias_forward(const MyDevice & dev, const Tensor& b, Tensor& fx) {
+  size_t b_size = b.d.size(), fx_size = fx.d.size();
+  if(fx_size == b_size) {
+    fx.tvec().device(*dev.edevice) = b.tvec();
+  } else {
+#ifdef __CUDACC__
+    Eigen::array<int, 3> bcast; bcast[0] = 1; bcast[1] = fx.d[1]/b.d[1]; bcast[2] = fx.d.bd/b.d.bd;
+    fx.tb<2>().device(*dev.edevice) = b.tb<2>().broadcast(bcast);
+#else
+    DYNET_ARG_CHECK(b.d.bd == 1, "In AffineTransform, broadcasting over columns with mini-batched inputs is not implemented yet");
+    float *curr_ptr = fx.v, *end_ptr = curr_ptr + fx.d.size(), *in_ptr = b.v;
+    do {
+      memcpy(curr_ptr, in_ptr, sizeof(float)*b_size);
+      curr_ptr += b_size;
+    } while(curr_ptr != end_ptr);
+#endif
+  }
+}
+
+// Accumulates the bias gradient, summing dEdf over broadcast columns and batches
+template<class MyDevice>
+static void affine_bias_backward(const MyDevice & dev, const Tensor& dEdf, Tensor& dEdxi) {
+  size_t dx_size = dEdxi.d.size(), df_size = dEdf.d.size();
+  if(dx_size == df_size) {
+    dEdxi.tvec().device(*dev.edevice) += dEdf.tvec();
+  } else {
+    DYNET_ARG_CHECK(dEdxi.d.bd == 1, "In AffineTransform, broadcasting over columns with mini-batched inputs is not implemented yet");
+#ifdef __CUDACC__
+    if(dEdxi.d[1] == dEdf.d[1]) {
+      Eigen::array<int, 1> red_axis; red_axis[0] = 2;
+      dEdxi.t<2>().device(*dev.edevice) += dEdf.tb<2>().sum(red_axis);
+    } else {
+      Eigen::array<int, 2> red_axis; red_axis[0] = 1; red_axis[1] = 2;
+      dEdxi.t<1>().device(*dev.edevice) += dEdf.tb<2>().sum(red_axis);
+    }
+#else
+    if(dEdxi.d[1] == dEdf.d[1]) {
+      for(unsigned b = 0; b < dEdf.d.bd; ++b)
+        (*dEdxi).noalias() += dEdf.batch_matrix(b);
+    } else {
+      Tensor mychip(dEdxi.d, dEdf.v, dEdf.device, dEdf.mem_pool);
+      size_t len = dEdf.d.bd * dEdf.d[1];
+      for(unsigned b = 0; b < len; ++b) {
+        (*dEdxi).noalias() += *mychip;
+        mychip.v += dx_size;
+      }
+    }
+#endif
+  }
+}
+
 // Affine transform uses different implementations for CPU and GPU because this is 
 // much faster than using Eigen's tensor contractions (as of the writing)
 template<class MyDevice>
@@ -81,22 +134,7 @@ void AffineTransform::forward_dev_impl(const MyDevice & dev, const vector<const
     return;
   } else {
     // Add the first matrix
-    size_t b_size = xs[0]->d.size(), fx_size = fx.d.size();
-    if(fx_size == b_size) {
-      fx.tvec().device(*dev.edevice) = xs[0]->tvec();
-    } else {
-#ifdef __CUDACC__
-      Eigen::array<int, 3> bcast; bcast[0] = 1; bcast[1] = fx.d[1]/xs[0]->d[1]; bcast[2] = fx.d.bd/xs[0]->d.bd;
-      fx.tb<2>().device(*dev.edevice) = xs[0]->tb<2>().broadcast(bcast);
-#else
-      DYNET_ARG_CHECK(xs[0]->d.bd == 1, "In AffineTransform, broadcasting over columns with mini-batched inputs is not implemented yet");
-      float *curr_ptr = fx.v, *end_ptr = curr_ptr + fx.d.size(), *in_ptr = xs[0]->v;
-      do {
-        memcpy(curr_ptr, in_ptr, sizeof(float)*b_size);
-        curr_ptr += b_size;
-      } while(curr_ptr != end_ptr);
-#endif
-    }
+    affine_bias_forward(dev, *xs[0], fx);
 
     // Perform multiplication
 #ifdef __CUDACC__
@@ -129,33 +167,7 @@ void AffineTransform::backward_dev_impl(const MyDevice & dev,
   DYNET_ASSERT(i < xs.size(), "Failed boundary check in AffineTransform::backward");
   // Bias term
   if (i == 0) { // bias term
-    size_t dx_size = dEdxi.d.size(), df_size = dEdf.d.size();
-    if(dx_size == df_size) {
-      dEdxi.tvec().device(*dev.edevice) += dEdf.tvec();
-    } else {
-      DYNET_ARG_CHECK(dEdxi.d.bd == 1, "In AffineTransform, broadcasting over columns with mini-batched inputs is not implemented yet");
-#ifdef __CUDACC__
-      if(dEdxi.d[1] == dEdf.d[1]) {
-        Eigen::array<int, 1> red_axis; red_axis[0] = 2;
-        dEdxi.t<2>().device(*dev.edevice) += dEdf.tb<2>().sum(red_axis);
-      } else {
-        Eigen::array<int, 2> red_axis; red_axis[0] = 1; red_axis[1] = 2;
-        dEdxi.t<1>().device(*dev.edevice) += dEdf.tb<2>().sum(red_axis);
-      }
-#else
-      if(dEdxi.d[1] == dEdf.d[1]) {
-        for(unsigned b = 0; b < dEdf.d.bd; ++b)
-          (*dEdxi).noalias() += dEdf.batch_matrix(b);
-      } else {
-        Tensor mychip(dEdxi.d, dEdf.v, dEdf.device, dEdf.mem_pool);
-        size_t len = dEdf.d.bd * dEdf.d[1];
-        for(unsigned b = 0; b < len; ++b) {
-          (*dEdxi).noalias() += *mychip;
-          mychip.v += dx_size;
-        }
-      }
-#endif
-    }
+    affine_bias_backward(dev, dEdf, dEdxi);
 
   // Left argument of matrix multiply
   } else if (i % 2 == 1) {
@@ -217,4 +229,55 @@ void AffineTransform::backward_dev_impl(const MyDevice & dev,
 }
 DYNET_NODE_INST_DEV_IMPL(AffineTransform)
 
+// ************* AffineTransformTransp *************
+
+#ifndef __CUDACC__
+
+string AffineTransformTransp::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << arg_names[0] << " + transpose(" << arg_names[1] << ") * " << arg_names[2];
+  return s.str();
+}
+
+Dim AffineTransformTransp::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 3, "Bad number of inputs in AffineTransformTransp: " << xs);
+  DYNET_ARG_CHECK(xs[0].rows() == xs[1].cols() && xs[1].rows() == xs[2].rows(),
+                          "Bad dimensions for AffineTransformTransp: " << xs);
+  DYNET_ARG_CHECK(xs[1].bd == 1 || xs[2].bd == 1 || xs[1].bd == xs[2].bd,
+                          "Number of batch elements in AffineTransformTransp must match: " << xs);
+  return (xs[2].cols() != 1 ?
+          Dim({xs[0].rows(), xs[2].cols()}, max(max(xs[0].bd, xs[1].bd), xs[2].bd)) :
+          Dim({xs[0].rows()}, max(max(xs[0].bd, xs[1].bd), xs[2].bd)));
+}
+
+#endif
+
+template<class MyDevice>
+void AffineTransformTransp::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+  DYNET_ASSERT(xs.size() == 3, "Failed dimension check in AffineTransformTransp::forward");
+  affine_bias_forward(dev, *xs[0], fx);
+  // fx += xs[1]^T * xs[2], with the transpose folded into the GEMM
+  MatrixTranspMultiplyAcc(dev, *xs[1], *xs[2], fx);
+}
+
+template<class MyDevice>
+void AffineTransformTransp::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+  DYNET_ASSERT(i < 3, "Failed boundary check in AffineTransformTransp::backward");
+  if (i == 0) {
+    affine_bias_backward(dev, dEdf, dEdxi);
+  } else if (i == 1) {
+    // dEdA += x_2 * dEdf^T
+    MatrixMultiplyTranspAcc(dev, *xs[2], dEdf, dEdxi);
+  } else {
+    // dEdx_2 += A * dEdf
+    MatrixMultiplyAcc(dev, *xs[1], dEdf, dEdxi);
+  }
+}
+DYNET_NODE_INST_DEV_IMPL(AffineTransformTransp)
+
 }
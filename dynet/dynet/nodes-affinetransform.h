@@ -23,6 +23,13 @@ struct AffineTransform : public Node {
   mutable float* dEdf_mem;
 };
 
+// y = x_1 + A^T * x_2
+struct AffineTransformTransp : public Node {
+  template <typename T> explicit AffineTransformTransp(const T& a) : Node(a) {}
+  virtual bool supports_multibatch() const override { return true; }
+  DYNET_NODE_DEFINE_DEV_IMPL()
+};
+
 } // namespace dynet
 
 #endif
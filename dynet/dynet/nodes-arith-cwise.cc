@@ -411,7 +411,7 @@ void CwiseQuotient::backward_helper(const MyDevice & dev,
       if(xs[0]->d[di]!=xs[1]->d[di]) bcast[di] = xs[0]->d[di];
     }
     if(xs[0]->d.bd!=xs[1]->d.bd) bcast[4] = xs[0]->d.bd;
-    AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+    AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
     Tensor xs1_squared(xs[1]->d, nullptr, fx.device, fx.mem_pool);
     xs1_squared.v = static_cast<float*>(scratch_allocator->allocate(xs1_squared.d.size() * sizeof(float)));
     xs1_squared.tb<4>().device(*dev.edevice) = xs[1]->tb<4>().square();
@@ -0,0 +1,270 @@
+#include "dynet/nodes-attention.h"
+
+#include "dynet/nodes-macros.h"
+
+using namespace std;
+
+namespace dynet {
+
+// ************* MultiHeadAttention *************
+
+#ifndef __CUDACC__
+
+string MultiHeadAttention::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "multi_head_attention(" << arg_names[0] << ", " << arg_names[1] << ", " << arg_names[2] << ", nheads=" << nheads << ", scale=" << scale;
+  if (causal) s << ", causal";
+  if (key_lengths.size()) s << ", key_lengths";
+  if (query_lengths.size()) s << ", query_lengths";
+  if (dropout > 0.f) s << ", dropout=" << dropout;
+  if (block_size > 0) s << ", block_size=" << block_size;
+  s << ')';
+  return s.str();
+}
+
+Dim MultiHeadAttention::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 3, "Failed input count check in MultiHeadAttention");
+  const Dim &q = xs[0], &k = xs[1], &v = xs[2];
+  DYNET_ARG_CHECK(q.nd <= 2 && k.nd <= 2 && v.nd <= 2 && q.rows() == k.rows()
+                  && k.rows() == v.rows() && k.cols() == v.cols() && q.bd == k.bd && k.bd == v.bd,
+                  "Bad input dimensions in MultiHeadAttention, expected q ((D, Ly), B), k and v ((D, Lx), B): " << xs);
+  DYNET_ARG_CHECK(nheads > 0 && q.rows() % nheads == 0,
+                  "Bad number of heads in MultiHeadAttention: " << nheads << " heads for dimension " << q.rows());
+  DYNET_ARG_CHECK(!causal || q.cols() == k.cols(), "Causal MultiHeadAttention requires as many keys as queries: " << xs);
+  DYNET_ARG_CHECK(dropout >= 0.f && dropout < 1.f, "Bad dropout rate in MultiHeadAttention: " << dropout);
+  DYNET_ARG_CHECK(key_lengths.size() <= q.bd && query_lengths.size() <= q.bd,
+                  "Too many lengths in MultiHeadAttention: " << key_lengths.size() << " key and " << query_lengths.size()
+                  << " query lengths for " << q.bd << " batch elements");
+  key_len = k.cols();
+  return Dim({q.rows(), q.cols()}, q.bd);
+}
+
+// aux_mem holds the dropout mask (Lx per (batch element, head)), then, per (batch element, head):
+// - materialised: the attention probabilities (Lx, Ly) and a matrix of the same size (dropped out probabilities
+//   in forward, scratch in backward)
+// - chunked: the log-normalisers of the softmax of each query (Ly)
+size_t MultiHeadAttention::aux_storage_size() const {
+  const size_t num_mats = (size_t)dim.bd * nheads;
+  const size_t per_mat = is_chunked(key_len) ? dim.cols() : 2 * key_len * dim.cols();
+  return (num_mats * per_mat + (dropout > 0.f ? num_mats * key_len : 0)) * sizeof(float);
+}
+
+#endif
+
+#ifndef __CUDACC__
+namespace {
+
+typedef Eigen::Map<Eigen::MatrixXf, Eigen::Unaligned, Eigen::OuterStride<>> StridedMap;
+typedef Eigen::Map<const Eigen::MatrixXf, Eigen::Unaligned, Eigen::OuterStride<>> ConstStridedMap;
+
+// rows [h*dk, (h+1)*dk) of batch element b of a ((D, L), B) tensor
+inline ConstStridedMap head_slice(const Tensor& x, unsigned b, unsigned h, unsigned dk) {
+  const unsigned D = x.d.rows(), L = x.d.cols();
+  return ConstStridedMap(x.v + (size_t)b * D * L + h * dk, dk, L, Eigen::OuterStride<>(D));
+}
+inline StridedMap head_slice(Tensor& x, unsigned b, unsigned h, unsigned dk) {
+  const unsigned D = x.d.rows(), L = x.d.cols();
+  return StridedMap(x.v + (size_t)b * D * L + h * dk, dk, L, Eigen::OuterStride<>(D));
+}
+
+// length of batch element b, at most l (l if there are no lengths)
+inline unsigned length_of(const vector<unsigned>& lengths, unsigned b, unsigned l) {
+  return lengths.empty() ? l : std::min(lengths[b % lengths.size()], l);
+}
+
+} // namespace
+#endif
+
+template<class MyDevice>
+void MultiHeadAttention::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+#ifdef __CUDACC__
+  DYNET_RUNTIME_ERR("MultiHeadAttention is not implemented on GPU");
+#else
+  const unsigned Ly = xs[0]->d.cols(), Lx = xs[1]->d.cols(), B = xs[0]->d.bd, dk = xs[0]->d.rows() / nheads;
+  const size_t mat_size = (size_t)Lx * Ly, num_mats = (size_t)B * nheads;
+  float* drop = (dropout > 0.f) ? (float*)aux_mem : nullptr;
+  float* mats = (float*)aux_mem + (drop ? num_mats * Lx : 0);
+  if (drop) {
+    Tensor m(Dim({Lx}, num_mats), drop, fx.device, DeviceMempool::FXS);
+    TensorTools::randomize_bernoulli(m, 1.f - dropout, 1.f / (1.f - dropout));
+  }
+  // (batch element, head) pairs are independent, so they are split over the intra-op threads
+  if (is_chunked(Lx)) {
+    // online softmax over blocks of keys: y_h accumulates v_h exp(scores - running max) and is rescaled whenever the
+    // running max of a query grows, then divided by the running sum at the end
+    float* logz = mats;
+    dev.parallel_for(num_mats, 2 * (size_t)block_size * Ly + 2 * dk * (Lx + Ly), [&](size_t begin, size_t end) {
+      Eigen::MatrixXf s(block_size, Ly);
+      Eigen::ArrayXf mx(Ly), sum(Ly);
+      for (size_t bh = begin; bh < end; ++bh) {
+        const unsigned b = bh / nheads, h = bh % nheads;
+        const unsigned nk = length_of(key_lengths, b, Lx), nq = length_of(query_lengths, b, Ly);
+        auto q = head_slice(*xs[0], b, h, dk);
+        StridedMap y = head_slice(fx, b, h, dk);
+        y.setZero();
+        mx.setConstant(-std::numeric_limits<float>::infinity());
+        sum.setZero();
+        for (unsigned k0 = 0; k0 < nk; k0 += block_size) {
+          const unsigned kb = std::min(block_size, nk - k0);
+          const unsigned c0 = causal ? k0 : 0;// causal: the queries before k0 see none of these keys
+          if (c0 >= nq) break;
+          const unsigned nc = nq - c0;
+          auto sb = s.topLeftCorner(kb, nc);
+          sb.noalias() = scale * (head_slice(*xs[1], b, h, dk).middleCols(k0, kb).transpose() * q.middleCols(c0, nc));
+          for (unsigned c = 0; c < nc; ++c) {
+            const unsigned j = c0 + c, n = causal ? std::min(j - k0 + 1, kb) : kb;
+            auto col = sb.col(c);
+            const float m = std::max(mx(j), col.head(n).maxCoeff());
+            const float rescale = std::exp(mx(j) - m);// 0 for the first block
+            col.head(n) = (col.head(n).array() - m).exp();
+            col.tail(kb - n).setZero();
+            sum(j) = sum(j) * rescale + col.head(n).sum();
+            mx(j) = m;
+            y.col(j) *= rescale;
+          }
+          if (drop)
+            sb.array().colwise() *= Eigen::Map<const Eigen::ArrayXf>(drop + bh * Lx + k0, kb);
+          y.middleCols(c0, nc).noalias() += head_slice(*xs[2], b, h, dk).middleCols(k0, kb) * sb;
+        }
+        float* lz = logz + bh * Ly;
+        for (unsigned j = 0; j < nq; ++j) {
+          if (sum(j) > 0.f) y.col(j) /= sum(j);// queries without visible keys keep 0
+          lz[j] = mx(j) + std::log(sum(j));
+        }
+      }
+    });
+    return;
+  }
+  float* probs = mats;
+  float* weights = probs + num_mats * mat_size;
+  dev.parallel_for(num_mats, 3 * mat_size + 2 * dk * (Lx + Ly), [&](size_t begin, size_t end) {
+    for (size_t bh = begin; bh < end; ++bh) {
+      const unsigned b = bh / nheads, h = bh % nheads;
+      const unsigned nk = length_of(key_lengths, b, Lx), nq = length_of(query_lengths, b, Ly);
+      // only the visible (nk, nq) block of the scores is computed, everything else is 0
+      Eigen::Map<Eigen::MatrixXf> p(probs + bh * mat_size, Lx, Ly);
+      p.setZero();
+      p.topLeftCorner(nk, nq).noalias() = scale * (head_slice(*xs[1], b, h, dk).leftCols(nk).transpose() * head_slice(*xs[0], b, h, dk).leftCols(nq));
+      // softmax over the (visible) keys of each query
+      for (unsigned c = 0; c < nq; ++c) {
+        const unsigned n = causal ? std::min(c + 1, nk) : nk;
+        if (n == 0) continue;
+        auto col = p.col(c);
+        const float m = col.head(n).maxCoeff();
+        col.head(n) = (col.head(n).array() - m).exp();
+        col.head(n) /= col.head(n).sum();
+        col.segment(n, nk - n).setZero();
+      }
+      Eigen::Map<Eigen::MatrixXf> w(weights + bh * mat_size, Lx, Ly);
+      w = p;
+      if (drop)
+        w.topRows(nk).array().colwise() *= Eigen::Map<const Eigen::ArrayXf>(drop + bh * Lx, nk);
+      StridedMap y = head_slice(fx, b, h, dk);
+      y.leftCols(nq).noalias() = head_slice(*xs[2], b, h, dk).leftCols(nk) * w.topLeftCorner(nk, nq);
+      y.rightCols(Ly - nq).setZero();
+    }
+  });
+#endif
+}
+
+template<class MyDevice>
+void MultiHeadAttention::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+#ifdef __CUDACC__
+  DYNET_RUNTIME_ERR("MultiHeadAttention is not implemented on GPU");
+#else
+  const unsigned Ly = xs[0]->d.cols(), Lx = xs[1]->d.cols(), B = xs[0]->d.bd, dk = xs[0]->d.rows() / nheads;
+  const size_t mat_size = (size_t)Lx * Ly, num_mats = (size_t)B * nheads;
+  const float* drop = (dropout > 0.f) ? (const float*)aux_mem : nullptr;
+  float* mats = (float*)aux_mem + (drop ? num_mats * Lx : 0);
+  if (is_chunked(Lx)) {
+    // the probabilities of each block of keys are recomputed from the scores and the log-normalisers
+    const float* logz = mats;
+    dev.parallel_for(num_mats, 3 * (size_t)block_size * Ly + 2 * dk * (Lx + Ly), [&](size_t begin, size_t end) {
+      Eigen::MatrixXf p(block_size, Ly), s(block_size, Ly);
+      Eigen::RowVectorXf dots(Ly);
+      for (size_t bh = begin; bh < end; ++bh) {
+        const unsigned b = bh / nheads, h = bh % nheads;
+        const unsigned nk = length_of(key_lengths, b, Lx), nq = length_of(query_lengths, b, Ly);
+        auto q = head_slice(*xs[0], b, h, dk);
+        auto dy = head_slice(dEdf, b, h, dk);
+        // sum_col(p .* dL/dp) = dL/dy_h . y_h column-wise (dropout included), so no full probability matrix is needed
+        if (i != 2)
+          dots.head(nq) = (dy.leftCols(nq).array() * head_slice(fx, b, h, dk).leftCols(nq).array()).colwise().sum();
+        const float* lz = logz + bh * Ly;
+        for (unsigned k0 = 0; k0 < nk; k0 += block_size) {
+          const unsigned kb = std::min(block_size, nk - k0);
+          const unsigned c0 = causal ? k0 : 0;
+          if (c0 >= nq) break;
+          const unsigned nc = nq - c0;
+          auto k = head_slice(*xs[1], b, h, dk).middleCols(k0, kb);
+          auto pb = p.topLeftCorner(kb, nc);
+          pb.noalias() = scale * (k.transpose() * q.middleCols(c0, nc));
+          for (unsigned c = 0; c < nc; ++c) {
+            const unsigned j = c0 + c, n = causal ? std::min(j - k0 + 1, kb) : kb;
+            auto col = pb.col(c);
+            col.head(n) = (col.head(n).array() - lz[j]).exp();
+            col.tail(kb - n).setZero();
+          }
+          auto sb = s.topLeftCorner(kb, nc);
+          auto dyb = dy.middleCols(c0, nc);
+          if (i == 2) {// dL/dv_h = dL/dy_h * w^T
+            sb = pb;
+            if (drop)
+              sb.array().colwise() *= Eigen::Map<const Eigen::ArrayXf>(drop + bh * Lx + k0, kb);
+            head_slice(dEdxi, b, h, dk).middleCols(k0, kb).noalias() += dyb * sb.transpose();
+            continue;
+          }
+          sb.noalias() = head_slice(*xs[2], b, h, dk).middleCols(k0, kb).transpose() * dyb;// dL/dw
+          if (drop)// dL/dp
+            sb.array().colwise() *= Eigen::Map<const Eigen::ArrayXf>(drop + bh * Lx + k0, kb);
+          sb.array().rowwise() -= dots.segment(c0, nc).array();
+          sb.array() *= pb.array();
+          if (i == 0)
+            head_slice(dEdxi, b, h, dk).middleCols(c0, nc).noalias() += scale * (k * sb);
+          else
+            head_slice(dEdxi, b, h, dk).middleCols(k0, kb).noalias() += scale * (q.middleCols(c0, nc) * sb.transpose());
+        }
+      }
+    });
+    return;
+  }
+  const float* probs = mats;
+  float* scratch = mats + num_mats * mat_size;
+  dev.parallel_for(num_mats, 4 * mat_size + 2 * dk * (Lx + Ly), [&](size_t begin, size_t end) {
+    for (size_t bh = begin; bh < end; ++bh) {
+      const unsigned b = bh / nheads, h = bh % nheads;
+      const unsigned nk = length_of(key_lengths, b, Lx), nq = length_of(query_lengths, b, Ly);
+      // masked probabilities are 0, so only the visible (nk, nq) block has gradients
+      auto p = Eigen::Map<const Eigen::MatrixXf>(probs + bh * mat_size, Lx, Ly).topLeftCorner(nk, nq);
+      auto s = Eigen::Map<Eigen::MatrixXf>(scratch + bh * mat_size, Lx, Ly).topLeftCorner(nk, nq);
+      auto dy = head_slice(dEdf, b, h, dk).leftCols(nq);
+      if (i == 2) {// dL/dv_h = dL/dy_h * w^T
+        s = p;
+        if (drop)
+          s.array().colwise() *= Eigen::Map<const Eigen::ArrayXf>(drop + bh * Lx, nk);
+        head_slice(dEdxi, b, h, dk).leftCols(nk).noalias() += dy * s.transpose();
+        continue;
+      }
+      s.noalias() = head_slice(*xs[2], b, h, dk).leftCols(nk).transpose() * dy;// dL/dw
+      if (drop)// dL/dp
+        s.array().colwise() *= Eigen::Map<const Eigen::ArrayXf>(drop + bh * Lx, nk);
+      // softmax backward: dL/da = p .* (dL/dp - sum_col(p .* dL/dp)); masked entries have p = 0
+      Eigen::RowVectorXf dots = (p.array() * s.array()).colwise().sum();
+      s.array().rowwise() -= dots.array();
+      s.array() *= p.array();
+      if (i == 0)
+        head_slice(dEdxi, b, h, dk).leftCols(nq).noalias() += scale * (head_slice(*xs[1], b, h, dk).leftCols(nk) * s);
+      else
+        head_slice(dEdxi, b, h, dk).leftCols(nk).noalias() += scale * (head_slice(*xs[0], b, h, dk).leftCols(nq) * s.transpose());
+    }
+  });
+#endif
+}
+DYNET_NODE_INST_DEV_IMPL(MultiHeadAttention)
+
+} // namespace dynet
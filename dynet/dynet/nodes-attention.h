@@ -0,0 +1,44 @@
+#ifndef DYNET_NODES_ATTENTION_H_
+#define DYNET_NODES_ATTENTION_H_
+
+#include "dynet/dynet.h"
+#include "dynet/nodes-macros.h"
+
+namespace dynet {
+
+// y = multi_head_attention(q, k, v)
+// q: ((D, Ly), B); k, v: ((D, Lx), B); head h works on rows [h*D/H, (h+1)*D/H) in place
+// for each head: A = softmax_col(scale * k_h^T q_h) over the visible keys, 0 elsewhere
+//                y_h = v_h A
+// batch element b only sees its first key_lengths[b % key_lengths.size()] keys (all if empty), and its
+// queries at positions >= query_lengths[b % query_lengths.size()] attend to nothing (output 0)
+// causal: query j only attends to keys 0..j (requires Lx == Ly)
+// the masks are applied from the lengths while computing the softmax, no mask tensors are needed
+// dropout drops key positions of each head (the same for all queries) with inverted scaling
+// block_size > 0 and Lx > block_size: keys are processed in blocks of block_size with an online softmax
+// (running max and sum per query), so only O(L * block_size) memory is used instead of O(Lx * Ly) per head,
+// and backward recomputes the scores of each block from the stored log-normalisers
+// CPU only
+struct MultiHeadAttention : public Node {
+  template <typename T>
+  explicit MultiHeadAttention(const T& a, unsigned nheads, float scale, bool causal,
+                              const std::vector<unsigned>& key_lengths, const std::vector<unsigned>& query_lengths, float dropout, unsigned block_size)
+    : Node(a), nheads(nheads), scale(scale), causal(causal), key_lengths(key_lengths), query_lengths(query_lengths), dropout(dropout),
+      block_size(block_size) {}
+  DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool supports_multibatch() const override { return true; }
+  size_t aux_storage_size() const override;
+  virtual bool is_stochastic() const override { return dropout > 0.f; }
+  bool is_chunked(unsigned Lx) const { return block_size > 0 && Lx > block_size; }
+  unsigned nheads;
+  float scale;
+  bool causal;
+  std::vector<unsigned> key_lengths, query_lengths;
+  float dropout;
+  unsigned block_size;
+  mutable unsigned key_len = 0;// Lx, recorded by dim_forward for aux_storage_size
+};
+
+} // namespace dynet
+
+#endif
@@ -92,7 +92,7 @@ void Conv2D::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>&
   DYNET_ASSERT(xs.size() == 2 || xs.size() == 3, "Failed dimension check in Conv2D::forward, at least 2 inputs");
   DYNET_ASSERT(fx.d.bd == xs[0]->d.bd, "Failed dimension check in Conv2D::forward, batchsize not match");
   DYNET_ASSERT(fx.d[2] == xs[1]->d[3], "Failed dimension check in Conv2D::forward, #channel not match");
-  AlignedMemoryPool* scratch_allocator = default_device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = default_device->scratch_pool();
 #ifdef __CUDACC__
 #if HAVE_CUDNN
   if (cudnn_conv_op_ == NULL)
@@ -142,7 +142,7 @@ void Conv2D::backward_dev_impl(const MyDevice & dev,
   DYNET_ASSERT(dEdf.d == fx.d, "Failed dimension check in Conv2D::backward");
   DYNET_ASSERT(dEdxi.d == xs[i]->d, "Failed dimension check in Conv2D::backward");
   DYNET_ASSERT(i <= 2, "Failed dimension check in Conv2D::backward");
-  AlignedMemoryPool* scratch_allocator = default_device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = default_device->scratch_pool();
 #ifdef __CUDACC__
 #if HAVE_CUDNN
   if (cudnn_conv_op_ == NULL)
@@ -10,6 +10,7 @@ namespace dynet {
 struct Dropout : public Node {
   explicit Dropout(const std::initializer_list<VariableIndex>& a, real p) : Node(a), p(p) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   size_t aux_storage_size() const override;
   virtual bool supports_multibatch() const override { return true; }
   real p;
@@ -19,6 +20,7 @@ struct Dropout : public Node {
 struct DropoutDim : public Node {
   explicit DropoutDim(const std::initializer_list<VariableIndex>& a, unsigned d,real p) : Node(a), dimension(d), p(p) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   size_t aux_storage_size() const override;
   virtual bool supports_multibatch() const override { return true; }
   unsigned dimension;
@@ -29,6 +31,7 @@ struct DropoutDim : public Node {
 struct DropoutBatch : public Node {
   explicit DropoutBatch(const std::initializer_list<VariableIndex>& a, real p) : Node(a), p(p) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   size_t aux_storage_size() const override;
   virtual bool supports_multibatch() const override { return true; }
   real p;
@@ -38,6 +41,7 @@ struct DropoutBatch : public Node {
 struct BlockDropout : public Node {
   explicit BlockDropout(const std::initializer_list<VariableIndex>& a, real p) : Node(a), dropout_probability(p) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   size_t aux_storage_size() const override;
   real dropout_probability;
 };
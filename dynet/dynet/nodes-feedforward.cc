@@ -0,0 +1,172 @@
+#include "dynet/nodes-feedforward.h"
+
+#include "dynet/nodes-macros.h"
+
+using namespace std;
+
+namespace dynet {
+
+// ************* FeedForward *************
+
+#ifndef __CUDACC__
+
+string FeedForward::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "feed_forward(" << arg_names[0] << ", " << arg_names[1] << ", " << arg_names[2] << ", " << arg_names[3] << ", " << arg_names[4]
+    << ", activation=" << (activation == RELU ? "relu" : "silu") << ')';
+  return s.str();
+}
+
+Dim FeedForward::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 5, "Failed input count check in FeedForward");
+  const Dim &x = xs[0], &W1 = xs[1], &b1 = xs[2], &W2 = xs[3], &b2 = xs[4];
+  DYNET_ARG_CHECK(x.nd <= 2 && W1.nd == 2 && W2.nd == 2 && W1.bd == 1 && b1.bd == 1 && W2.bd == 1 && b2.bd == 1
+                  && W1.cols() == x.rows() && W2.cols() == W1.rows()
+                  && b1.size() == W1.rows() && b1.cols() == 1 && b2.size() == W2.rows() && b2.cols() == 1,
+                  "Bad input dimensions in FeedForward, expected x ((D, N), B), W1 (H, D), b1 (H), W2 (D', H), b2 (D'): " << xs);
+  hidden_dim = W1.rows();
+  Dim d = x;
+  d.set(0, W2.rows());
+  return d;
+}
+
+// aux_mem holds the pre-activations (H, N x B) if keep_hidden is set
+size_t FeedForward::aux_storage_size() const {
+  return keep_hidden ? (size_t)hidden_dim * dim.cols() * dim.bd * sizeof(float) : 0;
+}
+
+#endif
+
+#ifndef __CUDACC__
+namespace {
+
+// hidden activations are computed for tiles of about this many floats (256KB), which stay in L2 cache
+const size_t kHiddenTileSize = 1 << 16;
+// hidden units handled together when computing parameter gradients
+const unsigned kHiddenRowBlock = 64;
+
+inline unsigned tile_cols(unsigned rows, unsigned ncols) {
+  return std::max(1u, std::min(ncols, (unsigned)(kHiddenTileSize / rows)));
+}
+
+// z <- act(z)
+inline void activate(Eigen::Ref<Eigen::MatrixXf> z, FeedForward::Activation act) {
+  if (act == FeedForward::RELU)
+    z = z.cwiseMax(0.f);
+  else// silu(z) = z * sigmoid(z)
+    z.array() /= 1.f + (-z.array()).exp();
+}
+
+// dh <- dh .* act'(z)
+inline void activate_backward(const Eigen::Ref<const Eigen::MatrixXf>& z, Eigen::Ref<Eigen::MatrixXf> dh, FeedForward::Activation act) {
+  if (act == FeedForward::RELU)
+    dh.array() *= (z.array() > 0.f).cast<float>();
+  else {// silu'(z) = s * (1 + z * (1 - s)), s = sigmoid(z)
+    Eigen::ArrayXXf s = (1.f + (-z.array()).exp()).inverse();
+    dh.array() *= s * (1.f + z.array() * (1.f - s));
+  }
+}
+
+} // namespace
+#endif
+
+template<class MyDevice>
+void FeedForward::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+#ifdef __CUDACC__
+  DYNET_RUNTIME_ERR("FeedForward is not implemented on GPU");
+#else
+  const unsigned D = xs[0]->d.rows(), N = xs[0]->d.cols() * xs[0]->d.bd, H = xs[1]->d.rows(), Do = xs[3]->d.rows();
+  Eigen::Map<const Eigen::MatrixXf> x(xs[0]->v, D, N), W1(xs[1]->v, H, D), W2(xs[3]->v, Do, H);
+  Eigen::Map<const Eigen::VectorXf> b1(xs[2]->v, H), b2(xs[4]->v, Do);
+  Eigen::Map<Eigen::MatrixXf> y(fx.v, Do, N);
+  float* zs = keep_hidden ? (float*)aux_mem : nullptr;
+  const unsigned T = tile_cols(H, N), ntiles = (N + T - 1) / T;
+  // column tiles are independent: each one goes through both layers while its hidden activations are in cache
+  dev.parallel_for(ntiles, (size_t)T * H * (D + Do) / 2, [&](size_t begin, size_t end) {
+    Eigen::MatrixXf buf(H, T);
+    for (size_t t = begin; t < end; ++t) {
+      const unsigned c0 = t * T, n = std::min(T, N - c0);
+      auto h = buf.leftCols(n);
+      h.noalias() = W1 * x.middleCols(c0, n);
+      h.colwise() += b1;
+      if (zs)
+        Eigen::Map<Eigen::MatrixXf>(zs + (size_t)c0 * H, H, n) = h;
+      activate(h, activation);
+      auto yt = y.middleCols(c0, n);
+      yt.noalias() = W2 * h;
+      yt.colwise() += b2;
+    }
+  });
+#endif
+}
+
+template<class MyDevice>
+void FeedForward::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+#ifdef __CUDACC__
+  DYNET_RUNTIME_ERR("FeedForward is not implemented on GPU");
+#else
+  const unsigned D = xs[0]->d.rows(), N = xs[0]->d.cols() * xs[0]->d.bd, H = xs[1]->d.rows(), Do = xs[3]->d.rows();
+  Eigen::Map<const Eigen::MatrixXf> x(xs[0]->v, D, N), W1(xs[1]->v, H, D), W2(xs[3]->v, Do, H), dy(dEdf.v, Do, N);
+  Eigen::Map<const Eigen::VectorXf> b1(xs[2]->v, H);
+  const float* zs = keep_hidden ? (const float*)aux_mem : nullptr;
+  // pre-activations of hidden units [r0, r0 + nr) for columns [c0, c0 + n), kept or recomputed
+  auto hidden = [&](unsigned r0, unsigned nr, unsigned c0, unsigned n, Eigen::Ref<Eigen::MatrixXf> z) {
+    if (zs)
+      z = Eigen::Map<const Eigen::MatrixXf>(zs, H, N).block(r0, c0, nr, n);
+    else {
+      z.noalias() = W1.middleRows(r0, nr) * x.middleCols(c0, n);
+      z.colwise() += b1.segment(r0, nr);
+    }
+  };
+  if (i == 0) {// dL/dx = W1^T (W2^T dL/dy .* act'(z)), split by column tiles
+    Eigen::Map<Eigen::MatrixXf> dx(dEdxi.v, D, N);
+    const unsigned T = tile_cols(H, N), ntiles = (N + T - 1) / T;
+    dev.parallel_for(ntiles, (size_t)T * H * (D + Do) / 2, [&](size_t begin, size_t end) {
+      Eigen::MatrixXf z(H, T), dh(H, T);
+      for (size_t t = begin; t < end; ++t) {
+        const unsigned c0 = t * T, n = std::min(T, N - c0);
+        hidden(0, H, c0, n, z.leftCols(n));
+        dh.leftCols(n).noalias() = W2.transpose() * dy.middleCols(c0, n);
+        activate_backward(z.leftCols(n), dh.leftCols(n), activation);
+        dx.middleCols(c0, n).noalias() += W1.transpose() * dh.leftCols(n);
+      }
+    });
+  } else if (i <= 3) {
+    // parameter gradients sum over all columns, so they are split by blocks of hidden units instead
+    const unsigned T = tile_cols(kHiddenRowBlock, N), nblocks = (H + kHiddenRowBlock - 1) / kHiddenRowBlock;
+    dev.parallel_for(nblocks, (size_t)kHiddenRowBlock * N * (D + Do) / 2, [&](size_t begin, size_t end) {
+      Eigen::MatrixXf z(kHiddenRowBlock, T), dh(kHiddenRowBlock, T);
+      for (size_t blk = begin; blk < end; ++blk) {
+        const unsigned r0 = blk * kHiddenRowBlock, nr = std::min(kHiddenRowBlock, H - r0);
+        for (unsigned c0 = 0; c0 < N; c0 += T) {
+          const unsigned n = std::min(T, N - c0);
+          auto zt = z.topLeftCorner(nr, n);
+          hidden(r0, nr, c0, n, zt);
+          if (i == 3) {// dL/dW2 = dL/dy act(z)^T
+            activate(zt, activation);
+            Eigen::Map<Eigen::MatrixXf>(dEdxi.v, Do, H).middleCols(r0, nr).noalias() += dy.middleCols(c0, n) * zt.transpose();
+            continue;
+          }
+          auto dht = dh.topLeftCorner(nr, n);
+          dht.noalias() = W2.middleCols(r0, nr).transpose() * dy.middleCols(c0, n);
+          activate_backward(zt, dht, activation);
+          if (i == 1)// dL/dW1 = dL/dz x^T
+            Eigen::Map<Eigen::MatrixXf>(dEdxi.v, H, D).middleRows(r0, nr).noalias() += dht * x.middleCols(c0, n).transpose();
+          else// dL/db1 = sum_col(dL/dz)
+            Eigen::Map<Eigen::VectorXf>(dEdxi.v, H).segment(r0, nr) += dht.rowwise().sum();
+        }
+      }
+    });
+  } else {// dL/db2 = sum_col(dL/dy)
+    Eigen::Map<Eigen::VectorXf>(dEdxi.v, Do) += dy.rowwise().sum();
+  }
+#endif
+}
+DYNET_NODE_INST_DEV_IMPL(FeedForward)
+
+} // namespace dynet
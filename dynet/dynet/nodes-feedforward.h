@@ -0,0 +1,31 @@
+#ifndef DYNET_NODES_FEEDFORWARD_H_
+#define DYNET_NODES_FEEDFORWARD_H_
+
+#include "dynet/dynet.h"
+#include "dynet/nodes-macros.h"
+
+namespace dynet {
+
+// y = feed_forward(x, W1, b1, W2, b2)
+// x: ((D, N), B); W1: (H, D); b1: (H); W2: (D', H); b2: (D')
+// y = W2 act(W1 x + b1) + b2, act = relu or silu
+// columns are processed in tiles whose (H x tile) hidden activations fit in cache, so
+// the hidden layer is never written out as a whole; if keep_hidden is set, the
+// pre-activations are kept in aux_mem for backward, otherwise backward recomputes them
+// CPU only
+struct FeedForward : public Node {
+  enum Activation { RELU, SILU };
+  template <typename T>
+  explicit FeedForward(const T& a, Activation activation, bool keep_hidden)
+    : Node(a), activation(activation), keep_hidden(keep_hidden) {}
+  DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool supports_multibatch() const override { return true; }
+  size_t aux_storage_size() const override;
+  Activation activation;
+  bool keep_hidden;
+  mutable unsigned hidden_dim = 0;// H, recorded by dim_forward for aux_storage_size
+};
+
+} // namespace dynet
+
+#endif
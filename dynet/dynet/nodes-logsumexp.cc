@@ -38,7 +38,7 @@ void LogSumExp::forward_dev_impl(const MyDevice & dev, const vector<const Tensor
   if (xs.size() == 1) {
     fx.tvec().device(*dev.edevice) = xs[0]->tvec();
   } else {
-    AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+    AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
     Tensor ms(fx.d, nullptr, fx.device, fx.mem_pool);
     ms.v = static_cast<float*>(scratch_allocator->allocate(ms.d.size() * sizeof(float)));
 
@@ -124,7 +124,7 @@ Dim LogSumExpDimension::dim_forward(const vector<Dim>& xs) const {
 template<class MyDevice>
 void LogSumExpDimension::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
   Tensor ms(fx.d, nullptr, fx.device, fx.mem_pool), zs(fx.d, nullptr, fx.device, fx.mem_pool);
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   ms.v = static_cast<float*>(scratch_allocator->allocate(ms.d.size() * sizeof(float)));
   TensorTools::logsumexp_dev(dev, *xs[0], ms, fx, dimension);
   scratch_allocator->free();
@@ -122,7 +122,7 @@ namespace dynet {
     Eigen::DSizes<ptrdiff_t, 2> sizes_1(hidden_dim, static_cast<ptrdiff_t>(fx.d.bd));
     Eigen::DSizes<ptrdiff_t, 2> sizes_3(hidden_dim*3, static_cast<ptrdiff_t>(fx.d.bd));
 
-    AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+    AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
 
     Tensor x_t(Dim({input_dim}, batch_size), nullptr, fx.device, fx.mem_pool);
     if(num_inputs==1){
@@ -272,7 +272,7 @@ namespace dynet {
     Eigen::array<int, 1> vec_batch_axis; vec_batch_axis[0] = 1;
     Eigen::array<int, 1> mat_batch_axis; mat_batch_axis[0] = 2;
 
-    AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+    AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
 
     // scratch memory to avoid striding for element-wise operations
     Tensor dEdf_ifo(Dim({hidden_dim*3, 1},batch_size), nullptr, fx.device, fx.mem_pool);
@@ -578,7 +578,7 @@ namespace dynet {
     Eigen::DSizes<ptrdiff_t, 2> indices_g(hidden_dim*3,0);
     Eigen::DSizes<ptrdiff_t, 2> sizes_1(hidden_dim, static_cast<ptrdiff_t>(fx.d.bd));
 
-    AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+    AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
     Tensor f_t(Dim({hidden_dim,1},batch_size), nullptr, fx.device, fx.mem_pool);
     f_t.v = static_cast<float*>(scratch_allocator->allocate(f_t.d.size() * sizeof(float)));
     f_t.tbvec().device(*dev.edevice) = gates_t->tbvec().slice(indices_f, sizes_1);
@@ -680,7 +680,7 @@ namespace dynet {
     Eigen::DSizes<ptrdiff_t, 3> indices_o(hidden_dim*2,0,0);
     Eigen::DSizes<ptrdiff_t, 3> sizes_1(hidden_dim, 1, static_cast<ptrdiff_t>(batch_size));
 
-    AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+    AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
 
     if(i==0){
       // dc_t = dh_t . o_t . (1 - tanh^2(c_t)))
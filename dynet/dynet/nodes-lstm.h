@@ -10,6 +10,7 @@ struct VanillaLSTMGates : public Node {
   explicit VanillaLSTMGates(const std::vector<VariableIndex>& a, bool dropout, real weightnoise_std)
 		: Node(a), dropout(dropout), weightnoise_std(weightnoise_std), forget_gate_bias(1.0) {}
   virtual bool supports_multibatch() const override { return true; }
+  virtual bool is_stochastic() const override { return weightnoise_std > 0.f; }
   virtual int autobatch_sig(const ComputationGraph &cg, SigMap &sm) const override;
   virtual std::vector<int> autobatch_concat(const ComputationGraph & cg) const override;
   virtual void autobatch_reshape(const ComputationGraph & cg,
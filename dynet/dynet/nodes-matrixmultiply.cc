@@ -137,4 +137,134 @@ void MatrixMultiply::backward_dev_impl(const MyDevice & dev,
 }
 DYNET_NODE_INST_DEV_IMPL(MatrixMultiply)
 
+// ************* MatrixTranspMultiply *************
+
+#ifndef __CUDACC__
+
+string MatrixTranspMultiply::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "transpose(" << arg_names[0] << ") * " << arg_names[1];
+  return s.str();
+}
+
+Dim MatrixTranspMultiply::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 2, "Failed input count check in MatrixTranspMultiply")
+  DYNET_ARG_CHECK(xs[0].rows() == xs[1].rows(), "Mismatched input dimensions in MatrixTranspMultiply: " << xs);
+  DYNET_ARG_CHECK(xs[0].nd <= 2 && xs[1].nd <= 2, "Cannot multiply tensors of dimension higher than 2: " << xs);
+  DYNET_ARG_CHECK(xs[0].bd == 1 || xs[1].bd == 1 || xs[0].bd == xs[1].bd,
+                  "Number of batch elements in MatrixTranspMultiply must match: " << xs);
+  if (xs[1].ndims() == 1) return Dim({xs[0].cols()}, max(xs[0].bd, xs[1].bd));
+  return Dim({xs[0].cols(), xs[1].cols()}, max(xs[0].bd, xs[1].bd));
+}
+
+#endif
+
+template<class MyDevice>
+void MatrixTranspMultiply::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+  DYNET_ASSERT(xs.size() == 2, "Failed dimension check in MatrixTranspMultiply::forward");
+#ifdef __CUDACC__
+  if(xs[0]->d.bd == 1 && xs[1]->d.bd == fx.d.bd) {
+    // fx.colbatch_matrix() = (**xs[0]).transpose() * xs[1]->colbatch_matrix()
+    CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_T, CUBLAS_OP_N,
+          fx.d.rows(), fx.d.cols() * fx.d.batch_elems(), xs[0]->d.rows(),
+          dev.kSCALAR_ONE,
+          xs[0]->v, xs[0]->d.rows(),
+          xs[1]->v, xs[1]->d.rows(),
+          dev.kSCALAR_ZERO, fx.v, fx.d.rows()));
+  } else {
+    for(unsigned b = 0; b < fx.d.bd; ++b)
+      CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_T, CUBLAS_OP_N,
+            fx.d.rows(), fx.d.cols(), xs[0]->d.rows(),
+            dev.kSCALAR_ONE,
+            xs[0]->batch_ptr(b), xs[0]->d.rows(),
+            xs[1]->batch_ptr(b), xs[1]->d.rows(),
+            dev.kSCALAR_ZERO, fx.batch_ptr(b), fx.d.rows()));
+  }
+#else
+  if(xs[0]->d.bd == 1 && xs[1]->d.bd == fx.d.bd) {
+    // [x, z, b] = [y, x]^T * [y, z, b]
+    // -> [x, z*b] = [y, x]^T, [y, z*b]
+    fx.colbatch_matrix().noalias() = (**xs[0]).transpose() * xs[1]->colbatch_matrix();
+  } else {
+    for(unsigned b = 0; b < fx.d.bd; ++b)
+      fx.batch_matrix(b).noalias() = xs[0]->batch_matrix(b).transpose() * xs[1]->batch_matrix(b);
+  }
+#endif
+}
+
+template<class MyDevice>
+void MatrixTranspMultiply::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+  DYNET_ASSERT(i < 2, "Failed dimension check in MatrixTranspMultiply::backward");
+  if (i == 0) {
+    // dEdx0 += x1 * dEdf^T
+    MatrixMultiplyTranspAcc(dev, *xs[1], dEdf, dEdxi);
+  } else {
+    // dEdx1 += x0 * dEdf
+    MatrixMultiplyAcc(dev, *xs[0], dEdf, dEdxi);
+  }
+}
+DYNET_NODE_INST_DEV_IMPL(MatrixTranspMultiply)
+
+// ************* MatrixMultiplyTransp *************
+
+#ifndef __CUDACC__
+
+string MatrixMultiplyTransp::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << arg_names[0] << " * transpose(" << arg_names[1] << ')';
+  return s.str();
+}
+
+Dim MatrixMultiplyTransp::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 2, "Failed input count check in MatrixMultiplyTransp")
+  DYNET_ARG_CHECK(xs[0].cols() == xs[1].cols(), "Mismatched input dimensions in MatrixMultiplyTransp: " << xs);
+  DYNET_ARG_CHECK(xs[0].nd <= 2 && xs[1].nd <= 2, "Cannot multiply tensors of dimension higher than 2: " << xs);
+  DYNET_ARG_CHECK(xs[0].bd == 1 || xs[1].bd == 1 || xs[0].bd == xs[1].bd,
+                  "Number of batch elements in MatrixMultiplyTransp must match: " << xs);
+  return Dim({xs[0].rows(), xs[1].rows()}, max(xs[0].bd, xs[1].bd));
+}
+
+#endif
+
+template<class MyDevice>
+void MatrixMultiplyTransp::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+  DYNET_ASSERT(xs.size() == 2, "Failed dimension check in MatrixMultiplyTransp::forward");
+  // The transposed right operand has no contiguous column-batch layout, so always loop
+#ifdef __CUDACC__
+  for(unsigned b = 0; b < fx.d.bd; ++b)
+    CUBLAS_CHECK(cublasSgemm(dev.cublas_handle, CUBLAS_OP_N, CUBLAS_OP_T,
+          fx.d.rows(), fx.d.cols(), xs[0]->d.cols(),
+          dev.kSCALAR_ONE,
+          xs[0]->batch_ptr(b), xs[0]->d.rows(),
+          xs[1]->batch_ptr(b), xs[1]->d.rows(),
+          dev.kSCALAR_ZERO, fx.batch_ptr(b), fx.d.rows()));
+#else
+  for(unsigned b = 0; b < fx.d.bd; ++b)
+    fx.batch_matrix(b).noalias() = xs[0]->batch_matrix(b) * xs[1]->batch_matrix(b).transpose();
+#endif
+}
+
+template<class MyDevice>
+void MatrixMultiplyTransp::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+  DYNET_ASSERT(i < 2, "Failed dimension check in MatrixMultiplyTransp::backward");
+  if (i == 0) {
+    // dEdx0 += dEdf * x1
+    MatrixMultiplyAcc(dev, dEdf, *xs[1], dEdxi);
+  } else {
+    // dEdx1 += dEdf^T * x0
+    MatrixTranspMultiplyAcc(dev, dEdf, *xs[0], dEdxi);
+  }
+}
+DYNET_NODE_INST_DEV_IMPL(MatrixMultiplyTransp)
+
 }
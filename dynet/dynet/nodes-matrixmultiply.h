@@ -22,6 +22,20 @@ struct MatrixMultiply : public Node {
   DYNET_NODE_DEFINE_DEV_IMPL()
 };
 
+// y = x_1^T * x_2
+struct MatrixTranspMultiply : public Node {
+  explicit MatrixTranspMultiply(const std::initializer_list<VariableIndex>& a) : Node(a) {}
+  virtual bool supports_multibatch() const override { return true; }
+  DYNET_NODE_DEFINE_DEV_IMPL()
+};
+
+// y = x_1 * x_2^T
+struct MatrixMultiplyTransp : public Node {
+  explicit MatrixMultiplyTransp(const std::initializer_list<VariableIndex>& a) : Node(a) {}
+  virtual bool supports_multibatch() const override { return true; }
+  DYNET_NODE_DEFINE_DEV_IMPL()
+};
+
 } // namespace dynet
 
 #endif
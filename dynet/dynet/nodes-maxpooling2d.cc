@@ -65,7 +65,7 @@ void MaxPooling2D::forward_dev_impl(const MyDevice & dev, const vector<const Ten
   DYNET_ASSERT(xs.size() == 1, "Failed dimension check in MaxPooling2D::forward, exactly one input");
   DYNET_ASSERT(fx.d.bd == xs[0]->d.bd, "Failed dimension check in MaxPooling2D::forward, batchsize not match");
   DYNET_ASSERT(fx.d[2] == xs[0]->d[2], "Failed dimension check in MaxPooling2D::forward, #channel not match");
-  AlignedMemoryPool* scratch_allocator = default_device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = default_device->scratch_pool();
 #ifdef __CUDACC__
 #if HAVE_CUDNN
   if (cudnn_maxpool_op_ == NULL)
@@ -487,7 +487,7 @@ void StdDimension::forward_dev_impl(const MyDevice & dev, const vector<const Ten
     n = overwrite_n;
   }
 
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
 
   if(dims.size()==0 && include_batch_dim){
     Eigen::array<ptrdiff_t, 1> red_axis = {1};
@@ -551,7 +551,7 @@ void StdDimension::backward_dev_impl(const MyDevice & dev,
     n = overwrite_n;
   }
 
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
 
   if(dims.size()==0 && include_batch_dim){
     Eigen::array<ptrdiff_t, 1> red_axis = {1};
@@ -2,6 +2,8 @@
 
 #include "dynet/nodes-macros.h"
 
+#include <limits>
+
 using namespace std;
 
 namespace dynet {
@@ -30,7 +32,7 @@ void WeightNormalization::forward_dev_impl(const MyDevice & dev, const vector<co
   Eigen::array<ptrdiff_t, 1> red_axis = {0};
   Eigen::array<ptrdiff_t, 1> bcast = {xs[0]->d.size()};
   Eigen::array<ptrdiff_t, 1> morph = {1};
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   Tensor tmp(Dim({1}, 1), nullptr, fx.device, fx.mem_pool);
   tmp.v = static_cast<float*>(scratch_allocator->allocate(tmp.d.size() * sizeof(float)));
   tmp.tvec().device(*dev.edevice) = xs[0]->tvec().square().sum(red_axis).sqrt().reshape(morph);
@@ -48,7 +50,7 @@ void WeightNormalization::backward_dev_impl(const MyDevice & dev,
   Eigen::array<ptrdiff_t, 1> red_axis = {0};
   Eigen::array<ptrdiff_t, 1> bcast = {xs[0]->d.size()};
   Eigen::array<ptrdiff_t, 1> morph = {1};
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   if (i==0){
     Tensor tmp(Dim({1}, 1), nullptr, fx.device, fx.mem_pool);
     tmp.v = static_cast<float*>(scratch_allocator->allocate(tmp.d.size() * sizeof(float)));
@@ -64,4 +66,270 @@ void WeightNormalization::backward_dev_impl(const MyDevice & dev,
 }
 DYNET_NODE_INST_DEV_IMPL(WeightNormalization)
 
+// ************* LayerNorm *************
+
+#ifndef __CUDACC__
+
+string LayerNorm::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "layer_norm_colwise(" << arg_names[0];
+  if (arg_names.size() > 3) {
+    s << " + ";
+    if (dropout > 0.f) s << "dropout(" << arg_names[3] << ", " << dropout << (dropout_colwise ? ", colwise)" : ")");
+    else s << arg_names[3];
+  }
+  s << ", " << arg_names[1] << ", " << arg_names[2] << ')';
+  return s.str();
+}
+
+Dim LayerNorm::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 3 || xs.size() == 4, "Failed input count check in LayerNorm");
+  DYNET_ARG_CHECK(xs[0].nd <= 2, "LayerNorm expects a vector or matrix input, received " << xs[0]);
+  DYNET_ARG_CHECK(xs[1].size() == xs[0].rows() && xs[1].bd == 1 && xs[2].size() == xs[0].rows() && xs[2].bd == 1,
+                  "Gain and bias in LayerNorm should have " << xs[0].rows() << " elements and no batch dimension, received " << xs);
+  DYNET_ARG_CHECK(xs.size() == 3 || (xs[3].nd <= 2 && xs[3].rows() == xs[0].rows() && xs[3].cols() == xs[0].cols() && xs[3].bd == xs[0].bd),
+                  "Residual input in LayerNorm should have the same dimension as the input, received " << xs);
+  DYNET_ARG_CHECK(dropout == 0.f || (xs.size() == 4 && dropout > 0.f && dropout < 1.f),
+                  "Bad dropout rate in LayerNorm (dropout requires a residual input): " << dropout);
+  return xs[0];
+}
+
+// aux_mem holds the mean of each column, then their standard deviations, then the dropout mask
+// (n values per batch element if dropout_colwise, n per column otherwise)
+size_t LayerNorm::aux_storage_size() const {
+  const size_t ncols = dim.size() / dim.rows();
+  size_t mask_size = 0;
+  if (dropout > 0.f) mask_size = dropout_colwise ? dim.rows() * dim.bd : dim.size();
+  return (2 * ncols + mask_size) * sizeof(float);
+}
+
+#endif
+
+#ifndef __CUDACC__
+namespace {
+
+// normalises a column s of n values into y (s and y may alias), returning its mean and standard deviation
+inline void layer_norm_column(const float* s, const float* g, const float* b, unsigned n, float epsilon, float* y, float& mean, float& sigma) {
+  // mean and variance in one pass, shifted by the first value to avoid cancellation
+  const float shift = s[0];
+  float sum = 0.f, sum_sq = 0.f;
+  for (unsigned k = 0; k < n; ++k) {
+    const float v = s[k] - shift;
+    sum += v;
+    sum_sq += v * v;
+  }
+  const float m = sum / n;
+  mean = shift + m;
+  sigma = std::sqrt(std::max(sum_sq / n - m * m, 0.f));
+  const float inv = 1.f / (sigma + epsilon), mu = mean;
+  for (unsigned k = 0; k < n; ++k)
+    y[k] = g[k] * (s[k] - mu) * inv + b[k];
+}
+
+// ds += (dL/ds of a column s of n values) .* mask (if any)
+inline void layer_norm_column_backward(const float* s, const float* dy, const float* g, unsigned n, float mean, float sigma, float epsilon, const float* mask, float* ds) {
+  const float inv = 1.f / (sigma + epsilon);
+  float sd = 0.f, sdx = 0.f;// sum of dL/dy .* g, and of dL/dy .* g .* (s - mean)
+  for (unsigned k = 0; k < n; ++k) {
+    const float d = dy[k] * g[k];
+    sd += d;
+    sdx += d * (s[k] - mean);
+  }
+  // the second term comes through std(s); it vanishes for constant columns
+  const float a = sd / n, r = sdx * inv * inv / std::max(n * sigma, std::numeric_limits<float>::min());
+  if (mask) {
+    for (unsigned k = 0; k < n; ++k)
+      ds[k] += ((dy[k] * g[k] - a) * inv - (s[k] - mean) * r) * mask[k];
+  } else {
+    for (unsigned k = 0; k < n; ++k)
+      ds[k] += (dy[k] * g[k] - a) * inv - (s[k] - mean) * r;
+  }
+}
+
+} // namespace
+#endif
+
+template<class MyDevice>
+void LayerNorm::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+  const unsigned n = xs[0]->d.rows(), m = xs[0]->d.cols(), B = xs[0]->d.bd;
+  const size_t ncols = (size_t)m * B;
+  const bool residual = xs.size() > 3;
+  float* mean = (float*)aux_mem;
+  float* sigma = mean + ncols;
+  float* mask = (dropout > 0.f) ? sigma + ncols : nullptr;
+  if (mask) {
+    Tensor tmask(dropout_colwise ? Dim({n}, B) : Dim({n, m}, B), mask, fx.device, DeviceMempool::FXS);
+    TensorTools::randomize_bernoulli(tmask, 1.f - dropout, 1.f / (1.f - dropout));
+  }
+#ifdef __CUDACC__
+  Tensor x(Dim({n, (unsigned)ncols}), xs[0]->v, fx.device, DeviceMempool::FXS), y(Dim({n, (unsigned)ncols}), fx.v, fx.device, DeviceMempool::FXS);
+  Tensor g(Dim({n}), xs[1]->v, fx.device, DeviceMempool::FXS), b(Dim({n}), xs[2]->v, fx.device, DeviceMempool::FXS);
+  Tensor tmean(Dim({(unsigned)ncols}), mean, fx.device, DeviceMempool::FXS), tsigma(Dim({(unsigned)ncols}), sigma, fx.device, DeviceMempool::FXS);
+  Eigen::array<ptrdiff_t, 1> red_axis = {0};
+  Eigen::array<ptrdiff_t, 2> col_morph = {1, (ptrdiff_t)ncols}, col_bcast = {(ptrdiff_t)n, 1};
+  Eigen::array<ptrdiff_t, 2> row_morph = {(ptrdiff_t)n, 1}, row_bcast = {1, (ptrdiff_t)ncols};
+  // the residual sum goes through y, which is overwritten by the normalised values
+  Tensor s = residual ? y : x;
+  if (residual) {
+    Tensor f(Dim({n, m, B}), xs[3]->v, fx.device, DeviceMempool::FXS), s3(Dim({n, m, B}), fx.v, fx.device, DeviceMempool::FXS);
+    Tensor x3(Dim({n, m, B}), xs[0]->v, fx.device, DeviceMempool::FXS);
+    if (!mask) {
+      s3.t<3>().device(*dev.edevice) = x3.t<3>() + f.t<3>();
+    } else if (dropout_colwise) {
+      Tensor tmask(Dim({n, 1, B}), mask, fx.device, DeviceMempool::FXS);
+      Eigen::array<ptrdiff_t, 3> mask_bcast = {1, (ptrdiff_t)m, 1};
+      s3.t<3>().device(*dev.edevice) = x3.t<3>() + f.t<3>() * tmask.t<3>().broadcast(mask_bcast);
+    } else {
+      Tensor tmask(Dim({n, m, B}), mask, fx.device, DeviceMempool::FXS);
+      s3.t<3>().device(*dev.edevice) = x3.t<3>() + f.t<3>() * tmask.t<3>();
+    }
+  }
+  tmean.t<1>().device(*dev.edevice) = s.t<2>().mean(red_axis);
+  tsigma.t<1>().device(*dev.edevice) = (s.t<2>() - tmean.t<1>().reshape(col_morph).broadcast(col_bcast)).square().mean(red_axis).sqrt();
+  y.t<2>().device(*dev.edevice) = g.t<1>().reshape(row_morph).broadcast(row_bcast)
+    * (s.t<2>() - tmean.t<1>().reshape(col_morph).broadcast(col_bcast)) / (tsigma.t<1>().reshape(col_morph).broadcast(col_bcast) + epsilon)
+    + b.t<1>().reshape(row_morph).broadcast(row_bcast);
+#else
+  const float *g = xs[1]->v, *b = xs[2]->v;
+  dev.parallel_for(ncols, residual ? 5 * n : 3 * n, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      const float* s = xs[0]->v + c * n;
+      float* y = fx.v + c * n;
+      if (residual) {// y <- x + dropout(f), normalised in place below
+        const float* f = xs[3]->v + c * n;
+        const float* mc = mask ? mask + (dropout_colwise ? (c / m) * n : c * n) : nullptr;
+        if (mc) {
+          for (unsigned k = 0; k < n; ++k) y[k] = s[k] + f[k] * mc[k];
+        } else {
+          for (unsigned k = 0; k < n; ++k) y[k] = s[k] + f[k];
+        }
+        s = y;
+      }
+      layer_norm_column(s, g, b, n, epsilon, y, mean[c], sigma[c]);
+    }
+  });
+#endif
+}
+
+template<class MyDevice>
+void LayerNorm::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+  const unsigned n = xs[0]->d.rows(), m = xs[0]->d.cols(), B = xs[0]->d.bd;
+  const size_t ncols = (size_t)m * B;
+  const bool residual = xs.size() > 3;
+  const float* mean = (const float*)aux_mem;
+  const float* sigma = mean + ncols;
+  const float* mask = (dropout > 0.f) ? sigma + ncols : nullptr;
+#ifdef __CUDACC__
+  // recompute the input of the normalisation (x + dropout(f)) in scratch memory
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
+  Tensor s(Dim({n, (unsigned)ncols}), xs[0]->v, fx.device, DeviceMempool::FXS), dy(Dim({n, (unsigned)ncols}), dEdf.v, fx.device, DeviceMempool::FXS);
+  if (residual) {
+    s.v = static_cast<float*>(scratch_allocator->allocate(s.d.size() * sizeof(float)));
+    Tensor s3(Dim({n, m, B}), s.v, fx.device, DeviceMempool::FXS);
+    Tensor x3(Dim({n, m, B}), xs[0]->v, fx.device, DeviceMempool::FXS), f(Dim({n, m, B}), xs[3]->v, fx.device, DeviceMempool::FXS);
+    if (!mask) {
+      s3.t<3>().device(*dev.edevice) = x3.t<3>() + f.t<3>();
+    } else if (dropout_colwise) {
+      Tensor tmask(Dim({n, 1, B}), (float*)mask, fx.device, DeviceMempool::FXS);
+      Eigen::array<ptrdiff_t, 3> mask_bcast = {1, (ptrdiff_t)m, 1};
+      s3.t<3>().device(*dev.edevice) = x3.t<3>() + f.t<3>() * tmask.t<3>().broadcast(mask_bcast);
+    } else {
+      Tensor tmask(Dim({n, m, B}), (float*)mask, fx.device, DeviceMempool::FXS);
+      s3.t<3>().device(*dev.edevice) = x3.t<3>() + f.t<3>() * tmask.t<3>();
+    }
+  }
+  Tensor tmean(Dim({(unsigned)ncols}), (float*)mean, fx.device, DeviceMempool::FXS), tsigma(Dim({(unsigned)ncols}), (float*)sigma, fx.device, DeviceMempool::FXS);
+  Eigen::array<ptrdiff_t, 1> red_axis = {0}, col_axis = {1};
+  Eigen::array<ptrdiff_t, 2> col_morph = {1, (ptrdiff_t)ncols}, col_bcast = {(ptrdiff_t)n, 1};
+  Eigen::array<ptrdiff_t, 2> row_morph = {(ptrdiff_t)n, 1}, row_bcast = {1, (ptrdiff_t)ncols};
+  auto xc = s.t<2>() - tmean.t<1>().reshape(col_morph).broadcast(col_bcast);
+  auto denom = tsigma.t<1>().reshape(col_morph).broadcast(col_bcast) + epsilon;
+  if (i == 0 || i == 3) {
+    Tensor g(Dim({n}), xs[1]->v, fx.device, DeviceMempool::FXS);
+    auto d = dy.t<2>() * g.t<1>().reshape(row_morph).broadcast(row_bcast);
+    Tensor a(Dim({(unsigned)ncols}), nullptr, fx.device, fx.mem_pool), r(Dim({(unsigned)ncols}), nullptr, fx.device, fx.mem_pool);
+    a.v = static_cast<float*>(scratch_allocator->allocate(a.d.size() * sizeof(float)));
+    r.v = static_cast<float*>(scratch_allocator->allocate(r.d.size() * sizeof(float)));
+    a.t<1>().device(*dev.edevice) = d.mean(red_axis);
+    r.t<1>().device(*dev.edevice) = (d * xc).sum(red_axis) / ((tsigma.t<1>() + epsilon).square() * (tsigma.t<1>() * (float)n).cwiseMax(std::numeric_limits<float>::min()));
+    auto ds = (d - a.t<1>().reshape(col_morph).broadcast(col_bcast)) / denom - xc * r.t<1>().reshape(col_morph).broadcast(col_bcast);
+    Tensor dx(Dim({n, (unsigned)ncols}), dEdxi.v, fx.device, DeviceMempool::FXS);
+    if (i == 0 || !mask) {
+      dx.t<2>().device(*dev.edevice) += ds;
+    } else {// dL/df = dL/ds .* dropout mask
+      Tensor ds3(Dim({n, m, B}), nullptr, fx.device, fx.mem_pool), dx3(Dim({n, m, B}), dEdxi.v, fx.device, DeviceMempool::FXS);
+      ds3.v = static_cast<float*>(scratch_allocator->allocate(ds3.d.size() * sizeof(float)));
+      Tensor ds2(Dim({n, (unsigned)ncols}), ds3.v, fx.device, DeviceMempool::FXS);
+      ds2.t<2>().device(*dev.edevice) = ds;
+      if (dropout_colwise) {
+        Tensor tmask(Dim({n, 1, B}), (float*)mask, fx.device, DeviceMempool::FXS);
+        Eigen::array<ptrdiff_t, 3> mask_bcast = {1, (ptrdiff_t)m, 1};
+        dx3.t<3>().device(*dev.edevice) += ds3.t<3>() * tmask.t<3>().broadcast(mask_bcast);
+      } else {
+        Tensor tmask(Dim({n, m, B}), (float*)mask, fx.device, DeviceMempool::FXS);
+        dx3.t<3>().device(*dev.edevice) += ds3.t<3>() * tmask.t<3>();
+      }
+    }
+  } else {
+    Tensor dp(Dim({n}), dEdxi.v, fx.device, DeviceMempool::FXS);
+    if (i == 1)
+      dp.t<1>().device(*dev.edevice) += (dy.t<2>() * xc / denom).sum(col_axis);
+    else
+      dp.t<1>().device(*dev.edevice) += dy.t<2>().sum(col_axis);
+  }
+  scratch_allocator->free();
+#else
+  const float* g = xs[1]->v;
+  // column c of x + dropout(f), written to buf
+  auto residual_column = [&](size_t c, float* buf) {
+    const float *x = xs[0]->v + c * n, *f = xs[3]->v + c * n;
+    const float* mc = mask ? mask + (dropout_colwise ? (c / m) * n : c * n) : nullptr;
+    if (mc) {
+      for (unsigned k = 0; k < n; ++k) buf[k] = x[k] + f[k] * mc[k];
+    } else {
+      for (unsigned k = 0; k < n; ++k) buf[k] = x[k] + f[k];
+    }
+  };
+  if (i == 0 || i == 3) {
+    dev.parallel_for(ncols, residual ? 6 * n : 4 * n, [&](size_t begin, size_t end) {
+      std::vector<float> buf(residual ? n : 0);
+      for (size_t c = begin; c < end; ++c) {
+        const float* s = xs[0]->v + c * n;
+        if (residual) {
+          residual_column(c, buf.data());
+          s = buf.data();
+        }
+        const float* mc = (i == 3 && mask) ? mask + (dropout_colwise ? (c / m) * n : c * n) : nullptr;
+        layer_norm_column_backward(s, dEdf.v + c * n, g, n, mean[c], sigma[c], epsilon, mc, dEdxi.v + c * n);
+      }
+    });
+  } else {
+    // gain and bias gradients sum over columns: split rows over the threads instead
+    float* dp = dEdxi.v;
+    dev.parallel_for(n, residual ? 5 * ncols : 3 * ncols, [&](size_t begin, size_t end) {
+      for (size_t c = 0; c < ncols; ++c) {
+        const float* dy = dEdf.v + c * n;
+        if (i == 2) {
+          for (size_t k = begin; k < end; ++k) dp[k] += dy[k];
+          continue;
+        }
+        const float *x = xs[0]->v + c * n, *f = residual ? xs[3]->v + c * n : nullptr;
+        const float* mc = mask ? mask + (dropout_colwise ? (c / m) * n : c * n) : nullptr;
+        const float mu = mean[c], inv = 1.f / (sigma[c] + epsilon);
+        for (size_t k = begin; k < end; ++k) {
+          const float s = f ? x[k] + f[k] * (mc ? mc[k] : 1.f) : x[k];
+          dp[k] += dy[k] * (s - mu) * inv;
+        }
+      }
+    });
+  }
+#endif
+}
+DYNET_NODE_INST_DEV_IMPL(LayerNorm)
+
 }
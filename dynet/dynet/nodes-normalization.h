@@ -13,6 +13,23 @@ struct WeightNormalization : public Node {
   DYNET_NODE_DEFINE_DEV_IMPL()
 };
 
+// y = g .* (s - mean(s)) / (std(s) + epsilon) + b, for each column of s
+// s = x, or s = x + dropout(f) with a residual input f (the epilogue of a transformer sub-layer)
+// x, f: ((n, m), B); g, b: n elements, not batched
+// dropout_colwise: use the same dropout mask for all columns (as dropout_dim(f, 1, p))
+// forward keeps only the dropout mask and the mean and standard deviation of each column for backward
+struct LayerNorm : public Node {
+  explicit LayerNorm(const std::initializer_list<VariableIndex>& a, float epsilon, float dropout = 0.f, bool dropout_colwise = false)
+    : Node(a), epsilon(epsilon), dropout(dropout), dropout_colwise(dropout_colwise) {}
+  virtual bool supports_multibatch() const override { return true; }
+  virtual bool is_stochastic() const override { return dropout > 0.f; }
+  DYNET_NODE_DEFINE_DEV_IMPL()
+  size_t aux_storage_size() const override;
+  float epsilon;
+  float dropout;
+  bool dropout_colwise;
+};
+
 } // namespace dynet
 
 #endif
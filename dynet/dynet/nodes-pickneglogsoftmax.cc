@@ -144,4 +144,114 @@ void PickNegLogSoftmax::backward_dev_impl(const MyDevice & dev,
 }
 DYNET_NODE_INST_DEV_IMPL(PickNegLogSoftmax)
 
+// ************* SoftmaxCrossEntropy *************
+
+#ifndef __CUDACC__
+
+string SoftmaxCrossEntropy::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "softmax_cross_entropy(" << arg_names[0] << ", smoothing=" << smoothing;
+  if(mask.size()) s << ", masked";
+  s << ')';
+  return s.str();
+}
+
+Dim SoftmaxCrossEntropy::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 1, "Failed input count check in SoftmaxCrossEntropy");
+  DYNET_ARG_CHECK(xs[0].nd <= 2, "Bad input dimensions in SoftmaxCrossEntropy, expected ((V, C), B) scores: " << xs);
+  DYNET_ARG_CHECK(targets.size() == xs[0].cols() * xs[0].bd,
+                  "The number of targets passed to SoftmaxCrossEntropy (" << targets.size() <<
+                  ") did not match the number of score columns in " << xs[0]);
+  DYNET_ARG_CHECK(mask.empty() || mask.size() == targets.size(),
+                  "SoftmaxCrossEntropy mask size (" << mask.size() << ") did not match the number of targets (" << targets.size() << ")");
+  DYNET_ARG_CHECK(smoothing >= 0.f && smoothing < 1.f && (smoothing == 0.f || xs[0].rows() > 1),
+                  "Bad label smoothing weight in SoftmaxCrossEntropy: " << smoothing);
+  return Dim({1});
+}
+
+size_t SoftmaxCrossEntropy::aux_storage_size() const {
+  return 3 * targets.size() * sizeof(float) + targets.size() * sizeof(unsigned int);
+}
+
+#endif
+
+// aux_mem holds, per column: z (log-partition), m (scratch), w (mask) and the flat target ids
+template<class MyDevice>
+void SoftmaxCrossEntropy::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+  const unsigned V = xs[0]->d.rows(), n = targets.size();
+  const Dim col_dim({xs[0]->d.cols()}, xs[0]->d.bd);
+  Tensor z(col_dim, (float*)aux_mem, fx.device, DeviceMempool::FXS);
+  Tensor m(col_dim, (float*)aux_mem + n, fx.device, DeviceMempool::FXS);
+  Tensor w(col_dim, (float*)aux_mem + 2*n, fx.device, DeviceMempool::FXS);
+  unsigned int *ids_dev = (unsigned int*)((float*)aux_mem + 3*n), *ids_host;
+  float *w_host;
+#ifdef __CUDACC__
+  ids_host = (unsigned int*)malloc(n * sizeof(unsigned int));
+  w_host = (float*)malloc(n * sizeof(float));
+#else
+  ids_host = ids_dev;
+  w_host = w.v;
+#endif
+  for(unsigned i = 0; i < n; ++i) {
+    DYNET_ARG_CHECK(targets[i] < V,
+                    "Index error in SoftmaxCrossEntropy: Index " << targets[i] << " out of bounds for input tensor " << xs[0]->d);
+    ids_host[i] = i * V + targets[i];
+    w_host[i] = mask.size() ? mask[i] : 1.f;
+  }
+  TensorTools::logsumexp_dev(dev, *xs[0], m, z);
+  // m <- x_y, the score of the target in each column
+#ifdef __CUDACC__
+  CUDA_CHECK(cudaMemcpyAsync(ids_dev, ids_host, n * sizeof(unsigned int), cudaMemcpyHostToDevice));
+  CUDA_CHECK(cudaMemcpyAsync(w.v, w_host, n * sizeof(float), cudaMemcpyHostToDevice));
+  dynet::gpu::sparse_to_dense_assign(n, ids_dev, xs[0]->v, m.v);
+  CUDA_CHECK(cudaStreamSynchronize(0));
+  free(ids_host);
+  free(w_host);
+#else
+  for(unsigned i = 0; i < n; ++i)
+    m.v[i] = xs[0]->v[ids_dev[i]];
+#endif
+  if(smoothing > 0.f) {
+    const float e = smoothing / (V - 1);
+    Eigen::array<int, 1> red_axis; red_axis[0] = 0;
+    m.tb<1>().device(*dev.edevice) = (z.tb<1>() * (1.f - smoothing + e * V) - m.tb<1>() * (1.f - smoothing)
+                                      - xs[0]->tb<2>().sum(red_axis) * e) * w.tb<1>();
+  } else {
+    m.tvec().device(*dev.edevice) = (z.tvec() - m.tvec()) * w.tvec();
+  }
+  fx.t<0>().device(*dev.edevice) = m.tvec().sum();
+}
+
+template<class MyDevice>
+void SoftmaxCrossEntropy::backward_dev_impl(const MyDevice & dev,
+                            const vector<const Tensor*>& xs,
+                            const Tensor& fx,
+                            const Tensor& dEdf,
+                            unsigned i,
+                            Tensor& dEdxi) const {
+  const unsigned V = xs[0]->d.rows(), C = xs[0]->d.cols(), n = targets.size();
+  const Dim col_dim({C}, xs[0]->d.bd);
+  Tensor z(col_dim, (float*)aux_mem, fx.device, DeviceMempool::FXS);
+  Tensor m(col_dim, (float*)aux_mem + n, fx.device, DeviceMempool::FXS);
+  Tensor w(col_dim, (float*)aux_mem + 2*n, fx.device, DeviceMempool::FXS);
+  unsigned int *ids_dev = (unsigned int*)((float*)aux_mem + 3*n);
+  const float e = smoothing > 0.f ? smoothing / (V - 1) : 0.f;
+  // m <- dE/dl for every column
+  Eigen::array<int, 1> bcast_n({(int)n});
+  m.tvec().device(*dev.edevice) = w.tvec() * dEdf.tvec().broadcast(bcast_n);
+  // dE/dx += m * ((1-e+eV) * softmax(x) - e), then the one-hot part below
+  Eigen::array<int, 3> morph({1, (int)C, (int)xs[0]->d.bd}), bcast({(int)V, 1, 1});
+  dEdxi.tb<2>().device(*dev.edevice) +=
+    ((xs[0]->tb<2>() - z.tb<1>().reshape(morph).broadcast(bcast)).exp() * (1.f - smoothing + e * V) - e)
+    * m.tb<1>().reshape(morph).broadcast(bcast);
+  m.tvec().device(*dev.edevice) = m.tvec() * (1.f - smoothing);
+#ifdef __CUDACC__
+  dynet::gpu::dense_to_sparse_subtract(n, ids_dev, m.v, dEdxi.v);
+#else
+  for(unsigned j = 0; j < n; ++j)
+    dEdxi.v[ids_dev[j]] -= m.v[j];
+#endif
+}
+DYNET_NODE_INST_DEV_IMPL(SoftmaxCrossEntropy)
+
 }
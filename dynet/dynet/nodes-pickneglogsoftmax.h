@@ -35,6 +35,22 @@ struct PickNegLogSoftmax : public Node {
   const std::vector<unsigned>* pvals;
 };
 
+// l_{c,b} = mask_{c,b} * ((1-e) * (\log z_{c,b} - x_{y_{c,b},c,b})
+//                          + e/(V-1) * (V \log z_{c,b} - \sum_v x_{v,c,b}))
+// y = \sum_{c,b} l_{c,b}
+// fuses softmax, label smoothing, masking and the reduction over a whole
+// ((V, C), B) logit tensor without materialising the log-probabilities
+struct SoftmaxCrossEntropy : public Node {
+  explicit SoftmaxCrossEntropy(const std::initializer_list<VariableIndex>& a, const std::vector<unsigned>& t,
+                               const std::vector<float>& m, float e) : Node(a), targets(t), mask(m), smoothing(e) {}
+  DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool supports_multibatch() const override { return true; }
+  size_t aux_storage_size() const override;
+  std::vector<unsigned> targets; // size C*B, column c of batch element b at b*C+c
+  std::vector<float> mask; // same layout as targets, empty means no masking
+  float smoothing;
+};
+
 } // namespace dynet
 
 #endif
@@ -0,0 +1,169 @@
+#include "dynet/nodes-quantize.h"
+
+#include "dynet/nodes-macros.h"
+
+#ifndef __CUDACC__
+#include <cmath>
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace dynet {
+
+#ifndef __CUDACC__
+
+// ************* QuantizedMatrix *************
+
+namespace {
+
+const unsigned kInt8Block = 64;
+
+// quantise n floats with the given scale, rounding to nearest; |q| <= 127 so that the
+// sign tricks in dot_int8 never have to negate -128
+inline void quantize_int8(const float* x, size_t stride, unsigned n, float scale, int8_t* q) {
+  const float inv = 1.f / scale;
+  for (unsigned k = 0; k < n; ++k) {
+    float v = std::nearbyint(x[k * stride] * inv);
+    q[k] = (int8_t)std::max(-127.f, std::min(127.f, v));
+  }
+}
+
+// dot product of two int8 vectors whose length n is a multiple of kInt8Block
+inline int32_t dot_int8(const int8_t* a, const int8_t* b, unsigned n) {
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+  // vpdpbusd multiplies unsigned by signed bytes: use |a| and move the sign of a onto b
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i acc = zero;
+  for (unsigned i = 0; i < n; i += 64) {
+    __m512i va = _mm512_loadu_si512((const void*)(a + i));
+    __m512i vb = _mm512_loadu_si512((const void*)(b + i));
+    vb = _mm512_mask_sub_epi8(vb, _mm512_movepi8_mask(va), zero, vb);
+    acc = _mm512_dpbusd_epi32(acc, _mm512_abs_epi8(va), vb);
+  }
+  return _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+  // same sign trick; each pair of |a| * b products fits in the saturating int16 of vpmaddubsw (2 * 127 * 127)
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc = _mm256_setzero_si256();
+  for (unsigned i = 0; i < n; i += 32) {
+    __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    __m256i prod = _mm256_maddubs_epi16(_mm256_abs_epi8(va), _mm256_sign_epi8(vb, va));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(prod, ones));
+  }
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return _mm_cvtsi128_si32(sum);
+#else
+  int32_t acc = 0;
+  for (unsigned i = 0; i < n; ++i)
+    acc += (int32_t)a[i] * (int32_t)b[i];
+  return acc;
+#endif
+}
+
+} // namespace
+
+QuantizedMatrix::QuantizedMatrix(const Tensor& w, bool transpose) {
+  DYNET_ARG_CHECK(w.device->type == DeviceType::CPU, "QuantizedMatrix requires a weight matrix in CPU memory");
+  DYNET_ARG_CHECK(w.d.nd <= 2 && w.d.bd == 1, "Bad weight dimensions in QuantizedMatrix: " << w.d);
+  const unsigned R = w.d.rows(), C = w.d.cols();
+  rows = transpose ? C : R;
+  cols = transpose ? R : C;
+  padded_cols = (cols + kInt8Block - 1) / kInt8Block * kInt8Block;
+  values.assign((size_t)rows * padded_cols, 0);
+  scales.resize(rows);
+  // element (r, k) of the quantised matrix lives at w.v[r * row_step + k * col_step] (column-major storage)
+  const size_t row_step = transpose ? R : 1, col_step = transpose ? 1 : R;
+  for (unsigned r = 0; r < rows; ++r) {
+    const float* wr = w.v + r * row_step;
+    float amax = 0.f;
+    for (unsigned k = 0; k < cols; ++k)
+      amax = std::max(amax, std::fabs(wr[k * col_step]));
+    scales[r] = amax > 0.f ? amax / 127.f : 1.f;
+    quantize_int8(wr, col_step, cols, scales[r], &values[(size_t)r * padded_cols]);
+  }
+}
+
+// ************* Int8AffineTransform *************
+
+string Int8AffineTransform::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "int8_affine_transform(" << pW->rows << 'x' << pW->cols << ", " << arg_names[0];
+  if (arg_names.size() > 1) s << ", " << arg_names[1];
+  if (rows.size()) s << ", {rsize=" << rows.size() << '}';
+  s << ')';
+  return s.str();
+}
+
+Dim Int8AffineTransform::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 1 || xs.size() == 2, "Failed input count check in Int8AffineTransform");
+  DYNET_ARG_CHECK(xs[0].nd <= 2 && xs[0].rows() == pW->cols,
+                  "Bad input dimensions in Int8AffineTransform, expected ((" << pW->cols << ", N), B): " << xs);
+  DYNET_ARG_CHECK(xs.size() == 1 || (xs[1].size() == pW->rows && xs[1].bd == 1),
+                  "Bad bias dimensions in Int8AffineTransform, expected " << pW->rows << " values: " << xs);
+  for (auto r : rows)
+    DYNET_ARG_CHECK(r < pW->rows, "Out-of-bounds row " << r << " in Int8AffineTransform over " << pW->rows << " rows");
+  return Dim({rows.size() ? (unsigned)rows.size() : pW->rows, xs[0].cols()}, xs[0].bd);
+}
+
+// aux_mem holds the quantised columns of x (padded like the rows of W), followed by their scales
+size_t Int8AffineTransform::aux_storage_size() const {
+  size_t num_cols = dim.cols() * dim.bd;
+  return num_cols * pW->padded_cols + num_cols * sizeof(float);
+}
+
+#endif
+
+template<class MyDevice>
+void Int8AffineTransform::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+#ifdef __CUDACC__
+  DYNET_RUNTIME_ERR("Int8AffineTransform is not implemented on GPU");
+#else
+  const QuantizedMatrix& W = *pW;
+  const unsigned K = W.cols, Kp = W.padded_cols, M = fx.d.rows(), N = fx.d.cols() * fx.d.bd;
+  int8_t* xq = (int8_t*)aux_mem;
+  float* xscales = (float*)(xq + (size_t)N * Kp);
+  const float* b = xs.size() > 1 ? xs[1]->v : nullptr;
+
+  // quantise x per column
+  dev.parallel_for(N, K, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      const float* x = xs[0]->v + c * K;
+      float amax = 0.f;
+      for (unsigned k = 0; k < K; ++k)
+        amax = std::max(amax, std::fabs(x[k]));
+      xscales[c] = amax > 0.f ? amax / 127.f : 1.f;
+      int8_t* q = xq + c * Kp;
+      quantize_int8(x, 1, K, xscales[c], q);
+      std::fill(q + K, q + Kp, (int8_t)0);
+    }
+  });
+
+  // y = W x (+ b), one row of W against all columns at a time
+  dev.parallel_for(M, N + Kp / 4, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const unsigned r = rows.size() ? rows[i] : i;
+      const int8_t* wr = &W.values[(size_t)r * Kp];
+      const float bias = b ? b[r] : 0.f;
+      for (unsigned c = 0; c < N; ++c)
+        fx.v[(size_t)c * M + i] = dot_int8(wr, xq + (size_t)c * Kp, Kp) * W.scales[r] * xscales[c] + bias;
+    }
+  });
+#endif
+}
+
+template<class MyDevice>
+void Int8AffineTransform::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+  DYNET_RUNTIME_ERR("Int8AffineTransform is for inference only and has no backward pass");
+}
+DYNET_NODE_INST_DEV_IMPL(Int8AffineTransform)
+
+} // namespace dynet
@@ -0,0 +1,47 @@
+#ifndef DYNET_NODES_QUANTIZE_H_
+#define DYNET_NODES_QUANTIZE_H_
+
+#include "dynet/dynet.h"
+#include "dynet/nodes-macros.h"
+
+#include <cstdint>
+
+namespace dynet {
+
+/**
+ * \brief Int8 copy of a weight matrix for quantised inference
+ * \details Each row is scaled by its own max |w| / 127 and stored row-major,
+ *          padded with zeros to a multiple of 64 columns so that the dot
+ *          product kernels need no tail handling.
+ */
+struct QuantizedMatrix {
+  QuantizedMatrix() : rows(0), cols(0), padded_cols(0) {}
+  /**
+   * \param w The (rows x cols) weight matrix, in CPU memory
+   * \param transpose Quantise the transpose of w instead (e.g. a (d x |V|)
+   *                  embedding matrix used as a (|V| x d) output projection)
+   */
+  explicit QuantizedMatrix(const Tensor& w, bool transpose = false);
+  size_t byte_size() const { return values.size() + scales.size() * sizeof(float); }
+  unsigned rows, cols, padded_cols;
+  std::vector<int8_t> values;
+  std::vector<float> scales;
+};
+
+// y = W x (+ b)
+// W = a QuantizedMatrix (int8 with per-row scales)
+// x is quantised to int8 per column on the fly; int32 accumulation, then rescaled to fp32
+// rows (optional) restricts y (and b) to the given rows of W
+// CPU and inference only (no backward)
+struct Int8AffineTransform : public Node {
+  explicit Int8AffineTransform(const std::initializer_list<VariableIndex>& a, const QuantizedMatrix* pw, const std::vector<unsigned>& r) : Node(a), pW(pw), rows(r) {}
+  DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool supports_multibatch() const override { return true; }
+  size_t aux_storage_size() const override;
+  const QuantizedMatrix* pW;
+  std::vector<unsigned> rows;
+};
+
+} // namespace dynet
+
+#endif
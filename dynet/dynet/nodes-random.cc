@@ -26,7 +26,7 @@ Dim GaussianNoise::dim_forward(const vector<Dim>& xs) const {
 template<class MyDevice>
 void GaussianNoise::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
 
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   Tensor noise(dim, nullptr, fx.device, fx.mem_pool);
   noise.v = static_cast<float*>(scratch_allocator->allocate(noise.d.size() * sizeof(float)));
   TensorTools::randomize_normal(noise, 0, stddev);
@@ -11,6 +11,7 @@ namespace dynet {
 struct GaussianNoise : public Node {
   explicit GaussianNoise(const std::initializer_list<VariableIndex>& a, real stddev) : Node(a), stddev(stddev) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   virtual bool supports_multibatch() const override { return true; }
   real stddev;
 };
@@ -19,6 +20,7 @@ struct GaussianNoise : public Node {
 struct RandomNormal : public Node {
   explicit RandomNormal(const Dim& d) : dim(d) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   Dim dim;
 };
 
@@ -28,6 +30,7 @@ struct RandomBernoulli : public Node {
     DYNET_ASSERT(a.size() == 0, "RandomBernoulli doesn't accept nodes as input");
   }
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   Dim dim;
   real p;
   real scale;
@@ -39,6 +42,7 @@ struct RandomUniform : public Node {
     DYNET_ASSERT(a.size() == 0, "RandomUniform doesn't accept nodes as input");
   }
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   Dim dim;
   real left, right;
 };
@@ -49,6 +53,7 @@ struct RandomGumbel : public Node {
     DYNET_ASSERT(a.size() == 0, "RandomGumbel doesn't accept nodes as input");
   }
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool is_stochastic() const override { return true; }
   Dim dim;
   real mu, beta;
 };
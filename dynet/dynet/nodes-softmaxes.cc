@@ -39,7 +39,7 @@ std::vector<int> Softmax::autobatch_concat(const ComputationGraph & cg) const {
 template<class MyDevice>
 void Softmax::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
   DYNET_ARG_CHECK(xs.size() == 1, "Failed dimension check in Softmax::forward");
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   if(dimension==0){
 #ifdef __CUDACC__ // GPU impl
     Tensor z(Dim({xs[0]->d.cols()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
@@ -54,21 +54,21 @@ void Softmax::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>
     z.tb<1>().device(*dev.edevice) = fx.tb<2>().sum(red_dim);
     fx.tb<2>().device(*dev.edevice) = fx.tb<2>() / z.tvec().reshape(morph).broadcast(bcasts);
 #else // CPU impl
-    Tensor z(Dim({1}), nullptr, fx.device, DeviceMempool::FXS);
-    z.v = static_cast<float*>(scratch_allocator->allocate(z.d.size() * sizeof(float)));
-    Tensor m(Dim({1}), nullptr, fx.device, DeviceMempool::FXS);
-    m.v = static_cast<float*>(scratch_allocator->allocate(m.d.size() * sizeof(float)));
     unsigned size = xs[0]->d[0], num_cols = xs[0]->d[1] * xs[0]->d.bd;
-    Tensor col_x(Dim({xs[0]->d[0]}), (float*)xs[0]->v, fx.device, DeviceMempool::FXS);
-    Tensor col_fx(Dim({xs[0]->d[0]}), (float*)fx.v, fx.device, DeviceMempool::FXS);
-    for(size_t col = 0; col < num_cols; ++col) {
-      m.t<0>() = col_x.tvec().maximum();
-      col_fx.tvec() = (col_x.tvec() - m.v[0]).exp();
-      z.t<0>() = col_fx.tvec().sum();
-      col_fx.tvec() = col_fx.tvec() / z.v[0];
-      col_x.v += size;
-      col_fx.v += size;
-    }
+    // columns are independent, so they are split over the intra-op threads
+    dev.parallel_for(num_cols, 3 * size, [&](size_t begin, size_t end) {
+      Eigen::Tensor<float, 0> m, z;
+      Tensor col_x(Dim({size}), (float*)xs[0]->v + begin * size, fx.device, DeviceMempool::FXS);
+      Tensor col_fx(Dim({size}), (float*)fx.v + begin * size, fx.device, DeviceMempool::FXS);
+      for(size_t col = begin; col < end; ++col) {
+        m = col_x.tvec().maximum();
+        col_fx.tvec() = (col_x.tvec() - m()).exp();
+        z = col_fx.tvec().sum();
+        col_fx.tvec() = col_fx.tvec() / z();
+        col_x.v += size;
+        col_fx.v += size;
+      }
+    });
 #endif
   } else {
     Tensor z(Dim({xs[0]->d.rows()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
@@ -94,7 +94,7 @@ void Softmax::backward_dev_impl(const MyDevice & dev,
                              const Tensor& dEdf,
                              unsigned i,
                              Tensor& dEdxi) const {
-  AlignedMemoryPool* scratch_allocator = fx.device->pools[(int)DeviceMempool::SCS];
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
   Tensor z(Dim({fx.d.cols()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
   z.v = static_cast<float*>(scratch_allocator->allocate(z.d.size() * sizeof(float)));
   Eigen::array<int, 1> red_axis = {0};
@@ -106,15 +106,17 @@ void Softmax::backward_dev_impl(const MyDevice & dev,
     dEdxi.tb<2>().device(*dev.edevice) += (dEdf.tb<2>() - z.tvec().reshape(morph).broadcast(bcast)) * fx.tb<2>();
 #else // CPU impl
     unsigned size = xs[0]->d[0], num_cols = xs[0]->d[1] * xs[0]->d.bd;
-    Tensor col_fx(Dim({xs[0]->d[0]}), (float*)fx.v, fx.device, DeviceMempool::FXS);
-    Tensor col_dEdf(Dim({xs[0]->d[0]}), (float*)dEdf.v, fx.device, DeviceMempool::FXS);
-    Tensor col_dEdxi(Dim({xs[0]->d[0]}), (float*)dEdxi.v, fx.device, DeviceMempool::FXS);
-    for(size_t col = 0; col < num_cols; ++col) {
-      col_dEdxi.tvec() += (col_dEdf.tvec() - z.v[col]) * col_fx.tvec();
-      col_fx.v += size;
-      col_dEdf.v += size;
-      col_dEdxi.v += size;
-    }
+    dev.parallel_for(num_cols, 4 * size, [&](size_t begin, size_t end) {
+      Tensor col_fx(Dim({size}), (float*)fx.v + begin * size, fx.device, DeviceMempool::FXS);
+      Tensor col_dEdf(Dim({size}), (float*)dEdf.v + begin * size, fx.device, DeviceMempool::FXS);
+      Tensor col_dEdxi(Dim({size}), (float*)dEdxi.v + begin * size, fx.device, DeviceMempool::FXS);
+      for(size_t col = begin; col < end; ++col) {
+        col_dEdxi.tvec() += (col_dEdf.tvec() - z.v[col]) * col_fx.tvec();
+        col_fx.v += size;
+        col_dEdf.v += size;
+        col_dEdxi.v += size;
+      }
+    });
 #endif
   } else {
     Tensor z(Dim({fx.d.rows()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
@@ -129,6 +131,128 @@ void Softmax::backward_dev_impl(const MyDevice & dev,
 }
 DYNET_NODE_INST_DEV_IMPL(Softmax)
 
+// ************* MaskedSoftmax *************
+
+#ifndef __CUDACC__
+
+string MaskedSoftmax::as_string(const vector<string>& arg_names) const {
+  ostringstream s;
+  s << "masked_softmax(" << arg_names[0];
+  if (key_lengths.size()) s << ", key_lengths";
+  if (query_lengths.size()) s << ", query_lengths";
+  if (causal) s << ", causal";
+  s << ')';
+  return s.str();
+}
+
+Dim MaskedSoftmax::dim_forward(const vector<Dim>& xs) const {
+  DYNET_ARG_CHECK(xs.size() == 1, "Failed input count check in MaskedSoftmax");
+  DYNET_ARG_CHECK(xs[0].nd <= 2, "Bad input dimensions in MaskedSoftmax, must be 2 or fewer: " << xs);
+  DYNET_ARG_CHECK(key_lengths.size() <= xs[0].bd && query_lengths.size() <= xs[0].bd,
+                  "Too many lengths in MaskedSoftmax: " << key_lengths.size() << " key and " << query_lengths.size()
+                  << " query lengths for " << xs[0].bd << " batch elements");
+  return xs[0];
+}
+
+// aux_mem holds a copy of the lengths for the GPU implementation
+size_t MaskedSoftmax::aux_storage_size() const {
+  return (key_lengths.size() + query_lengths.size()) * sizeof(float);
+}
+
+#endif
+
+#ifndef __CUDACC__
+namespace {
+
+// number of visible (leading) rows of column col of MaskedSoftmax
+inline unsigned visible_rows(const vector<unsigned>& key_lengths, const vector<unsigned>& query_lengths, bool causal,
+                             unsigned rows, unsigned cols, size_t col) {
+  const unsigned n = col / cols, j = col % cols;
+  if (query_lengths.size() && j >= query_lengths[n % query_lengths.size()]) return 0;
+  unsigned nv = key_lengths.empty() ? rows : std::min(key_lengths[n % key_lengths.size()], rows);
+  return causal ? std::min(nv, j + 1) : nv;
+}
+
+} // namespace
+#endif
+
+template<class MyDevice>
+void MaskedSoftmax::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
+#ifdef __CUDACC__ // GPU impl: the mask is generated from the lengths, copied to aux_mem
+  float* klen = static_cast<float*>(aux_mem);
+  float* qlen = klen + key_lengths.size();
+  if (key_lengths.size())
+    TensorTools::set_elements(Tensor(Dim({(unsigned)key_lengths.size()}), klen, fx.device, DeviceMempool::FXS), vector<float>(key_lengths.begin(), key_lengths.end()));
+  if (query_lengths.size())
+    TensorTools::set_elements(Tensor(Dim({(unsigned)query_lengths.size()}), qlen, fx.device, DeviceMempool::FXS), vector<float>(query_lengths.begin(), query_lengths.end()));
+  auto x = xs[0]->tb<2>();
+  auto mask = x.generate(FLengthMask(klen, key_lengths.size(), qlen, query_lengths.size(), causal));
+  auto masked_x = x * mask + (mask - 1.f) * 1e30f;
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
+  Tensor z(Dim({xs[0]->d.cols()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
+  z.v = static_cast<float*>(scratch_allocator->allocate(z.d.size() * sizeof(float)));
+  Tensor m(Dim({xs[0]->d.cols()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
+  m.v = static_cast<float*>(scratch_allocator->allocate(m.d.size() * sizeof(float)));
+  Eigen::array<int, 1> red_dim = {0};
+  m.tb<1>().device(*dev.edevice) = masked_x.maximum(red_dim);
+  Eigen::array<int, 3> bcasts = {(int)xs[0]->d.rows(), 1, 1};
+  Eigen::array<int, 3> morph = {1, (int)z.d[0], (int)z.d.bd};
+  fx.tb<2>().device(*dev.edevice) = (masked_x - m.tvec().reshape(morph).broadcast(bcasts)).exp() * mask;
+  // fully masked columns sum to 0 and stay 0
+  z.tb<1>().device(*dev.edevice) = fx.tb<2>().sum(red_dim).cwiseMax(DYNET_DEVICE_MIN);
+  fx.tb<2>().device(*dev.edevice) = fx.tb<2>() / z.tvec().reshape(morph).broadcast(bcasts);
+  scratch_allocator->free();
+#else // CPU impl
+  const unsigned rows = xs[0]->d.rows(), cols = xs[0]->d.cols();
+  const size_t num_cols = (size_t)cols * xs[0]->d.bd;
+  // columns are independent, so they are split over the intra-op threads
+  dev.parallel_for(num_cols, 3 * rows, [&](size_t begin, size_t end) {
+    for (size_t col = begin; col < end; ++col) {
+      const unsigned n = visible_rows(key_lengths, query_lengths, causal, rows, cols, col);
+      Eigen::Map<const Eigen::VectorXf> x(xs[0]->v + col * rows, rows);
+      Eigen::Map<Eigen::VectorXf> y(fx.v + col * rows, rows);
+      y.tail(rows - n).setZero();
+      if (n == 0) continue;
+      const float m = x.head(n).maxCoeff();
+      y.head(n) = (x.head(n).array() - m).exp();
+      y.head(n) /= y.head(n).sum();
+    }
+  });
+#endif
+}
+
+template<class MyDevice>
+void MaskedSoftmax::backward_dev_impl(const MyDevice & dev,
+                             const vector<const Tensor*>& xs,
+                             const Tensor& fx,
+                             const Tensor& dEdf,
+                             unsigned i,
+                             Tensor& dEdxi) const {
+  // same as Softmax: masked entries have y = 0, hence no gradient
+#ifdef __CUDACC__ // GPU impl
+  AlignedMemoryPool* scratch_allocator = fx.device->scratch_pool();
+  Tensor z(Dim({fx.d.cols()},fx.d.bd), nullptr, fx.device, DeviceMempool::FXS);
+  z.v = static_cast<float*>(scratch_allocator->allocate(z.d.size() * sizeof(float)));
+  Eigen::array<int, 1> red_axis = {0};
+  z.tb<1>().device(*dev.edevice) = (fx.tb<2>() * dEdf.tb<2>()).sum(red_axis);
+  Eigen::array<int, 3> bcast = {(int)xs[0]->d.rows(), 1, 1};
+  Eigen::array<int, 3> morph = {1, (int)z.d[0], (int)z.d.bd};
+  dEdxi.tb<2>().device(*dev.edevice) += (dEdf.tb<2>() - z.tvec().reshape(morph).broadcast(bcast)) * fx.tb<2>();
+  scratch_allocator->free();
+#else // CPU impl
+  const unsigned rows = xs[0]->d.rows(), cols = xs[0]->d.cols();
+  const size_t num_cols = (size_t)cols * xs[0]->d.bd;
+  dev.parallel_for(num_cols, 4 * rows, [&](size_t begin, size_t end) {
+    for (size_t col = begin; col < end; ++col) {
+      const unsigned n = visible_rows(key_lengths, query_lengths, causal, rows, cols, col);
+      Eigen::Map<const Eigen::VectorXf> y(fx.v + col * rows, n), dy(dEdf.v + col * rows, n);
+      Eigen::Map<Eigen::VectorXf>(dEdxi.v + col * rows, n).array() += (dy.array() - y.dot(dy)) * y.array();
+    }
+  });
+#endif
+}
+DYNET_NODE_INST_DEV_IMPL(MaskedSoftmax)
+
 
 // ************* LogSoftmax *************
 
@@ -173,13 +297,15 @@ void LogSoftmax::forward_dev_impl(const MyDevice & dev, const vector<const Tenso
     fx.tb<2>().device(*dev.edevice) = xs[0]->tb<2>() - z.tvec().reshape(morph).broadcast(bcasts);
 #else // CPU impl
     unsigned size = xs[0]->d[0], num_cols = xs[0]->d[1] * xs[0]->d.bd;
-    Tensor col_fx(Dim({xs[0]->d[0]}), (float*)fx.v, fx.device, DeviceMempool::FXS);
-    Tensor col_x(Dim({xs[0]->d[0]}), (float*)xs[0]->v, fx.device, DeviceMempool::FXS);
-    for(size_t col = 0; col < num_cols; ++col) {
-      col_fx.tvec() = col_x.tvec() - z.v[col];
-      col_x.v += size;
-      col_fx.v += size;
-    }
+    dev.parallel_for(num_cols, 2 * size, [&](size_t begin, size_t end) {
+      Tensor col_fx(Dim({size}), (float*)fx.v + begin * size, fx.device, DeviceMempool::FXS);
+      Tensor col_x(Dim({size}), (float*)xs[0]->v + begin * size, fx.device, DeviceMempool::FXS);
+      for(size_t col = begin; col < end; ++col) {
+        col_fx.tvec() = col_x.tvec() - z.v[col];
+        col_x.v += size;
+        col_fx.v += size;
+      }
+    });
 #endif
   }
 }
@@ -200,15 +326,17 @@ void LogSoftmax::backward_dev_impl(const MyDevice & dev,
   dEdxi.tb<2>().device(*dev.edevice) += fx.tb<2>().exp() * -z.tvec().reshape(morph).broadcast(bcast) + dEdf.tb<2>();
 #else // CPU impl
   unsigned size = xs[0]->d[0], num_cols = xs[0]->d[1] * xs[0]->d.bd;
-  Tensor col_fx(Dim({xs[0]->d[0]}), (float*)fx.v, fx.device, DeviceMempool::FXS);
-  Tensor col_dEdf(Dim({xs[0]->d[0]}), (float*)dEdf.v, fx.device, DeviceMempool::FXS);
-  Tensor col_dEdxi(Dim({xs[0]->d[0]}), (float*)dEdxi.v, fx.device, DeviceMempool::FXS);
-  for(size_t col = 0; col < num_cols; ++col) {
-    col_dEdxi.tvec() += (col_fx.tvec().exp() * -z.v[col]) + col_dEdf.tvec();
-    col_fx.v += size;
-    col_dEdf.v += size;
-    col_dEdxi.v += size;
-  }
+  dev.parallel_for(num_cols, 4 * size, [&](size_t begin, size_t end) {
+    Tensor col_fx(Dim({size}), (float*)fx.v + begin * size, fx.device, DeviceMempool::FXS);
+    Tensor col_dEdf(Dim({size}), (float*)dEdf.v + begin * size, fx.device, DeviceMempool::FXS);
+    Tensor col_dEdxi(Dim({size}), (float*)dEdxi.v + begin * size, fx.device, DeviceMempool::FXS);
+    for(size_t col = begin; col < end; ++col) {
+      col_dEdxi.tvec() += (col_fx.tvec().exp() * -z.v[col]) + col_dEdf.tvec();
+      col_fx.v += size;
+      col_dEdf.v += size;
+      col_dEdxi.v += size;
+    }
+  });
 #endif
 }
 DYNET_NODE_INST_DEV_IMPL(LogSoftmax)
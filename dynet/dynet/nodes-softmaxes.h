@@ -26,6 +26,21 @@ struct Softmax : public Node {
   unsigned dimension;
 };
 
+// y = softmax over the rows of each column of x ((Lx, Ly), N), restricted to the visible entries
+// batch element n sees rows i < key_lengths[n % key_lengths.size()] (all if empty) of the columns
+// j < query_lengths[n % query_lengths.size()] (all if empty), and only i <= j if causal
+// masked entries of y are 0; no mask tensors are needed
+struct MaskedSoftmax : public Node {
+  explicit MaskedSoftmax(const std::initializer_list<VariableIndex>& a, const std::vector<unsigned>& key_lengths,
+                         const std::vector<unsigned>& query_lengths, bool causal)
+      : Node(a), key_lengths(key_lengths), query_lengths(query_lengths), causal(causal) {}
+  DYNET_NODE_DEFINE_DEV_IMPL()
+  size_t aux_storage_size() const override;
+  virtual bool supports_multibatch() const override { return true; }
+  std::vector<unsigned> key_lengths, query_lengths;
+  bool causal;
+};
+
 // z = \sum_j \exp (x_i)_j
 // y_i = (x_1)_i - \log z
 struct LogSoftmax : public Node {
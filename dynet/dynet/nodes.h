@@ -4,12 +4,14 @@
 #include "dynet/nodes-arith-cwise.h"
 #include "dynet/nodes-arith-sum.h"
 #include "dynet/nodes-arith-unary.h"
+#include "dynet/nodes-attention.h"
 #include "dynet/nodes-concat.h"
 #include "dynet/nodes-const.h"
 #include "dynet/nodes-contract.h"
 #include "dynet/nodes-conv.h"
 #include "dynet/nodes-conv2d.h"
 #include "dynet/nodes-dropout.h"
+#include "dynet/nodes-feedforward.h"
 #include "dynet/nodes-flow.h"
 #include "dynet/nodes-hinge.h"
 #include "dynet/nodes-linalg.h"
@@ -23,6 +25,7 @@
 #include "dynet/nodes-normalization.h"
 #include "dynet/nodes-norms.h"
 #include "dynet/nodes-pickneglogsoftmax.h"
+#include "dynet/nodes-quantize.h"
 #include "dynet/nodes-random.h"
 #include "dynet/nodes-select.h"
 #include "dynet/nodes-similarities.h"
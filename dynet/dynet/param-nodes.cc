@@ -28,6 +28,15 @@ Dim ConstParameterNode::dim_forward(const vector<Dim>& xs) const {
   return dim;
 }
 
+// parameters are read in place unless they need to be scaled by the weight decay
+bool ConstParameterNode::forward_aliases_value() const {
+  if(params.p != nullptr)
+    return params.current_weight_decay() == 1.f;
+  else if(lparams.p != nullptr)
+    return lparams.current_weight_decay() == 1.f;
+  return false;
+}
+
 string ParameterNode::as_string(const vector<string>& arg_names) const {
   ostringstream s;
   s << "parameters(" << dim << ") @ " << &params.get_storage();
@@ -39,6 +48,14 @@ Dim ParameterNode::dim_forward(const vector<Dim>& xs) const {
   return dim;
 }
 
+bool ParameterNode::forward_aliases_value() const {
+  if(params.p != nullptr)
+    return params.current_weight_decay() == 1.f;
+  else if(lparams.p != nullptr)
+    return lparams.current_weight_decay() == 1.f;
+  return false;
+}
+
 void ParameterNode::accumulate_grad(const Tensor& g) {
   if(params.p != nullptr)
     params.get_storage().accumulate_grad(g);
@@ -154,6 +171,11 @@ size_t LookupNode::aux_storage_size() const {
   return dim.bd * sizeof(unsigned);
 }
 
+// only a single looked-up vector is contiguous in the parameter storage
+bool LookupNode::forward_aliases_value() const {
+  return pindex != nullptr && params.current_weight_decay() == 1.f;
+}
+
 string LookupNode::as_string(const vector<string>& arg_names) const {
   ostringstream s;
   s << "lookup_parameters(|x|=" << params.get_storage().values.size() << " --> " << dim << ") @ " << &params.get_storage();
@@ -178,7 +200,10 @@ void LookupNode::accumulate_grad(const Tensor& g) {
 template<class MyDevice>
 void ConstParameterNode::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
   DYNET_ASSERT(xs.size() == 0, "Failed dimension check in FUNCNAME");
-  if(params.p != nullptr)
+  if(forward_aliases_value()) {
+    fx.v = (params.p != nullptr) ? params.get_storage().values.v : lparams.get_storage().all_values.v;
+    fx.mem_pool = DeviceMempool::PS;
+  } else if(params.p != nullptr)
     fx.tvec().device(*dev.edevice) = params.get_storage().values.tvec() * params.current_weight_decay();
   else if(lparams.p != nullptr)
     fx.tvec().device(*dev.edevice) = lparams.get_storage().all_values.tvec() * lparams.current_weight_decay();
@@ -200,12 +225,10 @@ DYNET_NODE_INST_DEV_IMPL(ConstParameterNode)
 template<class MyDevice>
 void ParameterNode::forward_dev_impl(const MyDevice & dev, const vector<const Tensor*>& xs, Tensor& fx) const {
   DYNET_ASSERT(xs.size() == 0, "Failed dimension check in FUNCNAME");
-// TODO
-//  if (params->not_regularized) {
-//    fx.v = params->values.v;
-//    return;
-//  }
-  if(params.p != nullptr)
+  if(forward_aliases_value()) {
+    fx.v = (params.p != nullptr) ? params.get_storage().values.v : lparams.get_storage().all_values.v;
+    fx.mem_pool = DeviceMempool::PS;
+  } else if(params.p != nullptr)
     fx.tvec().device(*dev.edevice) = params.get_storage().values.tvec() * params.current_weight_decay();
   else if(lparams.p != nullptr)
     fx.tvec().device(*dev.edevice) = lparams.get_storage().all_values.tvec() * lparams.current_weight_decay();
@@ -307,7 +330,12 @@ void LookupNode::forward_dev_impl(const MyDevice & dev, const vector<const Tenso
     DYNET_ARG_CHECK(*pindex < params.get_storage().values.size(),
                     "Out-of-bounds attempt to access index " << *pindex << " for LookupParameter of size " << params.get_storage().values.size());
     DYNET_ASSERT(fx.d.batch_elems() == 1, "Batch dimension > 1 for lookup with single index");
-    fx.tvec().device(*dev.edevice) = params.get_storage().values[*pindex].tvec() * params.current_weight_decay();
+    if(forward_aliases_value()) {
+      fx.v = params.get_storage().values[*pindex].v;
+      fx.mem_pool = DeviceMempool::PS;
+    } else {
+      fx.tvec().device(*dev.edevice) = params.get_storage().values[*pindex].tvec() * params.current_weight_decay();
+    }
   } else {
     DYNET_ASSERT(pindices, "Have neither index nor index vector in LookupNode");
     DYNET_ARG_CHECK(fx.d.batch_elems() == pindices->size(),
@@ -16,6 +16,7 @@ struct ParameterNode : public ParameterNodeBase {
   explicit ParameterNode(const Parameter & p) : dim(p.get_storage().dim), params(p) {}
   explicit ParameterNode(const LookupParameter & lp) : dim(lp.get_storage().all_dim), lparams(lp) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool forward_aliases_value() const override;
   void accumulate_grad(const Tensor& g) override;
   Dim dim;
   Parameter params;
@@ -27,6 +28,7 @@ struct ConstParameterNode : public Node {
   explicit ConstParameterNode(const Parameter & p) : dim(p.get_storage().dim), params(p) {}
   explicit ConstParameterNode(const LookupParameter & lp) : dim(lp.get_storage().all_dim), lparams(lp) {}
   DYNET_NODE_DEFINE_DEV_IMPL()
+  virtual bool forward_aliases_value() const override;
   Dim dim;
   Parameter params;
   LookupParameter lparams;
@@ -88,6 +90,7 @@ struct LookupNode : public ParameterNodeBase {
   LookupNode(LookupParameter p, const std::vector<unsigned>* pindices) : dim(p.get_storage().dim), index(), pindex(), indices(), pindices(pindices), params(p) { dim.bd = pindices->size(); }
   DYNET_NODE_DEFINE_DEV_IMPL()
   virtual bool supports_multibatch() const override { return true; }  
+  virtual bool forward_aliases_value() const override;
   virtual int autobatch_sig(const ComputationGraph &cg, SigMap &sm) const override;
   virtual std::vector<int> autobatch_concat(const ComputationGraph & cg) const override;
   virtual Node* autobatch_pseudo_node(const ComputationGraph & cg,
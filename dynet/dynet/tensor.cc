@@ -215,7 +215,8 @@ void TensorTools::identity(Tensor& val) {
 
 void TensorTools::randomize_bernoulli(Tensor& val, real p, real scale) {
   bernoulli_distribution distribution(p);
-  auto b = [&] {return distribution(*rndeng) * scale;};
+  std::mt19937& engine = random_engine();
+  auto b = [&] {return distribution(engine) * scale;};
   if (val.device->type == DeviceType::CPU) {
     generate(val.v, val.v + val.d.size(), b);
 #if HAVE_CUDA
@@ -231,7 +232,8 @@ void TensorTools::randomize_bernoulli(Tensor& val, real p, real scale) {
 
 void TensorTools::randomize_normal(Tensor& val, real mean, real stddev) {
   normal_distribution<real> distribution(mean, stddev);
-  auto b = [&] {return distribution(*rndeng);};
+  std::mt19937& engine = random_engine();
+  auto b = [&] {return distribution(engine);};
   if (val.device->type == DeviceType::CPU) {
     generate(val.v, val.v + val.d.size(), b);
 #if HAVE_CUDA
@@ -247,7 +249,8 @@ void TensorTools::randomize_normal(Tensor& val, real mean, real stddev) {
 
 void TensorTools::randomize_uniform(Tensor& val, real left, real right) {
   uniform_real_distribution<real> distribution(left, right);
-  auto b = [&] {return distribution(*rndeng);};
+  std::mt19937& engine = random_engine();
+  auto b = [&] {return distribution(engine);};
   if (val.device->type == DeviceType::CPU) {
     generate(val.v, val.v + val.d.size(), b);
 #if HAVE_CUDA
@@ -287,7 +290,7 @@ void TensorTools::randomize_orthonormal(Tensor& val, real scale) {
 
 real rand01() {
   uniform_real_distribution<real> distribution(0, 1);
-  return distribution(*rndeng);
+  return distribution(random_engine());
 }
 
 int rand0n(int n) {
@@ -299,7 +302,7 @@ int rand0n(int n) {
 
 real rand_normal() {
   normal_distribution<real> distribution(0, 1);
-  return distribution(*rndeng);
+  return distribution(random_engine());
 }
 
 #endif
@@ -408,13 +411,15 @@ void TensorTools::logsumexp_dev(const MyDevice & dev, const Tensor& x, Tensor &
     z.tb<1>().device(*dev.edevice) = (x.tb<2>() - m.tb<2>().reshape(morph).broadcast(bcast)).exp().sum(red_axis);
     z.tb<1>().device(*dev.edevice) = z.tb<1>().log() + m.tb<1>();
 #else
-    auto miter = m.v;
-    for(size_t b = 0; b < x.d.bd; ++b) {
-      for(size_t i = 0; i < x.d[1]; ++i, ++miter) {
-        z.tb<1>().chip<1>(b).chip<0>(i).device(*dev.edevice) = (x.tb<2>().chip<2>(b).chip(i,other_axis) - *miter).exp().sum();
-        z.tb<1>().chip<1>(b).chip<0>(i).device(*dev.edevice) = z.tb<1>().chip<1>(b).chip<0>(i).log() + *miter;
+    // one reduction per (column, batch element), split over the intra-op threads
+    const size_t n_other = x.d[other_axis];
+    dev.parallel_for(n_other * x.d.bd, x.d[axis], [&](size_t begin, size_t end) {
+      for(size_t j = begin; j < end; ++j) {
+        size_t b = j / n_other, i = j % n_other;
+        z.tb<1>().chip<1>(b).chip<0>(i) = (x.tb<2>().chip<2>(b).chip(i,other_axis) - m.v[j]).exp().sum();
+        z.tb<1>().chip<1>(b).chip<0>(i) = z.tb<1>().chip<1>(b).chip<0>(i).log() + m.v[j];
       }
-    }
+    });
 #endif
   }
 }
@@ -443,8 +448,10 @@ IndexTensor TensorTools::argmax_dev(const MyDevice & dev, const Tensor& v, unsig
     DYNET_RUNTIME_ERR("Currently do not support num > 1 in argmax");
   DYNET_ARG_CHECK(v.mem_pool != DeviceMempool::NONE, "Input Tensor to TensorTools::argmax must be associated with a memory pool.");
   Dim ids_dim = v.d; ids_dim.d[dim] = num;
-  IndexTensor ids(ids_dim, nullptr, v.device, v.mem_pool);
-  AlignedMemoryPool* pool = v.device->pools[(size_t)v.mem_pool];
+  // Allocate from the forward pool of the current graph rather than v's own pool:
+  // v may alias parameter values (PS), which is never reset
+  IndexTensor ids(ids_dim, nullptr, v.device, DeviceMempool::FXS);
+  AlignedMemoryPool* pool = v.device->pool(DeviceMempool::FXS);
   ids.v = static_cast<Eigen::DenseIndex*>(pool->allocate(ids_dim.size() * sizeof(Eigen::DenseIndex)));
   ids.tb<3>().device(*dev.edevice) = v.tb<4>().argmax(dim);
   return ids;
@@ -474,11 +481,11 @@ IndexTensor TensorTools::categorical_sample_log_prob_dev(const MyDevice & dev, c
     DYNET_RUNTIME_ERR("Currently do not support num > 1 in categorical_sample_log_prob");
   DYNET_ARG_CHECK(v.mem_pool != DeviceMempool::NONE, "Input Tensor to TensorTools::argmax must be associated with a memory pool.");
   Dim ids_dim = v.d; ids_dim.d[dim] = num;
-  IndexTensor ids(ids_dim, nullptr, v.device, v.mem_pool);
-  AlignedMemoryPool* scratch_allocator = v.device->pools[(int)DeviceMempool::SCS];
+  IndexTensor ids(ids_dim, nullptr, v.device, DeviceMempool::SCS);
+  AlignedMemoryPool* scratch_allocator = v.device->scratch_pool();
   ids.v = static_cast<Eigen::DenseIndex*>(scratch_allocator->allocate(ids_dim.size() * sizeof(Eigen::DenseIndex)));
   Dim copy_dim = v.d; // TODO: make this match num to enable num
-  Tensor copy(copy_dim, nullptr, v.device, v.mem_pool);
+  Tensor copy(copy_dim, nullptr, v.device, DeviceMempool::SCS);
   copy.v = static_cast<float*>(scratch_allocator->allocate(v.d.size() * sizeof(float)));
   TensorTools::randomize_uniform(copy);
   ids.tb<3>().device(*dev.edevice) = (v.tb<4>() - (-copy.tb<4>().log()).log()).argmax(dim);
@@ -30,6 +30,10 @@
 #include <Eigen/Eigen>
 #endif
 
+// the CPU device is an Eigen::ThreadPoolDevice
+#ifndef EIGEN_USE_THREADS
+#define EIGEN_USE_THREADS
+#endif
 #include <unsupported/Eigen/CXX11/Tensor>
 
 namespace dynet {
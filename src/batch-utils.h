@@ -74,6 +74,82 @@ inline size_t create_minibatches(const WordIdCorpus& cor
 	return train_ids.size();
 }
 
+// bucketed batching: sentences are grouped by (source, target) length buckets of width bucket_width, 
+// and each bucket is cut into minibatches whose padded source and target token counts stay within separate budgets
+inline size_t create_bucketed_minibatches(const WordIdCorpus& cor
+	, size_t src_token_budget, size_t trg_token_budget
+	, unsigned bucket_width
+	, std::vector<WordIdSentences> & train_src_minibatch
+	, std::vector<WordIdSentences> & train_trg_minibatch
+	, std::vector<size_t> & train_ids_minibatch) 
+{
+	cerr << endl << "Creating bucketed minibatches for training data (using token budgets (s & t)=" << src_token_budget << " & " << trg_token_budget << ", bucket width=" << bucket_width << ")..." << endl;
+
+	if (bucket_width == 0) bucket_width = 1;
+
+	train_src_minibatch.clear();
+	train_trg_minibatch.clear();
+
+	// sort by bucket, then by lengths within a bucket
+	std::vector<size_t> train_ids(cor.size());
+	std::iota(train_ids.begin(), train_ids.end(), 0);
+	auto bucket_key = [&](size_t i) {
+		return std::make_tuple(std::get<0>(cor[i]).size() / bucket_width, std::get<1>(cor[i]).size() / bucket_width
+			, std::get<0>(cor[i]).size(), std::get<1>(cor[i]).size());
+	};
+	std::stable_sort(train_ids.begin(), train_ids.end(), [&](size_t i1, size_t i2) { return bucket_key(i1) < bucket_key(i2); });
+
+	WordIdSentences train_src_next, train_trg_next;
+	size_t max_src_len = 0, max_trg_len = 0;
+	for (size_t i = 0; i < train_ids.size(); i++) {
+		const WordIdSentence& src = std::get<0>(cor[train_ids[i]]);
+		const WordIdSentence& trg = std::get<1>(cor[train_ids[i]]);
+
+		// cut the current minibatch if this sentence starts a new bucket or would exceed either padded token budget
+		if (train_src_next.size()) {
+			size_t new_src_len = std::max(max_src_len, src.size()), new_trg_len = std::max(max_trg_len, trg.size());
+			if (src.size() / bucket_width != train_src_next.back().size() / bucket_width
+				|| trg.size() / bucket_width != train_trg_next.back().size() / bucket_width
+				|| (train_src_next.size() + 1) * new_src_len > src_token_budget
+				|| (train_trg_next.size() + 1) * new_trg_len > trg_token_budget)
+			{
+				train_src_minibatch.push_back(train_src_next);
+				train_src_next.clear();
+				train_trg_minibatch.push_back(train_trg_next);
+				train_trg_next.clear();
+				max_src_len = max_trg_len = 0;
+			}
+		}
+
+		train_src_next.push_back(src);
+		train_trg_next.push_back(trg);
+		max_src_len = std::max(max_src_len, src.size());
+		max_trg_len = std::max(max_trg_len, trg.size());
+	}
+
+	if (train_trg_next.size()) {
+		train_src_minibatch.push_back(train_src_next);
+		train_trg_minibatch.push_back(train_trg_next);
+	}
+
+	// Create a sentence list for this minibatch
+	train_ids_minibatch.resize(train_src_minibatch.size());
+	std::iota(train_ids_minibatch.begin(), train_ids_minibatch.end(), 0);
+
+	return train_ids.size();
+}
+
+// count real tokens and padded tokens (batch size x max length) of a minibatch
+inline void count_padding(const WordIdSentences& sents, size_t& real_toks, size_t& padded_toks)
+{
+	size_t max_len = 0;
+	for (auto& sent : sents) {
+		real_toks += sent.size();
+		max_len = std::max(max_len, sent.size());
+	}
+	padded_toks += max_len * sents.size();
+}
+
 // for monolingual data
 inline void create_minibatches(const WordIdSentences& traincor,
 	size_t max_size, 
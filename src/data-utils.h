@@ -2,6 +2,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #include "dynet/dict.h"
 
@@ -19,6 +27,20 @@ WordIdSentences read_corpus(const string &filename
 	, bool cid=true/*corpus id, 1:train;0:otherwise*/
 	, unsigned slen=0, bool r2l_target=false);
 
+// binary corpus cache: a pre-tokenised parallel corpus together with its vocabularies, memory-mapped on loading
+// the cache is rebuilt whenever the corpus, the external vocabulary files (if any) or the settings it was built with change
+bool load_corpus_cache(const string &cache_file, const string &filename
+	, WordIdCorpus& corpus
+	, dynet::Dict& sd, dynet::Dict& td
+	, unsigned slen=0, bool r2l_target=false
+	, bool shared_vocab=false, const string &src_vocab_file="", const string &tgt_vocab_file="");
+
+void save_corpus_cache(const string &cache_file, const string &filename
+	, const WordIdCorpus& corpus
+	, const dynet::Dict& sd, const dynet::Dict& td
+	, unsigned slen=0, bool r2l_target=false
+	, bool shared_vocab=false, const string &src_vocab_file="", const string &tgt_vocab_file="");
+
 WordIdCorpus read_corpus(const string &filename
 	, dynet::Dict* sd, dynet::Dict* td
 	, bool cid
@@ -146,3 +168,206 @@ WordIdSentences read_corpus(const string &filename
 
 	return corpus;
 }
+
+// Layout: CorpusCacheHeader | uint64 offsets[2 * num_sents + 1] | int32 tokens[num_tokens] | source vocabulary | target vocabulary
+// Sentence i has its source in tokens[offsets[2i], offsets[2i+1]) and its target in tokens[offsets[2i+1], offsets[2i+2]).
+// Each vocabulary is stored as uint32 size followed by (uint32 length, characters) for each word in id order.
+struct CorpusCacheHeader{
+	char magic[8];// "TFCORPUS"
+	uint32_t version;
+	uint32_t max_seq_len;// length limit applied when building the cache
+	uint32_t r2l_target;
+	uint32_t shared_vocab;// source and target sides share one vocabulary (--shared-embeddings)
+	uint64_t corpus_file_size;// size and modification time of the text corpus the cache was built from
+	int64_t corpus_file_mtime;
+	uint64_t src_vocab_file_size;// size and modification time of the external vocabulary files; 0 if the vocabularies were built from the corpus
+	int64_t src_vocab_file_mtime;
+	uint64_t tgt_vocab_file_size;
+	int64_t tgt_vocab_file_mtime;
+	uint64_t num_sents;
+	uint64_t num_tokens;
+	uint64_t vocab_offset;// byte offset of the vocabularies
+};
+
+static const char CORPUS_CACHE_MAGIC[8] = {'T', 'F', 'C', 'O', 'R', 'P', 'U', 'S'};
+static const uint32_t CORPUS_CACHE_VERSION = 2;
+
+// size and modification time of a file; zeros if no file is given or it does not exist
+void get_file_stamp(const string &filename, uint64_t& size, int64_t& mtime)
+{
+	struct stat st;
+	size = 0; mtime = 0;
+	if ("" != filename && stat(filename.c_str(), &st) == 0){
+		size = st.st_size;
+		mtime = st.st_mtime;
+	}
+}
+
+bool load_corpus_cache(const string &cache_file, const string &filename
+	, WordIdCorpus& corpus
+	, dynet::Dict& sd, dynet::Dict& td
+	, unsigned slen, bool r2l_target
+	, bool shared_vocab, const string &src_vocab_file, const string &tgt_vocab_file)
+{
+#ifdef _WIN32
+	// no mmap there, read the whole cache instead
+	ifstream in(cache_file, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+	if (!in) return false;// no cache yet
+	size_t cache_size = in.tellg();
+	if (cache_size < sizeof(CorpusCacheHeader)) return false;
+	std::vector<char> buffer(cache_size);
+	in.seekg(0);
+	if (!in.read(buffer.data(), cache_size)) return false;
+	const char* base = buffer.data();
+	auto release = [](){};
+#else
+	int fd = open(cache_file.c_str(), O_RDONLY);
+	if (fd < 0) return false;// no cache yet
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CorpusCacheHeader)){
+		close(fd);
+		return false;
+	}
+	size_t cache_size = st.st_size;
+	void* addr = mmap(nullptr, cache_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) return false;
+	const char* base = static_cast<const char*>(addr);
+	auto release = [addr, cache_size](){ munmap(addr, cache_size); };
+#endif
+
+	CorpusCacheHeader header;
+	memcpy(&header, base, sizeof(header));
+	struct stat corpus_st;
+	uint64_t src_vocab_size, tgt_vocab_size;
+	int64_t src_vocab_mtime, tgt_vocab_mtime;
+	get_file_stamp(src_vocab_file, src_vocab_size, src_vocab_mtime);
+	get_file_stamp(tgt_vocab_file, tgt_vocab_size, tgt_vocab_mtime);
+	bool stale = memcmp(header.magic, CORPUS_CACHE_MAGIC, sizeof(CORPUS_CACHE_MAGIC)) != 0
+		|| header.version != CORPUS_CACHE_VERSION
+		|| header.max_seq_len != slen || header.r2l_target != (uint32_t)r2l_target
+		|| header.shared_vocab != (uint32_t)shared_vocab
+		|| header.src_vocab_file_size != src_vocab_size || header.src_vocab_file_mtime != src_vocab_mtime
+		|| header.tgt_vocab_file_size != tgt_vocab_size || header.tgt_vocab_file_mtime != tgt_vocab_mtime
+		|| (stat(filename.c_str(), &corpus_st) == 0 
+			&& (header.corpus_file_size != (uint64_t)corpus_st.st_size || header.corpus_file_mtime != (int64_t)corpus_st.st_mtime))
+		|| header.vocab_offset > cache_size
+		|| sizeof(CorpusCacheHeader) + sizeof(uint64_t) * (2 * header.num_sents + 1) + sizeof(int32_t) * header.num_tokens > header.vocab_offset;
+	if (stale){
+		cerr << "Corpus cache " << cache_file << " does not match " << filename << " or the current settings; rebuilding it..." << endl;
+		release();
+		return false;
+	}
+
+	// vocabularies
+	const char* p_vocab = base + header.vocab_offset, *p_end = base + cache_size;
+	std::vector<std::string> v_words[2];
+	for (auto& words : v_words){
+		uint32_t size = 0, len = 0;
+		if ((size_t)(p_end - p_vocab) < sizeof(size)) { stale = true; break; }
+		memcpy(&size, p_vocab, sizeof(size)); p_vocab += sizeof(size);
+		words.reserve(size);
+		for (uint32_t w = 0; w < size; w++){
+			if ((size_t)(p_end - p_vocab) < sizeof(len)) { stale = true; break; }
+			memcpy(&len, p_vocab, sizeof(len)); p_vocab += sizeof(len);
+			if ((size_t)(p_end - p_vocab) < len) { stale = true; break; }
+			words.push_back(std::string(p_vocab, len)); p_vocab += len;
+		}
+	}
+	// with external vocabularies, the cached ones must be identical
+	if ((sd.is_frozen() && sd.get_words() != v_words[0]) || (td.is_frozen() && td.get_words() != v_words[1])) stale = true;
+	if (stale){
+		cerr << "Corpus cache " << cache_file << " is truncated or its vocabularies do not match; rebuilding it..." << endl;
+		release();
+		return false;
+	}
+
+	// sentences are copied straight out of the mapped token array
+	const uint64_t* offsets = reinterpret_cast<const uint64_t*>(base + sizeof(CorpusCacheHeader));
+	const int32_t* tokens = reinterpret_cast<const int32_t*>(offsets + 2 * header.num_sents + 1);
+	corpus.clear();
+	corpus.reserve(header.num_sents);
+	unsigned int max_src_len = 0, max_tgt_len = 0;
+	for (uint64_t i = 0; i < header.num_sents; i++){
+		corpus.push_back(WordIdSentencePair(WordIdSentence(tokens + offsets[2 * i], tokens + offsets[2 * i + 1])
+			, WordIdSentence(tokens + offsets[2 * i + 1], tokens + offsets[2 * i + 2])));
+		max_src_len = std::max(max_src_len, (unsigned int)(offsets[2 * i + 1] - offsets[2 * i]));
+		max_tgt_len = std::max(max_tgt_len, (unsigned int)(offsets[2 * i + 2] - offsets[2 * i + 1]));
+	}
+	uint64_t stoks = 0;
+	for (uint64_t i = 0; i < header.num_sents; i++) stoks += offsets[2 * i + 1] - offsets[2 * i];
+
+	release();
+
+	sd = dynet::Dict(); td = dynet::Dict();
+	for (auto& word : v_words[0]) sd.convert(word);
+	for (auto& word : v_words[1]) td.convert(word);
+	sd.freeze();
+	td.freeze();
+
+	cerr << header.num_sents << " lines, " << stoks << " & " << header.num_tokens - stoks << " tokens (s & t), " << "max length (s & t): " << max_src_len << " & " << max_tgt_len << ", " << sd.size() << " & " << td.size() << " types (from cache " << cache_file << ")" << endl;
+
+	return true;
+}
+
+void save_corpus_cache(const string &cache_file, const string &filename
+	, const WordIdCorpus& corpus
+	, const dynet::Dict& sd, const dynet::Dict& td
+	, unsigned slen, bool r2l_target
+	, bool shared_vocab, const string &src_vocab_file, const string &tgt_vocab_file)
+{
+	CorpusCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CORPUS_CACHE_MAGIC, sizeof(CORPUS_CACHE_MAGIC));
+	header.version = CORPUS_CACHE_VERSION;
+	header.max_seq_len = slen;
+	header.r2l_target = r2l_target;
+	header.shared_vocab = shared_vocab;
+	get_file_stamp(src_vocab_file, header.src_vocab_file_size, header.src_vocab_file_mtime);
+	get_file_stamp(tgt_vocab_file, header.tgt_vocab_file_size, header.tgt_vocab_file_mtime);
+	struct stat corpus_st;
+	if (stat(filename.c_str(), &corpus_st) == 0){
+		header.corpus_file_size = corpus_st.st_size;
+		header.corpus_file_mtime = corpus_st.st_mtime;
+	}
+	header.num_sents = corpus.size();
+
+	std::vector<uint64_t> offsets(1, 0);
+	offsets.reserve(2 * corpus.size() + 1);
+	for (auto& sent : corpus){
+		offsets.push_back(offsets.back() + std::get<0>(sent).size());
+		offsets.push_back(offsets.back() + std::get<1>(sent).size());
+	}
+	header.num_tokens = offsets.back();
+	header.vocab_offset = sizeof(CorpusCacheHeader) + sizeof(uint64_t) * offsets.size() + sizeof(int32_t) * header.num_tokens;
+
+	// write to a temporary file first so that an interrupted run never leaves a truncated cache behind
+	std::string tmp_file = cache_file + ".tmp";
+	ofstream out(tmp_file, std::ios_base::out | std::ios_base::binary);
+	if (!out){
+		cerr << "[WARNING] - Could not write corpus cache " << cache_file << endl;
+		return;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(offsets.data()), sizeof(uint64_t) * offsets.size());
+	for (auto& sent : corpus){
+		for (const WordIdSentence* p_sent : {&std::get<0>(sent), &std::get<1>(sent)})
+			out.write(reinterpret_cast<const char*>(p_sent->data()), sizeof(int32_t) * p_sent->size());
+	}
+	for (const dynet::Dict* p_dict : {&sd, &td}){
+		uint32_t size = p_dict->size();
+		out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		for (auto& word : p_dict->get_words()){
+			uint32_t len = word.size();
+			out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+			out.write(word.data(), len);
+		}
+	}
+	out.close();
+	if (!out || rename(tmp_file.c_str(), cache_file.c_str()) != 0){
+		cerr << "[WARNING] - Could not write corpus cache " << cache_file << endl;
+		return;
+	}
+
+	cerr << "Saved pre-tokenised corpus cache to " << cache_file << endl;
+}
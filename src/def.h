@@ -10,6 +10,7 @@
 #include "dynet/dict.h"
 #include "dynet/expr.h"
 #include "dynet/lstm.h"
+#include "dynet/devices.h"
 
 // STL
 #include <algorithm>
@@ -50,6 +51,22 @@ namespace transformer {
 #define USE_LECUN_DIST_PARAM_INIT // use Le Cun's uniform distribution for LinearLayer params initialisation (arguably faster convergence)
 #define USE_KEY_QUERY_MASKINGS // use key and query maskings in multi-head attention
 #define USE_LINEAR_TRANSFORMATION_BROADCASTING // use linear transformation broadcasting at final output layer (much faster)
+#ifdef MULTI_HEAD_ATTENTION_PARALLEL
+#define USE_FUSED_MULTI_HEAD_ATTENTION // compute all heads of multi-head attention in a single dynet::multi_head_attention node (CPU only, see use_cpu_fused_nodes)
+#define MULTI_HEAD_ATTENTION_KEY_BLOCK_SIZE 128 // the fused attention node processes longer key sequences in blocks of this many keys with an online softmax, so memory is O(L*block) instead of O(L^2) (0: always store the full attention matrices)
+#endif
+#define USE_FUSED_FEED_FORWARD // compute the position-wise feed-forward layer in a single cache-blocked dynet::feed_forward node (CPU only, see use_cpu_fused_nodes)
+//---
+
+//---
+// the fused nodes above are implemented on CPU only; CUDA builds (HAVE_CUDA) still use them when running on a CPU device (--dynet-devices CPU)
+inline bool use_cpu_fused_nodes(){
+#ifdef HAVE_CUDA
+	return dynet::default_device->type == dynet::DeviceType::CPU;
+#else
+	return true;
+#endif
+}
 //---
 
 //---
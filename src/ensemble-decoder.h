@@ -11,6 +11,7 @@
 #include <cfloat>
 
 #include "transformer.h"
+#include "shortlist-utils.h"
 
 using namespace std;
 using namespace dynet;
@@ -22,16 +23,20 @@ class EnsembleDecoderHyp {
 public:
 	EnsembleDecoderHyp(float score, const WordIdSentence & sent, const WordIdSentence & align) :
 		_score(score), _sent(sent), _align(align) { }
+	EnsembleDecoderHyp(float score, const WordIdSentence & sent, const WordIdSentence & align, unsigned row) :
+		_score(score), _sent(sent), _align(align), _row(row) { }
 
 	float get_score() const { return _score; }
 	const WordIdSentence & get_sentence() const { return _sent; }
 	const WordIdSentence & get_alignment() const { return _align; }
+	unsigned get_row() const { return _row; }
 
 protected:
 
 	float _score;
 	WordIdSentence _sent;
 	WordIdSentence _align;
+	unsigned _row = 0;// row of the decoder states (at the last step) caching all but the last word of _sent
 };
 
 typedef std::shared_ptr<EnsembleDecoderHyp> EnsembleDecoderHypPtr;
@@ -63,6 +68,15 @@ public:
 		, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
 		, unsigned nbest_size);
 
+	// Decode a batch of source sentences together (each with its own beam)
+	std::vector<EnsembleDecoderHypPtr> generate(dynet::ComputationGraph& cg
+		, const WordIdSentences & sents_src
+		, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models);
+	std::vector<std::vector<EnsembleDecoderHypPtr>> generate_nbest(dynet::ComputationGraph& cg
+		, const WordIdSentences & sents_src
+		, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
+		, unsigned nbest_size);
+
 	// Ensemble together probabilities or log probabilities for a single word
 	Expression ensemble_probs(const std::vector<Expression> & in, dynet::ComputationGraph & cg);
 	Expression ensemble_logprobs(const std::vector<Expression> & in, dynet::ComputationGraph & cg);
@@ -78,6 +92,7 @@ public:
 	void set_beam_size(int beam_size) { _beam_size = beam_size; }
 	int get_size_limit() const { return _size_limit; }
 	void set_size_limit(int size_limit) { _size_limit = size_limit; }
+	void set_shortlist(const LexicalShortlist* shortlist) { _shortlist = shortlist; }// restrict the output vocabulary per batch; none if nullptr
 
 protected:
 
@@ -87,12 +102,13 @@ protected:
 	int _size_limit;
 	int _beam_size;
 	std::string _ensemble_operation;
+	const LexicalShortlist* _shortlist;
 
 	bool _verbose;
 };
 
 EnsembleDecoder::EnsembleDecoder(dynet::Dict& td)
-	: _word_pen(0.f), _unk_pen(0.f), _size_limit(500), _beam_size(1), _ensemble_operation("sum"), _verbose(false) 
+	: _word_pen(0.f), _unk_pen(0.f), _size_limit(500), _beam_size(1), _ensemble_operation("sum"), _shortlist(nullptr), _verbose(false) 
 {
 	_unk_id = td.convert("<unk>");
 	_unk_log_prob = -std::log(td.size());// penalty score for <unk>
@@ -132,54 +148,128 @@ EnsembleDecoderHypPtr EnsembleDecoder::generate(dynet::ComputationGraph& cg
 std::vector<EnsembleDecoderHypPtr> EnsembleDecoder::generate_nbest(dynet::ComputationGraph& cg
 	, const WordIdSentence & sent_src
 	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
+	, unsigned nbest_size) 
+{
+	return generate_nbest(cg, WordIdSentences(1, sent_src)/*pseudo batch (1)*/, v_models, nbest_size)[0];
+}
+
+std::vector<EnsembleDecoderHypPtr> EnsembleDecoder::generate(dynet::ComputationGraph& cg
+	, const WordIdSentences & sents_src
+	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models) 
+{
+	auto v_nbests = generate_nbest(cg, sents_src, v_models, 1);
+
+	std::vector<EnsembleDecoderHypPtr> v_bests;
+	for (auto & nbest : v_nbests)
+		v_bests.push_back(nbest.size() > 0 ? nbest[0] : EnsembleDecoderHypPtr());
+	return v_bests;
+}
+
+std::vector<std::vector<EnsembleDecoderHypPtr>> EnsembleDecoder::generate_nbest(dynet::ComputationGraph& cg
+	, const WordIdSentences & sents_src
+	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
 	, unsigned nbest_size/*FIXME: segmentation fault error with nbest_size <= 40?*/) 
 { 
 	// Sentinel symbols
 	const transformer::SentinelMarkers& sm = v_models[0].get()->get_config()._sm;
 	  
-	// compute source representation
+	unsigned num_sents = sents_src.size();
+
+	// compute source representation (of all source sentences together)
 	//cerr << "GenerateNbest::(1)" << endl;
 	std::vector<dynet::Expression> v_src_reps;
 	for (auto & tf : v_models){
-		v_src_reps.push_back(tf.get()->compute_source_rep(cg, WordIdSentences(1, sent_src)/*pseudo batch (1)*/));
+		v_src_reps.push_back(tf.get()->compute_source_rep(cg, sents_src));
+	}
+
+	// restrict the output vocabulary of all models to the shortlist of this batch, if any
+	std::vector<unsigned> shortlist_ids;
+	int unk_pos = _unk_id;// position of <unk> in the scores of a hypothesis
+	if (_shortlist != nullptr) {
+		shortlist_ids = _shortlist->build(sents_src);
+		for (auto & tf : v_models)
+			tf.get()->set_output_shortlist(shortlist_ids);
+
+		auto it = std::lower_bound(shortlist_ids.begin(), shortlist_ids.end(), (unsigned)_unk_id);
+		unk_pos = (it != shortlist_ids.end() && *it == (unsigned)_unk_id) ? (int)(it - shortlist_ids.begin()) : -1;
 	}
 
-	// The n-best hypotheses
-	std::vector<EnsembleDecoderHypPtr> nbest;
+	// The n-best hypotheses (per source sentence)
+	std::vector<std::vector<EnsembleDecoderHypPtr>> v_nbests(num_sents);
 
-	// Create the initial hypothesis
-	std::vector<EnsembleDecoderHypPtr> curr_beam(1, EnsembleDecoderHypPtr(new EnsembleDecoderHyp(0.0, WordIdSentence(1, sm._kTGT_SOS), WordIdSentence(1, 0))));
+	// Create the initial hypothesis (per source sentence)
+	std::vector<std::vector<EnsembleDecoderHypPtr>> v_curr_beams(num_sents, std::vector<EnsembleDecoderHypPtr>(1, EnsembleDecoderHypPtr(new EnsembleDecoderHyp(0.0, WordIdSentence(1, sm._kTGT_SOS), WordIdSentence(1, 0)))));
 
-	int bid;
 	Expression empty_idx;
 
 	// limit the output length
-	_size_limit = sent_src.size() * 3/*x*/;// not generating target with length "x times" the source length
+	std::vector<int> v_size_limits(num_sents);
+	std::vector<bool> v_finished(num_sents, false);
+	_size_limit = 0;
+	for (unsigned s = 0; s < num_sents; s++){
+		v_size_limits[s] = sents_src[s].size() * 3/*x*/;// not generating target with length "x times" the source length
+		_size_limit = std::max(_size_limit, v_size_limits[s]);
+	}
+
+	// The decoder states (one per model), caching the live hypotheses of all source sentences (one row each)
+	std::vector<transformer::DecoderState> v_states;
+	for (auto & tf : v_models){
+		v_states.push_back(tf.get()->init_decoder_state());
+		v_states.back().reserve(_size_limit + 1, num_sents * _beam_size);
+	}
 
 	// Perform decoding
 	for (int sent_len = 0; sent_len <= _size_limit; sent_len++) {
-		// This vector will hold the best IDs
-		std::vector<Beam_Info> next_beam_id(_beam_size+1, Beam_Info(-DBL_MAX,-1,-1,-1));
+		// These vectors will hold the best IDs (per source sentence)
+		std::vector<std::vector<Beam_Info>> v_next_beam_ids(num_sents, std::vector<Beam_Info>(_beam_size+1, Beam_Info(-DBL_MAX,-1,-1,-1)));
 
-		// Go through all the hypothesis IDs
-		//cerr << "GenerateNbest::(2)" << endl;
-		for (int hypid = 0; hypid < (int)curr_beam.size(); hypid++) {
-			EnsembleDecoderHypPtr curr_hyp = curr_beam[hypid];
-			const WordIdSentence& sent = curr_beam[hypid]->get_sentence();// partial generated sentence from current hypo in the beam
+		// This vector will hold the row of each hypothesis in the forward step
+		std::vector<std::vector<unsigned>> v_next_rows(num_sents);
 
-			if (sent_len != 0 && *sent.rbegin() == sm._kTGT_EOS) continue;
+		// Gather all live hypotheses of all unfinished sentences, which will be packed into the batch dimension of a single forward step
+		//cerr << "GenerateNbest::(2)" << endl;
+		std::vector<unsigned> v_sids;// source sentence of each live hypothesis
+		std::vector<int> v_hypids;
+		WordIdSentences v_sents;
+		std::vector<unsigned> v_rows;// row of the decoder states (at the last step) extended by each live hypothesis
+		for (unsigned s = 0; s < num_sents; s++) {
+			if (v_finished[s]) continue;
+
+			v_next_rows[s].resize(v_curr_beams[s].size());
+			for (int hypid = 0; hypid < (int)v_curr_beams[s].size(); hypid++) {
+				const WordIdSentence& sent = v_curr_beams[s][hypid]->get_sentence();// partial generated sentence from current hypo in the beam
+
+				if (sent_len != 0 && *sent.rbegin() == sm._kTGT_EOS) continue;
+
+				v_sids.push_back(s);
+				v_hypids.push_back(hypid);
+				v_sents.push_back(sent);
+				v_rows.push_back(v_curr_beams[s][hypid]->get_row());
+				v_next_rows[s][hypid] = v_rows.size() - 1;
+			}
+		}
 
-			cg.checkpoint();
+		if (v_hypids.size() != 0) {
+			// Keep (and reorder) the cached rows of the live hypotheses
+			if (sent_len != 0) {
+				for (auto & state : v_states)
+					state.select(v_rows);
+			}
 
 			// Perform the forward step on all models
+			// Note: the whole step is reverted once its scores are read, the decoder states live outside the graph
 			//cerr << "GenerateNbest::(2)::(a,Forward) ";
-			std::vector<Expression> i_softmaxes, i_aligns;
+			cg.checkpoint();
+			std::vector<Expression> i_tgts, i_softmaxes, i_aligns;
 			for(int j : boost::irange(0, (int)v_models.size())){
-				i_softmaxes.push_back(v_models[j].get()->step_forward(cg, v_src_reps[j]
-					, sent
-					, _ensemble_operation == "logsum"
-					, i_aligns));
+				i_tgts.push_back(v_models[j].get()->step_decode(cg, v_src_reps[j]
+					, v_sents
+					, v_states[j]
+					, v_sids
+					, i_aligns));// ((num_units, 1), num_hyps)
 			}
+			for(int j : boost::irange(0, (int)v_models.size()))
+				i_softmaxes.push_back(v_models[j].get()->step_output(cg, i_tgts[j], _ensemble_operation == "logsum"));// ((|V_T|, 1), num_hyps)
 
 			// Ensemble and calculate the likelihood
 			//cerr << "GenerateNbest::(2)::(b,Ensemble) ";
@@ -194,89 +284,130 @@ std::vector<EnsembleDecoderHypPtr> EnsembleDecoder::generate_nbest(dynet::Comput
 			else
 				assert(string("Bad ensembling operation: " + _ensemble_operation).c_str());
 
-			// Get the (log) softmax predictions
+			// Get the (log) softmax predictions of all hypotheses, read in place unless they live in device memory
 			//cerr << "GenerateNbest::(2)::(c,softmax) ";
-			std::vector<float> softmaxes = dynet::as_vector(cg.incremental_forward(i_logprob));
-
-			// Add the word/unk penalties
-			//  - word penalty
-			if (_word_pen != 0.f) {
-				for(size_t i = 0; i < softmaxes.size(); i++)
-					softmaxes[i] += _word_pen;
+			const dynet::Tensor& t_logprob = cg.incremental_forward(i_logprob);
+			std::vector<float> v_logprob;
+			const float* logprobs = t_logprob.v;
+			if (t_logprob.device->type != dynet::DeviceType::CPU) {
+				v_logprob = dynet::as_vector(t_logprob);
+				logprobs = v_logprob.data();
 			}
-			//  - unk penalty
-			if (_unk_id >= 0) softmaxes[_unk_id] += _unk_pen * _unk_log_prob;
+			int vocab_size = t_logprob.d.batch_size();
 
 			// Find the best aligned source, if any alignments exists
 			//cerr << "GenerateNbest::(2)::(d,Align) ";
-			WordId best_align = -1;
+			std::vector<WordId> best_aligns(v_hypids.size(), -1);
 			if (i_aligns.size() != 0) {
 				dynet::Expression ens_align = dynet::sum(i_aligns);
 				std::vector<float> align = dynet::as_vector(cg.incremental_forward(ens_align));
-				best_align = 0;
-				for(size_t aid = 0; aid < align.size(); aid++)
-					if(align[aid] > align[best_align])
-						best_align = aid;
+				size_t align_size = align.size() / v_hypids.size();
+				for(size_t k = 0; k < v_hypids.size(); k++) {
+					best_aligns[k] = 0;
+					for(size_t aid = 0; aid < align_size; aid++)
+						if(align[k * align_size + aid] > align[k * align_size + best_aligns[k]])
+							best_aligns[k] = aid;
+				}
 			}
 
-			// Find the best IDs in the beam
+			// Find the best IDs in the beam (of each source sentence), merging the top-k candidates of all its hypotheses
+			//  - word penalty: added to every candidate
+			//  - unk penalty: <unk> is scanned separately
 			//cerr << "GenerateNbest::(2)::(e,ID) ";
-			for (int wid = 0; wid < (int)softmaxes.size(); wid++) {
-				float my_score = curr_hyp->get_score() + softmaxes[wid];
-				for (bid = _beam_size; bid > 0 && my_score > std::get<0>(next_beam_id[bid-1]); bid--)
-					next_beam_id[bid] = next_beam_id[bid-1];
-				next_beam_id[bid] = Beam_Info(my_score, hypid, wid, best_align);
+			std::vector<std::vector<TopKEntry>> v_topks(num_sents);
+			for(size_t k = 0; k < v_hypids.size(); k++) {
+				const float* scores = logprobs + k * vocab_size;
+				float offset = v_curr_beams[v_sids[k]][v_hypids[k]]->get_score() + _word_pen;
+				std::vector<TopKEntry>& topk = v_topks[v_sids[k]];
+				if (unk_pos >= 0 && unk_pos < vocab_size) {
+					topk_scan(scores, 0, unk_pos, offset, k, _beam_size, topk);
+					topk_scan(scores, unk_pos + 1, vocab_size, offset, k, _beam_size, topk);
+					topk_offer(TopKEntry{offset + scores[unk_pos] + _unk_pen * _unk_log_prob, (int)k, unk_pos}, _beam_size, topk);
+				}
+				else
+					topk_scan(scores, 0, vocab_size, offset, k, _beam_size, topk);
+			}
+			for (unsigned s = 0; s < num_sents; s++) {
+				std::vector<TopKEntry>& topk = v_topks[s];
+				topk_sort(topk);
+				for (size_t i = 0; i < topk.size(); i++)
+					v_next_beam_ids[s][i] = Beam_Info(topk[i].score, v_hypids[topk[i].row]
+						, shortlist_ids.size() != 0 ? (int)shortlist_ids[topk[i].id] : topk[i].id/*word id*/
+						, best_aligns[topk[i].row]);
 			}
 
+			for(int j : boost::irange(0, (int)v_models.size()))
+				v_models[j].get()->update_decoder_state(v_states[j]);
+
 			cg.revert();
 		}
 
-		// Create the new hypotheses
-		//cerr << endl << "GenerateNbest::(3) " << endl;
-		std::vector<EnsembleDecoderHypPtr> next_beam;
-		for (int i = 0; i < _beam_size; i++) {
-			float score = std::get<0>(next_beam_id[i]);
-			int hypid = std::get<1>(next_beam_id[i]);
-			int wid = std::get<2>(next_beam_id[i]);
-			int aid = std::get<3>(next_beam_id[i]);
+		bool all_finished = true;
+		for (unsigned s = 0; s < num_sents; s++) {
+			if (v_finished[s]) continue;
 
-			if (hypid == -1) break;
+			std::vector<EnsembleDecoderHypPtr>& curr_beam = v_curr_beams[s];
+			std::vector<EnsembleDecoderHypPtr>& nbest = v_nbests[s];
+			std::vector<Beam_Info>& next_beam_id = v_next_beam_ids[s];
 
-			WordIdSentence next_sent = curr_beam[hypid]->get_sentence();
-			next_sent.push_back(wid);
+			// Create the new hypotheses
+			//cerr << endl << "GenerateNbest::(3) " << endl;
+			std::vector<EnsembleDecoderHypPtr> next_beam;
+			for (int i = 0; i < _beam_size; i++) {
+				float score = std::get<0>(next_beam_id[i]);
+				int hypid = std::get<1>(next_beam_id[i]);
+				int wid = std::get<2>(next_beam_id[i]);
+				int aid = std::get<3>(next_beam_id[i]);
 
-			WordIdSentence next_align = curr_beam[hypid]->get_alignment();
-			next_align.push_back(aid);
+				if (hypid == -1) break;
 
-			EnsembleDecoderHypPtr hyp(new EnsembleDecoderHyp(score, next_sent, next_align));
+				WordIdSentence next_sent = curr_beam[hypid]->get_sentence();
+				next_sent.push_back(wid);
 
-			if (wid == sm._kTGT_EOS && hyp->get_sentence().size() == 2) //as of 26 April 2017: excluding: <s> </s>
-				continue;
+				WordIdSentence next_align = curr_beam[hypid]->get_alignment();
+				next_align.push_back(aid);
 
-			if (wid == sm._kTGT_EOS || sent_len == _size_limit)
-				nbest.push_back(hyp);
+				EnsembleDecoderHypPtr hyp(new EnsembleDecoderHyp(score, next_sent, next_align, v_next_rows[s][hypid]));
 
-			next_beam.push_back(hyp);
-		}
+				if (wid == sm._kTGT_EOS && hyp->get_sentence().size() == 2) //as of 26 April 2017: excluding: <s> </s>
+					continue;
 
-		curr_beam = next_beam;
+				if (wid == sm._kTGT_EOS || sent_len == v_size_limits[s])
+					nbest.push_back(hyp);
 
-		// Check if we're done with search
-		//cerr << "GenerateNbest::(4) " << endl;
-		if(nbest.size() != 0) {
-			sort(nbest.begin(), nbest.end());
+				next_beam.push_back(hyp);
+			}
+
+			curr_beam = next_beam;
+
+			// Check if we're done with search
+			//cerr << "GenerateNbest::(4) " << endl;
+			if(nbest.size() != 0) {
+				sort(nbest.begin(), nbest.end());
+
+				if(nbest.size() > nbest_size) nbest.resize(nbest_size);
+				if(nbest.size() == nbest_size && (curr_beam.size() == 0 || (*nbest.rbegin())->get_score() >= next_beam[0]->get_score()))
+					v_finished[s] = true;
+			}
 
-			if(nbest.size() > nbest_size) nbest.resize(nbest_size);
-			if(nbest.size() == nbest_size && (curr_beam.size() == 0 || (*nbest.rbegin())->get_score() >= next_beam[0]->get_score()))
-				return nbest;
+			//if current beam size is 0, stop!
+			if(curr_beam.size() == 0) v_finished[s] = true;
+
+			if (!v_finished[s] && sent_len == v_size_limits[s]) {
+				if (_verbose) cerr << "WARNING: Generated sentence size exceeded " << v_size_limits[s] << ". Truncating." << endl;
+				v_finished[s] = true;
+			}
+
+			all_finished = all_finished && v_finished[s];
 		}
 
-		//if current beam size is 0, stop!
-		if(curr_beam.size() == 0) break;
+		if (all_finished) break;
 	}
 
-	if (_verbose) cerr << "WARNING: Generated sentence size exceeded " << _size_limit << ". Truncating." << endl;
+	if (_shortlist != nullptr) {
+		for (auto & tf : v_models)
+			tf.get()->set_output_shortlist(std::vector<unsigned>());
+	}
 
-	return nbest;
+	return v_nbests;
 }
-
@@ -7,8 +7,8 @@ namespace transformer
 
 // --- Sinusoidal Positional Encoding
 // Note: think effective way to make this much faster!
-dynet::Expression make_sinusoidal_position_encoding(dynet::ComputationGraph &cg, const dynet::Dim& dim);// global function
-dynet::Expression make_sinusoidal_position_encoding(dynet::ComputationGraph &cg, const dynet::Dim& dim){
+dynet::Expression make_sinusoidal_position_encoding(dynet::ComputationGraph &cg, const dynet::Dim& dim, unsigned start_pos=0);// global function
+dynet::Expression make_sinusoidal_position_encoding(dynet::ComputationGraph &cg, const dynet::Dim& dim, unsigned start_pos){
 	unsigned nUnits = dim[0];
 	unsigned nWords = dim[1];
 
@@ -18,7 +18,7 @@ dynet::Expression make_sinusoidal_position_encoding(dynet::ComputationGraph &cg,
 	std::vector<float> vSS(nUnits * nWords, 0.f);
 	for(unsigned p = 0; p < nWords; ++p) {
 		for(int i = 0; i < num_timescales; ++i) {
-			float v = p * std::exp(i * -log_timescale_increment);
+			float v = (p + start_pos) * std::exp(i * -log_timescale_increment);
 			vSS[p * nUnits + i] = std::sin(v);
 			vSS[p * nUnits + num_timescales + i] = std::cos(v);
 		}
@@ -28,6 +28,23 @@ dynet::Expression make_sinusoidal_position_encoding(dynet::ComputationGraph &cg,
 }
 // ---
 
+// --- Sub-layer epilogue: layer normalisation of the residual connection, with dropout on the sub-layer output
+// Note: this is done by a single node, which keeps only the dropout mask and the per-position statistics for backward.
+dynet::Expression residual_layer_norm(const dynet::Expression& i_x, const dynet::Expression& i_sublayer
+	, const dynet::Expression& i_ln_g, const dynet::Expression& i_ln_b
+	, float dropout_rate=0.f);// global function
+dynet::Expression residual_layer_norm(const dynet::Expression& i_x, const dynet::Expression& i_sublayer
+	, const dynet::Expression& i_ln_g, const dynet::Expression& i_ln_b
+	, float dropout_rate)
+{
+#ifdef USE_COLWISE_DROPOUT
+	return dynet::residual_layer_norm_colwise(i_x, i_sublayer, i_ln_g, i_ln_b, dropout_rate, true/*col-wise dropout*/);
+#else
+	return dynet::residual_layer_norm_colwise(i_x, i_sublayer, i_ln_g, i_ln_b, dropout_rate, false/*full dropout*/);
+#endif
+}
+// ---
+
 //--- Simple Linear Layer (w/ or w/o bias)
 struct LinearLayer{
 	explicit LinearLayer(DyNetModel* mod, unsigned input_dim, unsigned output_dim, bool have_bias=true, bool initLC=false)
@@ -39,7 +56,6 @@ struct LinearLayer{
 	}
 
 	dynet::Expression apply(dynet::ComputationGraph& cg, const dynet::Expression& i_x, bool reconstruct_shape=true, bool time_distributed=false){
-		dynet::Expression i_W = dynet::parameter(cg, _p_W);
 		dynet::Expression i_b; 
 		if (_have_bias)
 			i_b = dynet::parameter(cg, _p_b);
@@ -47,8 +63,15 @@ struct LinearLayer{
 		dynet::Expression i_x_in = (!time_distributed)?make_time_distributed(i_x)/*((input_dim, 1), batch_size * seq_len)*/:i_x/*((input_dim, seq_len), batch_size)*/;
 
 		dynet::Expression i_x_out;
-		if (_have_bias) i_x_out = dynet::affine_transform({i_b, i_W, i_x_in});// dim of i_x_out depends on i_x
-		else i_x_out = i_W * i_x_in;
+		if (_q_W){// int8 inference
+			if (_have_bias) i_x_out = dynet::int8_affine_transform(i_b, *_q_W, i_x_in);
+			else i_x_out = dynet::int8_matmul(*_q_W, i_x_in);
+		}
+		else{
+			dynet::Expression i_W = dynet::parameter(cg, _p_W);
+			if (_have_bias) i_x_out = dynet::affine_transform({i_b, i_W, i_x_in});// dim of i_x_out depends on i_x
+			else i_x_out = i_W * i_x_in;
+		}
 
 		if (!reconstruct_shape) return i_x_out;
 
@@ -59,9 +82,16 @@ struct LinearLayer{
 
 	~LinearLayer(){}
 
+	// switch to int8 weights for inference (decoding only, no training afterwards)
+	void quantize(){
+		_q_W.reset(new dynet::QuantizedMatrix(_p_W.get_storage().values));
+	}
+
 	dynet::Parameter _p_W;
 	dynet::Parameter _p_b;
 	bool _have_bias = true;
+
+	std::shared_ptr<dynet::QuantizedMatrix> _q_W;// int8 copy of _p_W, if quantised
 };
 
 //--- Highway Network Layer
@@ -107,6 +137,16 @@ struct FeedForwardLayer{
 
 	~FeedForwardLayer(){}	
 
+	void quantize(){
+		_l_inner.quantize();
+		_l_outer.quantize();
+	}
+
+	// bind a copy of this layer to the configuration of its new owner (see TransformerModel::replicate)
+	void rebind(TransformerConfig& tfc){
+		_p_tfc = &tfc;
+	}
+
 	dynet::Parameter _p_beta;// learnable \beta for Swish activation function (work in progress!)
 
 	// transformer config pointer
@@ -114,6 +154,16 @@ struct FeedForwardLayer{
 
 	dynet::Expression build_graph(dynet::ComputationGraph& cg, const dynet::Expression& i_inp/*num_units x L*/){
 		// FFN(x) = relu(x * W1 + b1) * W2 + b2
+#ifdef USE_FUSED_FEED_FORWARD
+		if (use_cpu_fused_nodes() && !_l_inner._q_W/*the int8 path keeps separate layers*/
+			&& (_p_tfc->_ffl_activation_type == FFL_ACTIVATION_TYPE::RELU || _p_tfc->_ffl_activation_type == FFL_ACTIVATION_TYPE::SWISH))
+			return apply_dropout(dynet::feed_forward(i_inp
+				, dynet::parameter(cg, _l_inner._p_W), dynet::parameter(cg, _l_inner._p_b)
+				, dynet::parameter(cg, _l_outer._p_W), dynet::parameter(cg, _l_outer._p_b)
+				, (_p_tfc->_ffl_activation_type == FFL_ACTIVATION_TYPE::RELU) ? dynet::FeedForward::RELU : dynet::FeedForward::SILU
+				, _p_tfc->_is_training/*hidden pre-activations are only kept for backward*/));// ((num_units, L), batch_size)
+#endif
+
 		dynet::Expression i_inner = _l_inner.apply(cg, i_inp, false, true);// x * W1 + b1
 
 		if (_p_tfc->_ffl_activation_type == FFL_ACTIVATION_TYPE::RELU)
@@ -130,13 +180,17 @@ struct FeedForwardLayer{
 
 		dynet::Expression i_outer = _l_outer.apply(cg, i_inner, false, true);// relu(x * W1 + b1) * W2 + b2
 
-		// dropout for feed-forward layer
-		// Note: this dropout can be moved to after RELU activation and before outer linear transformation (e.g., refers to Sockeye?).
+		return apply_dropout(i_outer);
+	}
+
+	// dropout for feed-forward layer
+	// Note: this dropout can be moved to after RELU activation and before outer linear transformation (e.g., refers to Sockeye?).
+	dynet::Expression apply_dropout(const dynet::Expression& i_outer){
 		if (_p_tfc->_use_dropout && _p_tfc->_ff_dropout_rate > 0.f)
 #ifdef USE_COLWISE_DROPOUT
-			i_outer = dynet::dropout_dim(i_outer, 1/*col-major*/, _p_tfc->_ff_dropout_rate);
+			return dynet::dropout_dim(i_outer, 1/*col-major*/, _p_tfc->_ff_dropout_rate);
 #else
-			i_outer = dynet::dropout(i_outer, _p_tfc->_ff_dropout_rate);
+			return dynet::dropout(i_outer, _p_tfc->_ff_dropout_rate);
 #endif
 
 		return i_outer;
@@ -156,13 +210,21 @@ struct MaskBase{
 	~MaskBase(){}
 
 	void create_future_blinding_mask(dynet::ComputationGraph& cg, unsigned l){
+#ifndef MULTI_HEAD_ATTENTION_PARALLEL
 		_i_mask_fb = create_triangle_mask(cg, l, false);	
+#endif
 	}
 
 	void create_seq_mask_expr(dynet::ComputationGraph& cg
 		, const std::vector<vector<float>>& v_seq_masks
 		, bool self=true/*self-attention?*/)
 	{
+		// padding positions are always at the end, so the masks boil down to sequence lengths
+		_seq_lengths.clear();
+		for (auto& seq_mask : v_seq_masks)
+			_seq_lengths.push_back(std::count(seq_mask.begin(), seq_mask.end(), 0.f));
+
+#ifndef MULTI_HEAD_ATTENTION_PARALLEL
 		unsigned l = v_seq_masks[0].size();
 
 		std::vector<dynet::Expression> v_i_seq_masks;
@@ -171,10 +233,16 @@ struct MaskBase{
 			v_i_seq_masks.push_back((self) ? i_mask * PSEUDO_MIN_VALUE : 1.f - i_mask);
 		}
 		_i_seq_mask = dynet::concatenate_to_batch(v_i_seq_masks);// ((l, 1), batch_size) or ((1, l), batch_size)
+#endif
 	}
 
 	void create_padding_positions_masks(unsigned nheads) // for self-attention
 	{
+#ifdef MULTI_HEAD_ATTENTION_PARALLEL
+		// the attention softmax masks the padded keys itself, no mask tensors needed
+		_key_lengths = _seq_lengths;
+		_query_lengths.clear();// padded queries still attend to the unpadded keys
+#else
 		unsigned l = _i_seq_mask.dim()[0];
 		
 		// key mask
@@ -182,10 +250,23 @@ struct MaskBase{
 		
 		// query mask
 		_i_mask_pp_q = 1.f - _i_mask_pp_k / PSEUDO_MIN_VALUE;// ((l, l), batch_size*nheads)
+#endif
 	}
 
-	void create_padding_positions_masks(const dynet::Expression& i_src_seq_mask, unsigned nheads) // for source-attention
+	void create_padding_positions_masks(const MaskBase& src_mask, unsigned nheads
+		, const std::vector<unsigned>& src_ids=std::vector<unsigned>()/*source batch element of each target one; empty if aligned one-to-one*/) // for source-attention
 	{
+#ifdef MULTI_HEAD_ATTENTION_PARALLEL
+		_key_lengths = src_mask._seq_lengths;
+		if (!src_ids.empty()){
+			_key_lengths.clear();
+			for (auto id : src_ids) _key_lengths.push_back(src_mask._seq_lengths[id]);
+		}
+		_query_lengths = _seq_lengths;
+#else
+		dynet::Expression i_src_seq_mask = src_mask._i_seq_mask;
+		if (!src_ids.empty()) i_src_seq_mask = dynet::pick_batch_elems(i_src_seq_mask, src_ids);// ((lx, 1), batch_size)
+
 		unsigned ly = _i_seq_mask.dim()[1];
 		unsigned lx = i_src_seq_mask.dim()[0];
 
@@ -194,8 +275,17 @@ struct MaskBase{
 
 		// query mask
 		_i_mask_pp_q = dynet::concatenate_to_batch(std::vector<dynet::Expression>(nheads, dynet::concatenate(std::vector<dynet::Expression>(lx, _i_seq_mask))));// ((lx, ly), batch_size*nheads)
+#endif
 	}
 
+	// sequence lengths (number of unpadded positions of each batch element)
+	std::vector<unsigned> _seq_lengths;
+
+	// lengths for padding positions masking, applied within the attention softmax (with MULTI_HEAD_ATTENTION_PARALLEL)
+	std::vector<unsigned> _key_lengths;// number of visible keys
+	std::vector<unsigned> _query_lengths;// number of unpadded queries (empty if queries are not masked)
+
+	// dense masks (without MULTI_HEAD_ATTENTION_PARALLEL)
 	// sequence mask
 	dynet::Expression _i_seq_mask;
 
@@ -233,6 +323,18 @@ struct MultiHeadAttentionLayer{
 
 	~MultiHeadAttentionLayer(){}
 
+	void quantize(){
+		_l_W_Q.quantize();
+		_l_W_K.quantize();
+		_l_W_V.quantize();
+		_l_W_O.quantize();
+	}
+
+	// bind a copy of this layer to the configuration of its new owner (see TransformerModel::replicate)
+	void rebind(TransformerConfig& tfc){
+		_p_tfc = &tfc;
+	}
+
 	// linear projection matrices
 	LinearLayer _l_W_Q;
 	LinearLayer _l_W_K;
@@ -260,36 +362,120 @@ struct MultiHeadAttentionLayer{
 		, const dynet::Expression& i_y/*queries*/
 		, const dynet::Expression& i_x/*keys and values. i_x is equal to i_y if using self_attention*/
 		, const MaskBase& i_mask)
+	{
+		dynet::Expression i_batch_K, i_batch_V;
+		compute_keys_values(cg, i_x, i_batch_K, i_batch_V);
+
+		return build_graph(cg, i_y, i_batch_K, i_batch_V, i_mask);
+	}
+
+	// attention over precomputed keys and values (e.g., of the source sentence, which stay unchanged during decoding)
+	dynet::Expression build_graph(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_y/*queries*/
+		, const dynet::Expression& i_batch_K/*((num_units/nheads, Lx), batch_size*nheads), from compute_keys_values*/
+		, const dynet::Expression& i_batch_V/*((num_units/nheads, Lx), batch_size*nheads), from compute_keys_values*/
+		, const MaskBase& i_mask)
 	{
 		dynet::Expression i_Q = _l_W_Q.apply(cg, i_y, false, true);// ((num_units, Ly), batch_size)
+
+		return compute_attention(cg, i_Q, i_batch_K, i_batch_V, &i_mask);
+	}
+
+	void compute_keys_values(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_x/*keys and values*/
+		, dynet::Expression& i_batch_K
+		, dynet::Expression& i_batch_V)
+	{
 		dynet::Expression i_K = _l_W_K.apply(cg, i_x, false, true);// ((num_units, Lx), batch_size)
 		dynet::Expression i_V = _l_W_V.apply(cg, i_x, false, true);// ((num_units, Lx), batch_size)
 
+#ifdef USE_FUSED_MULTI_HEAD_ATTENTION
+		if (use_cpu_fused_nodes()){
+			// the fused attention node reads the heads in place
+			i_batch_K = i_K;
+			i_batch_V = i_V;
+			return;
+		}
+#endif
+		// Note: this will be done in parallel for efficiency!
+		// e.g., utilising pseudo-batching
+		i_batch_K = dynet::concatenate_to_batch(split_rows(i_K, _p_tfc->_nheads));// ((num_units/nheads, Lx), batch_size*nheads)
+		i_batch_V = dynet::concatenate_to_batch(split_rows(i_V, _p_tfc->_nheads));// ((num_units/nheads, Lx), batch_size*nheads)
+	}
+
+	// incremental self-attention (for decoding only): i_y holds the newest position only, whose key and value are appended to the cached ones of the previous positions
+	dynet::Expression build_graph_incremental(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_y/*query at the newest position, ((num_units, 1), batch_size)*/
+		, const dynet::Expression& i_K_cache/*cached keys, ((num_units, t), batch_size); empty at the first position*/
+		, const dynet::Expression& i_V_cache/*cached values, ((num_units, t), batch_size); empty at the first position*/
+		, dynet::Expression& i_K_t/*key at the newest position (to be cached)*/
+		, dynet::Expression& i_V_t/*value at the newest position (to be cached)*/)
+	{
+		dynet::Expression i_Q = _l_W_Q.apply(cg, i_y, false, true);// ((num_units, 1), batch_size)
+		i_K_t = _l_W_K.apply(cg, i_y, false, true);// ((num_units, 1), batch_size)
+		i_V_t = _l_W_V.apply(cg, i_y, false, true);// ((num_units, 1), batch_size)
+
+		dynet::Expression i_K = i_K_t, i_V = i_V_t;
+		if (i_K_cache.pg != nullptr){
+			i_K = dynet::concatenate_cols({i_K_cache, i_K_t});// ((num_units, t+1), batch_size)
+			i_V = dynet::concatenate_cols({i_V_cache, i_V_t});// ((num_units, t+1), batch_size)
+		}
+
+		// Note: no masks needed here since the newest position can attend to all (unpadded) positions so far.
+#ifdef USE_FUSED_MULTI_HEAD_ATTENTION
+		if (use_cpu_fused_nodes())
+			return compute_attention(cg, i_Q, i_K, i_V, nullptr);
+#endif
+		dynet::Expression i_batch_K = dynet::concatenate_to_batch(split_rows(i_K, _p_tfc->_nheads));// ((num_units/nheads, t+1), batch_size*nheads)
+		dynet::Expression i_batch_V = dynet::concatenate_to_batch(split_rows(i_V, _p_tfc->_nheads));// ((num_units/nheads, t+1), batch_size*nheads)
+
+		return compute_attention(cg, i_Q, i_batch_K, i_batch_V, nullptr);
+	}
+
+	dynet::Expression compute_attention(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_Q/*((num_units, Ly), batch_size)*/
+		, const dynet::Expression& i_batch_K/*((num_units/nheads, Lx), batch_size*nheads)*/
+		, const dynet::Expression& i_batch_V/*((num_units/nheads, Lx), batch_size*nheads)*/
+		, const MaskBase* p_mask/*nullptr if no masking is required*/)
+	{
+		// padding positions maskings, given by sequence lengths
+		std::vector<unsigned> key_lengths, query_lengths;
+#ifdef USE_KEY_QUERY_MASKINGS
+		if (p_mask){
+			key_lengths = p_mask->_key_lengths;
+			query_lengths = p_mask->_query_lengths;
+		}
+#endif
+
+#ifdef USE_FUSED_MULTI_HEAD_ATTENTION
+		if (use_cpu_fused_nodes()){
+			// i_batch_K and i_batch_V are ((num_units, Lx), batch_size) here, see compute_keys_values
+			if (_p_tfc->_attention_type != ATTENTION_TYPE::DOT_PRODUCT)
+				TRANSFORMER_RUNTIME_ASSERT("MultiHeadAttentionLayer: only dot-product attention is supported by the fused attention node!");
+			if (_use_soft_alignments)
+				TRANSFORMER_RUNTIME_ASSERT("MultiHeadAttentionLayer: soft alignments are not exposed by the fused attention node!");
+
+			float dropout_rate = (_p_tfc->_use_dropout) ? _p_tfc->_attention_dropout_rate : 0.f;// drops key positions (col-wise dropout)
+			dynet::Expression i_atts = dynet::multi_head_attention(i_Q, i_batch_K, i_batch_V, _p_tfc->_nheads, _att_scale
+				, _is_future_blinding && p_mask/*causal*/, key_lengths, query_lengths, dropout_rate
+				, MULTI_HEAD_ATTENTION_KEY_BLOCK_SIZE);// ((num_units, Ly), batch_size)
+
+			return _l_W_O.apply(cg, i_atts, false, true);// ((num_units, Ly), batch_size)
+		}
+#endif
 		// Note: this will be done in parallel for efficiency!
 		// e.g., utilising pseudo-batching
 		dynet::Expression i_batch_Q = dynet::concatenate_to_batch(split_rows(i_Q, _p_tfc->_nheads));// ((num_units/nheads, Ly), batch_size*nheads)
-		dynet::Expression i_batch_K = dynet::concatenate_to_batch(split_rows(i_K, _p_tfc->_nheads));// ((num_units/nheads, Lx), batch_size*nheads)
-		dynet::Expression i_batch_V = dynet::concatenate_to_batch(split_rows(i_V, _p_tfc->_nheads));// ((num_units/nheads, Lx), batch_size*nheads)
 
 		dynet::Expression i_atts;
 		if (_p_tfc->_attention_type == ATTENTION_TYPE::DOT_PRODUCT){// Luong attention type
-			dynet::Expression i_batch_alphas = (dynet::transpose(i_batch_K) * i_batch_Q) * _att_scale;// ((Lx, Ly),  batch_size*nheads)) (unnormalised) 
-
-#ifdef USE_KEY_QUERY_MASKINGS
-			// key masking
-			i_batch_alphas = i_batch_alphas + i_mask._i_mask_pp_k;
-#endif
+			dynet::Expression i_batch_alphas = dynet::matmul_tn(i_batch_K, i_batch_Q) * _att_scale;// ((Lx, Ly),  batch_size*nheads)) (unnormalised) 
 
-			// future blinding masking
-			if (_is_future_blinding)
-				i_batch_alphas = dynet::softmax(i_batch_alphas + i_mask._i_mask_fb);// ((Lx, Ly),  batch_size*nheads)) (normalised, col-major)
+			// key, query and future blinding maskings are applied within the softmax (no mask tensors)
+			if (p_mask)
+				i_batch_alphas = dynet::masked_softmax(i_batch_alphas, key_lengths, query_lengths, _is_future_blinding/*causal*/);// ((Lx, Ly),  batch_size*nheads)) (normalised, col-major)
 			else
 				i_batch_alphas = dynet::softmax(i_batch_alphas);// ((Lx, Ly),  batch_size*nheads)) (normalised, col-major)
-			
-#ifdef USE_KEY_QUERY_MASKINGS
-			// query masking
-			i_batch_alphas = dynet::cmult(i_batch_alphas, i_mask._i_mask_pp_q);// masked soft alignments
-#endif
 
 			// save the soft alignment in i_batch_alphas if necessary!
 			if (_use_soft_alignments) get_alignments(i_batch_alphas);
@@ -339,6 +525,15 @@ struct MultiHeadAttentionLayer{
 
 	~MultiHeadAttentionLayer(){}
 
+	void quantize(){
+		TRANSFORMER_RUNTIME_ASSERT("MultiHeadAttentionLayer: int8 inference requires MULTI_HEAD_ATTENTION_PARALLEL!");
+	}
+
+	// bind a copy of this layer to the configuration of its new owner (see TransformerModel::replicate)
+	void rebind(TransformerConfig& tfc){
+		_p_tfc = &tfc;
+	}
+
 	// linear projection matrices
 	std::vector<dynet::Parameter> _p_WQ;
 	std::vector<dynet::Parameter> _p_WK;
@@ -368,17 +563,17 @@ struct MultiHeadAttentionLayer{
 		// e.g., utilising pseudo-batching?	
 		std::vector<dynet::Expression> v_atts(_p_tfc->_nheads);
 		for (unsigned h = 0; h < _p_tfc->_nheads; h++){
-			dynet::Expression i_Q/*queries*/ = dynet::parameter(cg, _p_WQ[h])/*dk x num_units*/ * i_x/*num_units x Ly*/;// ((dk, Ly), batch_size)
-			dynet::Expression i_K/*keys*/ = dynet::parameter(cg, _p_WK[h])/*dk x num_units*/ * i_y/*num_units x Lx*/;// ((dk, Lx), batch_size)
-			dynet::Expression i_V/*values*/ = dynet::parameter(cg, _p_WV[h])/*dv x num_units*/ * i_y/*num_units x Lx*/;// ((dk, Lx), batch_size)
+			dynet::Expression i_Q/*queries*/ = dynet::parameter(cg, _p_WQ[h])/*dk x num_units*/ * i_y/*num_units x Ly*/;// ((dk, Ly), batch_size)
+			dynet::Expression i_K/*keys*/ = dynet::parameter(cg, _p_WK[h])/*dk x num_units*/ * i_x/*num_units x Lx*/;// ((dk, Lx), batch_size)
+			dynet::Expression i_V/*values*/ = dynet::parameter(cg, _p_WV[h])/*dv x num_units*/ * i_x/*num_units x Lx*/;// ((dk, Lx), batch_size)
 
 			dynet::Expression i_att_h;
 			if (_p_tfc->_attention_type == ATTENTION_TYPE::DOT_PRODUCT){// Luong attention type
-				dynet::Expression i_alpha_pre = (dynet::transpose(i_K) * i_Q) * _att_scale;// ((Lx, Ly), batch_size) (unnormalised) 
+				dynet::Expression i_alpha_pre = dynet::matmul_tn(i_K, i_Q) * _att_scale;// ((Lx, Ly), batch_size) (unnormalised) 
 
 #ifdef USE_KEY_QUERY_MASKINGS
 				// key masking
-				i_alpha_pre = i_alpha_pre + i_mask._i_mask_pp_k);
+				i_alpha_pre = i_alpha_pre + i_mask._i_mask_pp_k;
 #endif
 
 				dynet::Expression i_alpha;
@@ -389,7 +584,7 @@ struct MultiHeadAttentionLayer{
 
 #ifdef USE_KEY_QUERY_MASKINGS
 				// query masking
-				i_alpha = dynet::cmult(i_alpha, i_mask._i_mask_pp_q));// masked soft alignments
+				i_alpha = dynet::cmult(i_alpha, i_mask._i_mask_pp_q);// masked soft alignments
 #endif
 
 				// save the soft alignment in i_alpha if necessary!
@@ -421,6 +616,67 @@ struct MultiHeadAttentionLayer{
 
 		return i_proj_atts;
 	}
+
+	// Note: keys and values are projected per head within build_graph, hence i_x is just passed through here.
+	dynet::Expression build_graph(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_y
+		, const dynet::Expression& i_batch_K
+		, const dynet::Expression& i_batch_V
+		, const MaskBase& i_mask)
+	{
+		return build_graph(cg, i_y, i_batch_K, i_mask);
+	}
+
+	void compute_keys_values(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_x
+		, dynet::Expression& i_batch_K
+		, dynet::Expression& i_batch_V)
+	{
+		i_batch_K = i_batch_V = i_x;
+	}
+
+	// incremental self-attention (for decoding only), see the MULTI_HEAD_ATTENTION_PARALLEL version
+	// Note: the cached keys and values hold the per-head projections stacked along the rows.
+	dynet::Expression build_graph_incremental(dynet::ComputationGraph& cg
+		, const dynet::Expression& i_y/*query at the newest position, ((num_units, 1), batch_size)*/
+		, const dynet::Expression& i_K_cache/*cached keys, ((num_units, t), batch_size); empty at the first position*/
+		, const dynet::Expression& i_V_cache/*cached values, ((num_units, t), batch_size); empty at the first position*/
+		, dynet::Expression& i_K_t/*key at the newest position (to be cached)*/
+		, dynet::Expression& i_V_t/*value at the newest position (to be cached)*/)
+	{
+		unsigned nheads = _p_tfc->_nheads, dk = _p_tfc->_num_units / nheads;
+
+		std::vector<dynet::Expression> v_K_t(nheads), v_V_t(nheads);
+		for (unsigned h = 0; h < nheads; h++){
+			v_K_t[h] = dynet::parameter(cg, _p_WK[h]) * i_y;// ((dk, 1), batch_size)
+			v_V_t[h] = dynet::parameter(cg, _p_WV[h]) * i_y;// ((dk, 1), batch_size)
+		}
+		i_K_t = dynet::concatenate(v_K_t);// ((num_units, 1), batch_size)
+		i_V_t = dynet::concatenate(v_V_t);// ((num_units, 1), batch_size)
+
+		dynet::Expression i_K = i_K_t, i_V = i_V_t;
+		if (i_K_cache.pg != nullptr){
+			i_K = dynet::concatenate_cols({i_K_cache, i_K_t});// ((num_units, t+1), batch_size)
+			i_V = dynet::concatenate_cols({i_V_cache, i_V_t});// ((num_units, t+1), batch_size)
+		}
+
+		// Note: no masks needed here since the newest position can attend to all (unpadded) positions so far.
+		std::vector<dynet::Expression> v_atts(nheads);
+		for (unsigned h = 0; h < nheads; h++){
+			dynet::Expression i_Q = dynet::parameter(cg, _p_WQ[h]) * i_y;// ((dk, 1), batch_size)
+			dynet::Expression i_K_h = dynet::pick_range(i_K, h * dk, (h + 1) * dk);// ((dk, t+1), batch_size)
+			dynet::Expression i_V_h = dynet::pick_range(i_V, h * dk, (h + 1) * dk);// ((dk, t+1), batch_size)
+
+			if (_p_tfc->_attention_type != ATTENTION_TYPE::DOT_PRODUCT)
+				TRANSFORMER_RUNTIME_ASSERT("MultiHeadAttentionLayer: only dot-product attention is supported by incremental decoding!");
+			dynet::Expression i_alpha = dynet::softmax(dynet::matmul_tn(i_K_h, i_Q) * _att_scale);// ((t+1, 1), batch_size)
+
+			v_atts[h] = i_V_h * i_alpha;// ((dk, 1), batch_size)
+		}
+
+		// joint all head attentions, then linear projection
+		return dynet::parameter(cg, _p_WO) * dynet::concatenate(v_atts);// ((num_units, 1), batch_size)
+	}
 #endif
 };
 //---
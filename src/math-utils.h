@@ -1,5 +1,9 @@
 #include <float.h> // DBL_MAX
 #include <limits> // numeric_limits
+#include <vector>
+#include <algorithm>
+
+#include <Eigen/Core>
 
 template<typename T>
 inline bool is_infinite( const T &value )
@@ -28,3 +32,58 @@ inline bool is_valid( const T &value )
     return !is_infinite(value) && !is_nan(value);
 }
 
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Top-k selection over score rows (e.g. vocabulary log-probabilities of beam hypotheses).
+// Candidates of several rows are merged into one bounded heap whose worst entry is the threshold a new candidate must beat,
+// so once the heap is full most of a row is skipped block by block with a SIMD max.
+
+struct TopKEntry {
+	float score;
+	int row;// e.g. hypothesis
+	int id;// e.g. word
+};
+
+// higher score first; ties go to the earlier (row, id)
+inline bool topk_better(const TopKEntry& e1, const TopKEntry& e2)
+{
+	if (e1.score != e2.score) return e1.score > e2.score;
+	if (e1.row != e2.row) return e1.row < e2.row;
+	return e1.id < e2.id;
+}
+
+// offer a single candidate to the heap of (at most) k entries
+inline void topk_offer(const TopKEntry& e, unsigned k, std::vector<TopKEntry>& heap)
+{
+	if (heap.size() < k) {
+		heap.push_back(e);
+		std::push_heap(heap.begin(), heap.end(), topk_better);// worst entry on top
+	}
+	else if (k > 0 && topk_better(e, heap.front())) {
+		std::pop_heap(heap.begin(), heap.end(), topk_better);
+		heap.back() = e;
+		std::push_heap(heap.begin(), heap.end(), topk_better);
+	}
+}
+
+// offer offset + scores[i] for i in [begin, end) of the given row
+inline void topk_scan(const float* scores, int begin, int end, float offset, int row, unsigned k, std::vector<TopKEntry>& heap)
+{
+	const int kBlockSize = 64;
+	for (int b = begin; b < end; b += kBlockSize) {
+		int len = std::min(kBlockSize, end - b);
+		if (k > 0 && heap.size() == k) {
+			float block_max = Eigen::Map<const Eigen::ArrayXf>(scores + b, len).maxCoeff();
+			if (offset + block_max < heap.front().score) continue;// nothing in this block can enter the heap
+		}
+
+		for (int i = b; i < b + len; i++)
+			topk_offer(TopKEntry{offset + scores[i], row, i}, k, heap);
+	}
+}
+
+// turn the heap into the sorted top-k list (best first)
+inline void topk_sort(std::vector<TopKEntry>& heap)
+{
+	std::sort_heap(heap.begin(), heap.end(), topk_better);
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Utilities for the persistent translation server: line-oriented channels (stdin/stdout or local UNIX-socket connections),
+// and a request queue that groups requests arriving close together in time into micro-batches.
+
+// a bidirectional line-oriented connection to a client
+struct TranslationChannel {
+	explicit TranslationChannel(int in_fd, int out_fd, bool owned)
+		: _in_fd(in_fd), _out_fd(out_fd), _owned(owned) {}
+	~TranslationChannel(){
+		if (_owned) ::close(_in_fd);// the connection is closed once its reader and all its pending requests are done
+	}
+	TranslationChannel(const TranslationChannel&) = delete;
+	TranslationChannel& operator=(const TranslationChannel&) = delete;
+
+	// read the next line (w/o the trailing newline); false at end of stream
+	bool read_line(std::string& line){
+		line.clear();
+		while (true){
+			size_t pos = _buf.find('\n');
+			if (pos != std::string::npos){
+				line = _buf.substr(0, pos);
+				_buf.erase(0, pos + 1);
+				if (!line.empty() && line.back() == '\r') line.pop_back();
+				return true;
+			}
+
+			char chunk[4096];
+			ssize_t n = ::read(_in_fd, chunk, sizeof(chunk));
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0){// end of stream: hand out the last unterminated line (if any)
+				if (_buf.empty()) return false;
+				line.swap(_buf);
+				return true;
+			}
+			_buf.append(chunk, n);
+		}
+	}
+
+	// write a whole line; replies from different decoding batches may interleave, hence the lock
+	bool write_line(const std::string& line){
+		std::lock_guard<std::mutex> lock(_write_mtx);
+		std::string out = line + "\n";
+		size_t done = 0;
+		while (done < out.size()){
+			ssize_t n = _owned ? ::send(_out_fd, out.data() + done, out.size() - done, MSG_NOSIGNAL)/*client may have gone away*/
+				: ::write(_out_fd, out.data() + done, out.size() - done);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			done += n;
+		}
+		return true;
+	}
+
+	int _in_fd, _out_fd;
+	bool _owned;// true for socket connections
+	std::string _buf;
+	std::mutex _write_mtx;
+};
+typedef std::shared_ptr<TranslationChannel> TranslationChannelPtr;
+
+// a source sentence waiting for translation
+struct TranslationRequest {
+	std::string _id;// echoed back with the reply so that clients can match out-of-order replies
+	std::string _source;
+	TranslationChannelPtr _channel;// where the reply goes
+	std::chrono::steady_clock::time_point _arrival;
+};
+
+// thread-safe FIFO of requests, drained in micro-batches
+class TranslationRequestQueue {
+public:
+	void push(TranslationRequest&& req){
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			req._arrival = std::chrono::steady_clock::now();
+			_reqs.push_back(std::move(req));
+		}
+		_cv.notify_one();
+	}
+
+	// no more requests will come; pending ones are still handed out
+	void close(){
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_closed = true;
+		}
+		_cv.notify_all();
+	}
+
+	// Block until at least one request is pending, then keep collecting until either max_size requests are available
+	// or the oldest one has waited for the latency budget. Returns false once the queue is closed and drained.
+	bool pop_batch(std::vector<TranslationRequest>& batch, size_t max_size, std::chrono::milliseconds latency){
+		batch.clear();
+
+		std::unique_lock<std::mutex> lock(_mtx);
+		_cv.wait(lock, [this]{ return !_reqs.empty() || _closed; });
+		if (_reqs.empty()) return false;
+
+		auto deadline = _reqs.front()._arrival + latency;
+		_cv.wait_until(lock, deadline, [this, max_size]{ return _reqs.size() >= max_size || _closed; });
+
+		size_t n = std::min(max_size, _reqs.size());
+		for (size_t i = 0; i < n; i++){
+			batch.push_back(std::move(_reqs.front()));
+			_reqs.pop_front();
+		}
+		return true;
+	}
+
+private:
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::deque<TranslationRequest> _reqs;
+	bool _closed = false;
+};
+
+// ---
+// Read requests from a channel until end of stream. Each line is "[<id> ||| ]<source sentence>";
+// w/o an explicit id, the (1-based) line number within the channel is used.
+inline void read_requests(TranslationChannelPtr channel, TranslationRequestQueue& queue)
+{
+	std::string line;
+	unsigned lno = 0;
+	while (channel->read_line(line)){
+		lno++;
+
+		TranslationRequest req;
+		size_t pos = line.find("|||");
+		if (pos != std::string::npos){
+			std::istringstream(line.substr(0, pos)) >> req._id;
+			req._source = line.substr(pos + 3);
+		}
+		else{
+			req._id = std::to_string(lno);
+			req._source = line;
+		}
+		req._channel = channel;
+
+		queue.push(std::move(req));
+	}
+}
+// ---
+
+// ---
+// Listen on a local UNIX socket and serve each accepted connection with its own reader thread. Never returns unless listening fails.
+inline bool listen_for_requests(const std::string& socket_path, TranslationRequestQueue& queue)
+{
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path)){
+		std::cerr << "Socket path is too long: " << socket_path << std::endl;
+		return false;
+	}
+	std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+	int sfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sfd < 0){
+		std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	::unlink(socket_path.c_str());// remove a stale socket left over from a previous run
+	if (::bind(sfd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(sfd, SOMAXCONN) < 0){
+		std::cerr << "Failed to listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+		::close(sfd);
+		return false;
+	}
+	std::cerr << "Listening on " << socket_path << "..." << std::endl;
+
+	while (true){
+		int cfd = ::accept(sfd, nullptr, nullptr);
+		if (cfd < 0){
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			std::cerr << "Failed to accept connection: " << std::strerror(errno) << std::endl;
+			break;
+		}
+
+		TranslationChannelPtr channel(new TranslationChannel(cfd, cfd, true));
+		std::thread(read_requests, channel, std::ref(queue)).detach();
+	}
+
+	::close(sfd);
+	return false;
+}
+// ---
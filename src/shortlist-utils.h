@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+
+#include "def.h"
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Lexical shortlist: restricts the output vocabulary of a decoding batch to the likely translations of its source words
+// plus a fixed set of common target words, so that the output projection and softmax run over a few thousand rows instead of |V_T|.
+
+struct LexicalShortlist {
+	// lex_file: one "<source word> <target word> <p(target|source)>" entry per line (e.g. a lexical translation table from word alignments)
+	// topk: no. of best translations kept per source word
+	// nfreq: no. of most frequent target words always included
+	// always: other target ids always included (e.g. <s>, </s>, <unk>)
+	// p_train_cor: corpus the target vocabulary was built from, to count the target word frequencies;
+	//	nullptr for a vocabulary file (--tgt-vocab), which lists words by decreasing frequency already
+	explicit LexicalShortlist(const std::string& lex_file
+		, dynet::Dict& sd, dynet::Dict& td
+		, unsigned topk, unsigned nfreq
+		, const std::vector<int>& always
+		, const WordIdCorpus* p_train_cor=nullptr)
+	{
+		std::cerr << "Loading lexical shortlist from " << lex_file << "..." << std::endl;
+		std::ifstream inpf(lex_file);
+		if (!inpf) TRANSFORMER_RUNTIME_ASSERT("Failed to open lexical shortlist file: " + lex_file);
+
+		std::vector<std::vector<std::pair<float, unsigned>>> v_cands(sd.size());
+		std::string line, sword, tword;
+		float prob;
+		unsigned num_entries = 0;
+		while (std::getline(inpf, line)) {
+			std::istringstream ss(line);
+			if (!(ss >> sword >> tword >> prob)) continue;
+			if (!sd.contains(sword) || !td.contains(tword)) continue;// outside of the model's vocabularies
+
+			v_cands[sd.convert(sword)].push_back(std::make_pair(prob, (unsigned)td.convert(tword)));
+			num_entries++;
+		}
+
+		_translations.resize(sd.size());
+		for (size_t s = 0; s < v_cands.size(); s++) {
+			auto& cands = v_cands[s];
+			size_t k = std::min((size_t)topk, cands.size());
+			std::partial_sort(cands.begin(), cands.begin() + k, cands.end()
+				, [](const std::pair<float, unsigned>& c1, const std::pair<float, unsigned>& c2){ return c1.first > c2.first; });
+			for (size_t i = 0; i < k; i++) _translations[s].push_back(cands[i].second);
+		}
+
+		std::vector<unsigned> v_tids(td.size());// target ids by decreasing frequency
+		std::iota(v_tids.begin(), v_tids.end(), 0);
+		if (p_train_cor != nullptr){// ids of a vocabulary built from the corpus follow the order of first occurrence
+			std::vector<unsigned> v_freqs(td.size(), 0);
+			for (auto& sent : *p_train_cor)
+				for (auto& t : std::get<1>(sent))
+					if (t >= 0 && t < (int)v_freqs.size()) v_freqs[t]++;
+			std::stable_sort(v_tids.begin(), v_tids.end(), [&v_freqs](unsigned t1, unsigned t2){ return v_freqs[t1] > v_freqs[t2]; });
+		}
+		for (unsigned i = 0; i < std::min(nfreq, td.size()); i++) _common.push_back(v_tids[i]);
+		for (int t : always) _common.push_back(t);
+
+		_tgt_vocab_size = td.size();
+
+		std::cerr << "Loaded " << num_entries << " entries (keeping top " << topk << " per source word, plus " << _common.size() << " common target words)." << std::endl;
+	}
+
+	// sorted target word ids allowed for the given source sentences
+	std::vector<unsigned> build(const WordIdSentences& sources) const
+	{
+		std::vector<bool> v_used(_tgt_vocab_size, false);
+		for (unsigned t : _common) v_used[t] = true;
+		for (auto& source : sources) {
+			for (auto& s : source) {
+				if (s < 0 || s >= (int)_translations.size()) continue;
+				for (unsigned t : _translations[s]) v_used[t] = true;
+			}
+		}
+
+		std::vector<unsigned> ids;
+		for (unsigned t = 0; t < _tgt_vocab_size; t++)
+			if (v_used[t]) ids.push_back(t);
+		return ids;
+	}
+
+	std::vector<std::vector<unsigned>> _translations;// top translations of each source word
+	std::vector<unsigned> _common;// target words allowed for every sentence
+	unsigned _tgt_vocab_size;
+};
+// ---
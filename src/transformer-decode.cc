@@ -4,11 +4,14 @@
 */
 
 #include "ensemble-decoder.h"
+#include "server-utils.h"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <limits>
+#include <atomic>
+#include <thread>
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
@@ -41,7 +44,17 @@ void decode(const std::string test_file
 	, unsigned beam_size=5
 	, unsigned int lc=0 /*line number to be continued*/
 	, bool remove_unk=false /*whether to include <unk> in the output*/
-	, bool r2l_target=false /*right-to-left decoding*/);
+	, bool r2l_target=false /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist=nullptr /*output vocabulary restriction*/);
+void decode_batch(const std::string test_file
+	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
+	, unsigned decode_batch_size
+	, unsigned beam_size=5
+	, unsigned int lc=0 /*line number to be continued*/
+	, bool remove_unk=false /*whether to include <unk> in the output*/
+	, bool r2l_target=false /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist=nullptr /*output vocabulary restriction*/
+	, unsigned num_workers=1 /*no. of threads decoding batches concurrently*/);
 void decode_nbest(const std::string test_file
 	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
 	, unsigned topk
@@ -49,7 +62,16 @@ void decode_nbest(const std::string test_file
 	, unsigned beam_size=5
 	, unsigned int lc=0 /*line number to be continued*/
 	, bool remove_unk=false /*whether to include <unk> in the output*/
-	, bool r2l_target=false /*right-to-left decoding*/);
+	, bool r2l_target=false /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist=nullptr /*output vocabulary restriction*/);
+void serve(const std::string& server_path
+	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
+	, unsigned max_batch_size
+	, unsigned latency_ms
+	, unsigned beam_size=5
+	, bool remove_unk=false /*whether to include <unk> in the output*/
+	, bool r2l_target=false /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist=nullptr /*output vocabulary restriction*/);
 // ---
 
 //************************************************************************************************************************************************************
@@ -66,6 +88,8 @@ int main(int argc, char** argv) {
 		("config,c", value<std::string>(), "config file specifying additional command line options")
 		//-----------------------------------------
 		("dynet-autobatch", value<unsigned>()->default_value(0), "impose the auto-batch mode (support both GPU and CPU); no by default")
+		("dynet-threads", value<unsigned>()->default_value(1), "impose the no. of CPU threads used within each operation (CPU only); 1 by default")
+		("dynet-graph-threads", value<unsigned>()->default_value(1), "impose the no. of CPU threads running independent operations of the computation graph concurrently (CPU only); 1 by default")
 		//-----------------------------------------
 		("train,t", value<std::string>(), "file containing training sentences, with each line consisting of source ||| target.")		
 		("train-percent", value<unsigned>()->default_value(100), "use <num> percent of sentences in training data; full by default")
@@ -80,11 +104,22 @@ int main(int argc, char** argv) {
 		("lc", value<unsigned int>()->default_value(0), "specify the sentence/line number to be continued (for decoding only); 0 by default")
 		//-----------------------------------------
 		("beam,b", value<unsigned>()->default_value(1), "size of beam in decoding; 1: greedy")
+		("decode-batch-size", value<unsigned>()->default_value(1), "decode <num> sentences (grouped by length) together; 1 (sentence by sentence) by default")
+		("decode-workers", value<unsigned>()->default_value(1), "decode batches on <num> threads concurrently, each with its own replica of the model(s) sharing the loaded parameters; 1 by default")
 		("topk,k", value<unsigned>(), "use <num> top kbest entries; none by default")
 		("nbest-style", value<std::string>()->default_value("simple"), "style for nbest translation outputs (moses|simple); simple by default")
 		//-----------------------------------------
+		("server", value<std::string>(), "run as a persistent translation server (instead of decoding --test), reading \"[<id> ||| ]<sentence>\" requests from stdin and replying \"<id> ||| <translation>\" on stdout with '-', or from clients of a local UNIX socket at <path> otherwise; none by default")
+		("server-latency", value<unsigned>()->default_value(10), "impose the max. time (in milliseconds) a request waits for others to be decoded together with (up to --decode-batch-size sentences) in server mode; 10 by default")
+		//-----------------------------------------
 		("model-cfg,m", value<std::string>(), "model configuration file (to support ensemble decoding)")
 		//-----------------------------------------
+		("shortlist", value<std::string>(), "lexical table (lines of <source word> <target word> <p(target|source)>) restricting the output vocabulary of each decoding batch to likely translations of its source words; none by default")
+		("shortlist-topk", value<unsigned>()->default_value(100), "use <num> best translations per source word in the shortlist; 100 by default")
+		("shortlist-freq", value<unsigned>()->default_value(100), "always include the <num> most frequent target words (counted from --train, or the first entries of --tgt-vocab) in the shortlist; 100 by default")
+		//-----------------------------------------
+		("int8", "use int8 quantised weights (with per-row scales) for all linear projections incl. the output layer; for decoding on CPU only; default not")
+		//-----------------------------------------
 		("remove-unk", "remove <unk> in the output; default not")
 		//-----------------------------------------
 		("r2l-target", "use right-to-left direction for target during training; default not")
@@ -114,7 +149,7 @@ int main(int argc, char** argv) {
 	
 	// print help
 	if (vm.count("help") 
-		|| !(vm.count("train") || (vm.count("src-vocab") && vm.count("tgt-vocab"))) || !vm.count("test"))
+		|| !(vm.count("train") || (vm.count("src-vocab") && vm.count("tgt-vocab"))) || !(vm.count("test") || vm.count("server")))
 	{
 		cout << opts << "\n";
 		return EXIT_FAILURE;
@@ -141,11 +176,29 @@ int main(int argc, char** argv) {
 	if (!load_model_config(vm["model-cfg"].as<std::string>(), v_tf_models, sd, td, sm))
 		TRANSFORMER_RUNTIME_ASSERT("Failed to load model(s)!");
 
+	// quantise the models for faster inference
+	if (vm.count("int8")){
+		cerr << "Quantising model(s) to int8..." << endl;
+		for (auto& tf : v_tf_models)
+			tf.get()->quantize();
+	}
+
+	// load the lexical shortlist
+	std::unique_ptr<LexicalShortlist> shortlist;
+	if (vm.count("shortlist"))
+		shortlist.reset(new LexicalShortlist(vm["shortlist"].as<std::string>(), sd, td, vm["shortlist-topk"].as<unsigned>(), vm["shortlist-freq"].as<unsigned>(), {sm._kTGT_SOS, sm._kTGT_EOS, sm._kTGT_UNK}
+			, ("" == vm["tgt-vocab"].as<std::string>()) ? &train_cor : nullptr/*most frequent target words counted from --train*/));
+
+	// serve translation requests with the models loaded once
+	if (vm.count("server"))
+		serve(vm["server"].as<std::string>(), v_tf_models, vm["decode-batch-size"].as<unsigned>(), vm["server-latency"].as<unsigned>(), vm["beam"].as<unsigned>(), vm.count("remove-unk"), vm.count("r2l-target"), shortlist.get());
 	// decode the input file
-	if (vm.count("topk"))
-		decode_nbest(vm["test"].as<std::string>(), v_tf_models, vm["topk"].as<unsigned>(), vm["nbest-style"].as<std::string>(), vm["beam"].as<unsigned>(), vm["lc"].as<unsigned int>(), vm.count("remove-unk"), vm.count("r2l-target"));
+	else if (vm.count("topk"))
+		decode_nbest(vm["test"].as<std::string>(), v_tf_models, vm["topk"].as<unsigned>(), vm["nbest-style"].as<std::string>(), vm["beam"].as<unsigned>(), vm["lc"].as<unsigned int>(), vm.count("remove-unk"), vm.count("r2l-target"), shortlist.get());
+	else if (vm["decode-batch-size"].as<unsigned>() > 1 || vm["decode-workers"].as<unsigned>() > 1)
+		decode_batch(vm["test"].as<std::string>(), v_tf_models, vm["decode-batch-size"].as<unsigned>(), vm["beam"].as<unsigned>(), vm["lc"].as<unsigned int>(), vm.count("remove-unk"), vm.count("r2l-target"), shortlist.get(), vm["decode-workers"].as<unsigned>());
 	else
-		decode(vm["test"].as<std::string>(), v_tf_models, vm["beam"].as<unsigned>(), vm["lc"].as<unsigned int>(), vm.count("remove-unk"), vm.count("r2l-target"));
+		decode(vm["test"].as<std::string>(), v_tf_models, vm["beam"].as<unsigned>(), vm["lc"].as<unsigned int>(), vm.count("remove-unk"), vm.count("r2l-target"), shortlist.get());
 
 	return EXIT_SUCCESS;
 }
@@ -287,7 +340,8 @@ void decode(const std::string test_file
 	, unsigned beam_size
 	, unsigned int lc /*line number to be continued*/
 	, bool remove_unk /*whether to include <unk> in the output*/
-	, bool r2l_target /*right-to-left decoding*/)
+	, bool r2l_target /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist /*output vocabulary restriction*/)
 {
 	dynet::Dict& sd = v_models[0].get()->get_source_dict();
 	dynet::Dict& td = v_models[0].get()->get_target_dict();
@@ -297,6 +351,7 @@ void decode(const std::string test_file
 
 	EnsembleDecoder ens(td);
 	ens.set_beam_size(beam_size);
+	ens.set_shortlist(shortlist);
 
 	cerr << "Reading test examples from " << test_file << endl;
 	ifstream in(test_file);
@@ -353,6 +408,202 @@ void decode(const std::string test_file
 }
 // ---
 
+// ---
+void decode_batch(const std::string test_file
+	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
+	, unsigned decode_batch_size
+	, unsigned beam_size
+	, unsigned int lc /*line number to be continued*/
+	, bool remove_unk /*whether to include <unk> in the output*/
+	, bool r2l_target /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist /*output vocabulary restriction*/
+	, unsigned num_workers /*no. of threads decoding batches concurrently*/)
+{
+	dynet::Dict& sd = v_models[0].get()->get_source_dict();
+	dynet::Dict& td = v_models[0].get()->get_target_dict();
+	const transformer::SentinelMarkers& sm = v_models[0].get()->get_config()._sm;
+
+	if (beam_size <= 0) TRANSFORMER_RUNTIME_ASSERT("Beam size must be >= 1!");
+	if (num_workers <= 0) TRANSFORMER_RUNTIME_ASSERT("No. of decoding workers must be >= 1!");
+
+	EnsembleDecoder ens(td);
+	ens.set_beam_size(beam_size);
+	ens.set_shortlist(shortlist);
+
+	cerr << "Reading test examples from " << test_file << endl;
+	ifstream in(test_file);
+	assert(in);
+
+	MyTimer timer_dec("completed in");
+	std::string line;
+	WordIdSentences sources;
+	unsigned int lno = 0;
+	while (std::getline(in, line)) {
+		if (lno++ < lc) continue;// continued decoding
+
+		sources.push_back(dynet::read_sentence(line, sd));
+
+		if (sources.back().front() != sm._kSRC_SOS && sources.back().back() != sm._kSRC_EOS) {
+			cerr << "Sentence in " << test_file << ":" << lno << " didn't start or end with <s>, </s>\n";
+			abort();
+		}
+	}
+
+	// group sentences with similar lengths to minimise paddings
+	std::vector<size_t> ids(sources.size());
+	std::iota(ids.begin(), ids.end(), 0);
+	std::stable_sort(ids.begin(), ids.end(), [&sources](size_t i1, size_t i2){ return sources[i1].size() < sources[i2].size(); });
+
+	// the models keep per-graph state, hence each worker decodes with its own replicas (sharing the parameters)
+	std::vector<std::vector<std::shared_ptr<transformer::TransformerModel>>> v_worker_models(num_workers);
+	v_worker_models[0] = v_models;
+	for (unsigned w = 1; w < num_workers; w++)
+		for (auto& tf : v_models)
+			v_worker_models[w].push_back(tf.get()->replicate());
+
+	std::vector<WordIdSentence> targets(sources.size());
+	std::atomic<size_t> next_batch(0);
+	auto decode_batches = [&](unsigned w){
+		EnsembleDecoder ens_w(ens);
+		size_t i;
+		while ((i = next_batch.fetch_add(decode_batch_size)) < ids.size()) {
+			WordIdSentences batch_sources;
+			for (size_t j = i; j < std::min(i + decode_batch_size, ids.size()); j++)
+				batch_sources.push_back(sources[ids[j]]);
+
+			ComputationGraph cg;// dynamic computation graph
+
+			std::vector<EnsembleDecoderHypPtr> v_trg_hyps = ens_w.generate(cg, batch_sources, v_worker_models[w]);
+			for (size_t j = 0; j < v_trg_hyps.size(); j++) {
+				if (v_trg_hyps[j].get() != nullptr) 
+					targets[ids[i + j]] = v_trg_hyps[j]->get_sentence();
+			}
+		}
+	};
+	if (num_workers == 1)
+		decode_batches(0);
+	else{
+		std::vector<std::thread> workers;
+		for (unsigned w = 0; w < num_workers; w++)
+			workers.push_back(std::thread([&decode_batches, w](){
+				dynet::ExecutionContext ctx;// own memory pools for the graphs of this thread
+				dynet::ExecutionContext::Scope scope(ctx);
+				decode_batches(w);
+			}));
+		for (auto& worker : workers) worker.join();
+	}
+
+	// write the translations in the original order
+	for (auto& target : targets) {
+		if (r2l_target && target.size() > 1)
+			std::reverse(target.begin() + 1, target.end() - 1);
+
+		bool first = true;
+		for (auto &w: target) {
+			if (!first) cout << " ";
+
+			if (remove_unk && w == sm._kTGT_UNK) continue;
+
+			cout << td.convert(w);
+
+			first = false;
+		}
+		cout << endl;
+	}
+
+	double elapsed = timer_dec.elapsed();
+	cerr << "Decoding is finished!" << endl;
+	cerr << "Decoded " << (lno - lc) << " sentences, completed in " << elapsed/1000 << "(s)" << endl;
+}
+// ---
+
+// ---
+void serve(const std::string& server_path
+	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
+	, unsigned max_batch_size
+	, unsigned latency_ms
+	, unsigned beam_size
+	, bool remove_unk /*whether to include <unk> in the output*/
+	, bool r2l_target /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist /*output vocabulary restriction*/)
+{
+	dynet::Dict& sd = v_models[0].get()->get_source_dict();
+	dynet::Dict& td = v_models[0].get()->get_target_dict();
+	const transformer::SentinelMarkers& sm = v_models[0].get()->get_config()._sm;
+
+	if (beam_size <= 0) TRANSFORMER_RUNTIME_ASSERT("Beam size must be >= 1!");
+	if (max_batch_size <= 0) TRANSFORMER_RUNTIME_ASSERT("Decode batch size must be >= 1!");
+
+	EnsembleDecoder ens(td);
+	ens.set_beam_size(beam_size);
+	ens.set_shortlist(shortlist);
+
+	// requests are accepted concurrently, but decoded by this thread only since the models keep per-graph state
+	TranslationRequestQueue queue;
+	std::thread reader;
+	if ("-" == server_path){
+		cerr << "Serving translation requests from stdin..." << endl;
+		reader = std::thread([&queue](){
+			read_requests(TranslationChannelPtr(new TranslationChannel(STDIN_FILENO, STDOUT_FILENO, false)), queue);
+			queue.close();
+		});
+	}
+	else{
+		reader = std::thread([&queue, server_path](){
+			listen_for_requests(server_path, queue);
+			queue.close();
+		});
+	}
+
+	MyTimer timer_dec("completed in");
+	unsigned num_reqs = 0, num_batches = 0;
+	std::vector<TranslationRequest> batch;
+	while (queue.pop_batch(batch, max_batch_size, std::chrono::milliseconds(latency_ms))) {
+		WordIdSentences sources;
+		for (auto& req : batch) {
+			sources.push_back(dynet::read_sentence(req._source, sd));
+
+			// be lenient with clients: add the sentinel markers if missing
+			WordIdSentence& source = sources.back();
+			if (source.empty() || source.front() != sm._kSRC_SOS) source.insert(source.begin(), sm._kSRC_SOS);
+			if (source.size() == 1 || source.back() != sm._kSRC_EOS) source.push_back(sm._kSRC_EOS);
+		}
+
+		ComputationGraph cg;// dynamic computation graph
+
+		std::vector<EnsembleDecoderHypPtr> v_trg_hyps = ens.generate(cg, sources, v_models);
+		for (size_t j = 0; j < batch.size(); j++) {
+			WordIdSentence target;
+			if (v_trg_hyps[j].get() != nullptr) 
+				target = v_trg_hyps[j]->get_sentence();
+
+			if (r2l_target && target.size() > 1)
+				std::reverse(target.begin() + 1, target.end() - 1);
+
+			std::stringstream ss;
+			ss << batch[j]._id << " |||";
+			for (auto &w: target) {
+				if (remove_unk && w == sm._kTGT_UNK) continue;
+
+				ss << " " << td.convert(w);
+			}
+
+			if (!batch[j]._channel->write_line(ss.str()))
+				cerr << "Failed to send the translation of request " << batch[j]._id << " (client gone?)" << endl;
+		}
+
+		num_reqs += batch.size();
+		num_batches++;
+	}
+
+	reader.join();
+
+	double elapsed = timer_dec.elapsed();
+	cerr << "Serving is finished!" << endl;
+	cerr << "Decoded " << num_reqs << " sentences in " << num_batches << " batches, completed in " << elapsed/1000 << "(s)" << endl;
+}
+// ---
+
 // ---
 void decode_nbest(const std::string test_file
 	, std::vector<std::shared_ptr<transformer::TransformerModel>>& v_models
@@ -361,7 +612,8 @@ void decode_nbest(const std::string test_file
 	, unsigned beam_size
 	, unsigned int lc /*line number to be continued*/
 	, bool remove_unk /*whether to include <unk> in the output*/
-	, bool r2l_target /*right-to-left decoding*/)
+	, bool r2l_target /*right-to-left decoding*/
+	, const LexicalShortlist* shortlist /*output vocabulary restriction*/)
 {
 	dynet::Dict& sd = v_models[0].get()->get_source_dict();
 	dynet::Dict& td = v_models[0].get()->get_target_dict();
@@ -373,6 +625,7 @@ void decode_nbest(const std::string test_file
 
 	EnsembleDecoder ens(td);
 	ens.set_beam_size(beam_size);
+	ens.set_shortlist(shortlist);
 
 	cerr << "Reading test examples from " << test_file << endl;
 	ifstream in(test_file);
@@ -99,8 +99,10 @@ int main(int argc, char** argv) {
 		("vocab", value<std::string>()->default_value(""), "file containing vocabulary file; none by default (will be built from train file)")
 		("train-percent", value<unsigned>()->default_value(100), "use <num> percent of sentences in training data; full by default")
 		//-----------------------------------------
-		("minibatch-size,b", value<unsigned>()->default_value(1), "impose the minibatch size for training (support both GPU and CPU); single batch by default")
+		("minibatch-size,b", value<unsigned>()->default_value(1), "impose the minibatch size for training and perplexity scoring (support both GPU and CPU); single batch by default")
 		("dynet-autobatch", value<unsigned>()->default_value(0), "impose the auto-batch mode (support both GPU and CPU); no by default")
+		("dynet-threads", value<unsigned>()->default_value(1), "impose the no. of CPU threads used within each operation (CPU only); 1 by default")
+		("dynet-graph-threads", value<unsigned>()->default_value(1), "impose the no. of CPU threads running independent operations of the computation graph concurrently (CPU only); 1 by default")
 		//-----------------------------------------
 		("sgd-trainer", value<unsigned>()->default_value(0), "use specific SGD trainer (0: vanilla SGD; 1: momentum SGD; 2: Adagrad; 3: AdaDelta; 4: Adam; 5: RMSProp; 6: cyclical SGD)")
 		("sparse-updates", value<bool>()->default_value(true), "enable/disable sparse update(s) for lookup parameter(s); true by default")
@@ -423,35 +425,48 @@ void report_perplexity_score(std::vector<std::shared_ptr<transformer::Transforme
 	// Sentinel symbols
 	const transformer::SentinelMarkers& sm = v_tf_models[0].get()->get_config()._sm;
 
-	transformer::ModelStats dstats;
-	for (unsigned i = 0; i < test_cor.size(); ++i) {
-		cerr << "Processing sent " << i << "..." << endl;;
-		WordIdSentence tsent = test_cor[i];  
+	// create minibatches (sorted by length to minimise padding)
+	std::vector<WordIdSentences> test_cor_minibatch;
+	std::vector<size_t> test_ids_minibatch;
+	create_minibatches(test_cor, MINIBATCH_SIZE, test_cor_minibatch, test_ids_minibatch);
 
-		dynet::ComputationGraph cg;
-		WordIdSentence partial_sent(1, sm._kTGT_SOS);
-		for (unsigned i = 1; i < tsent.size(); i++){// shifted to the right
-			WordId wordid = tsent[i];
-			dstats._words_tgt++;
-			if (wordid == sm._kTGT_UNK) dstats._words_tgt_unk++;
-
-			// Perform the forward step on all models
-			std::vector<Expression> i_softmaxes, i_aligns/*unused for now*/;
-			for(int j : boost::irange(0, (int)v_tf_models.size())){
-				i_softmaxes.push_back(v_tf_models[j].get()->step_forward(cg
-					, partial_sent
-					, false
-					, i_aligns));
+	transformer::ModelStats dstats;
+	unsigned nsents = 0;
+	for (const WordIdSentences& tsents : test_cor_minibatch) {
+		cerr << "Processing sents " << nsents << "-" << nsents + tsents.size() - 1 << "..." << endl;
+		nsents += tsents.size();
+
+		// next words and padding masks, one entry per (sentence, position) shifted to the right
+		unsigned tlen = 0;
+		for (auto& tsent : tsents) tlen = std::max(tlen, (unsigned)tsent.size());
+		std::vector<unsigned> next_words((tlen - 1) * tsents.size(), sm._kTGT_EOS);
+		std::vector<float> v_masks((tlen - 1) * tsents.size(), 0.f);
+		for (unsigned bs = 0; bs < tsents.size(); ++bs){
+			for (unsigned t = 1; t < tsents[bs].size(); ++t){
+				next_words[bs * (tlen - 1) + t - 1] = (unsigned)tsents[bs][t];
+				v_masks[bs * (tlen - 1) + t - 1] = 1.f;
+
+				dstats._words_tgt++;
+				if (tsents[bs][t] == sm._kTGT_UNK) dstats._words_tgt_unk++;
 			}
+		}
 
-			dynet::Expression i_logprob = dynet::log({dynet::average(i_softmaxes)});
-			dynet::Expression i_loss = -dynet::pick(i_logprob, wordid);
-			dstats._losses[0] += dynet::as_scalar(cg.incremental_forward(i_loss));
-
-			partial_sent.push_back(wordid);
+		dynet::ComputationGraph cg;
 
-			cg.clear();
-		}
+		// perform a single teacher-forced forward pass on all models
+		dynet::Expression i_loss;
+		if (v_tf_models.size() == 1)
+			i_loss = dynet::pickneglogsoftmax(v_tf_models[0].get()->compute_logits(cg, tsents), next_words);
+		else{
+			std::vector<Expression> i_softmaxes;
+			for(int j : boost::irange(0, (int)v_tf_models.size()))
+				i_softmaxes.push_back(dynet::softmax(v_tf_models[j].get()->compute_logits(cg, tsents)));
+			i_loss = -dynet::pick(dynet::log(dynet::average(i_softmaxes)), next_words);
+		}// ((1, 1), (Ly-1) * batch_size)
+
+		dynet::Expression i_mask = dynet::input(cg, dynet::Dim({1}, next_words.size()), v_masks);
+		i_loss = dynet::sum_batches(dynet::cmult(i_loss, i_mask));
+		dstats._losses[0] += dynet::as_scalar(cg.incremental_forward(i_loss));
 	}
 		
 	cerr << "--------------------------------------------------------------------------------------------------------" << endl;
@@ -84,28 +84,15 @@ struct LMDecoderLayer{
 		// multi-head self attention sub-layer
 		dynet::Expression i_mh_self_att = _self_attention_sublayer.build_graph(cg, i_decl, i_decl, self_mask);// ((num_units, Ly), batch_size)
 
-		// dropout to the output of sub-layer
-		if (_p_tfc->_use_dropout && _p_tfc->_decoder_sublayer_dropout_rate > 0.f)
-#ifdef USE_COLWISE_DROPOUT
-			i_mh_self_att = dynet::dropout_dim(i_mh_self_att, 1/*col-major*/, _p_tfc->_decoder_sublayer_dropout_rate);// col-wise dropout
-#else
-			i_mh_self_att = dynet::dropout(i_mh_self_att, _p_tfc->_decoder_sublayer_dropout_rate);// full dropout
-#endif
-
-		// w/ residual connection
-		i_decl = i_decl + i_mh_self_att;// ((num_units, Ly), batch_size)
-
-		// layer normalisation 1
-		i_decl = layer_norm_colwise_3(i_decl, i_ln1_g, i_ln1_b);// ((num_units, Ly), batch_size)
+		// dropout to the output of sub-layer, w/ residual connection, then layer normalisation 1 (fused)
+		i_decl = residual_layer_norm(i_decl, i_mh_self_att, i_ln1_g, i_ln1_b
+			, _p_tfc->_use_dropout ? _p_tfc->_decoder_sublayer_dropout_rate : 0.f);// ((num_units, Ly), batch_size)
 
 		// position-wise feed-forward sub-layer
 		dynet::Expression i_ff = _feed_forward_sublayer.build_graph(cg, i_decl);// ((num_units, Ly), batch_size)
 
-		// w/ residual connection
-		i_decl = i_decl + i_ff;
-
-		// layer normalisation 3
-		i_decl = layer_norm_colwise_3(i_decl, i_ln2_g, i_ln2_b);// ((num_units, Ly), batch_size)
+		// w/ residual connection, then layer normalisation 3 (fused)
+		i_decl = residual_layer_norm(i_decl, i_ff, i_ln2_g, i_ln2_b);// ((num_units, Ly), batch_size)
 
 		return i_decl;
 	}
@@ -301,6 +288,8 @@ public:
 		, const WordIdSentence &partial_sent
 		, bool log_prob
 		, std::vector<dynet::Expression> &aligns);
+	dynet::Expression compute_logits(dynet::ComputationGraph &cg
+		, const WordIdSentences& sents/*batched*/);// for scoring (teacher forcing over all positions at once)
 	std::string sample(dynet::ComputationGraph& cg, WordIdSentence &sampled_sent, const std::string &prefix=""/*e.g., <s>*/);// sampling
 
 	dynet::ParameterCollection& get_model_parameters();
@@ -361,8 +350,8 @@ dynet::Expression TransformerLModel::step_forward(dynet::ComputationGraph &cg
 
 	// output linear projections (w/ bias)
 	dynet::Expression i_Wo_bias = dynet::parameter(cg, _p_Wo_bias);
-	dynet::Expression i_Wo_emb_tgt = dynet::transpose(_decoder.get()->get_wrd_embedding_matrix(cg));// weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
-	dynet::Expression i_r_t = dynet::affine_transform({i_Wo_bias, i_Wo_emb_tgt, i_tgt_t});// |V_T| x 1 (with additional bias)
+	dynet::Expression i_Wo_emb_tgt = _decoder.get()->get_wrd_embedding_matrix(cg);// num_units x |V_T|; weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
+	dynet::Expression i_r_t = dynet::affine_transform_t({i_Wo_bias, i_Wo_emb_tgt, i_tgt_t});// |V_T| x 1 (with additional bias)
 
 	// FIXME: get the alignments for visualisation
 
@@ -383,48 +372,55 @@ dynet::Expression TransformerLModel::build_graph(dynet::ComputationGraph &cg
 
 	// get losses	
 	dynet::Expression i_Wo_bias = dynet::parameter(cg, _p_Wo_bias);
-	dynet::Expression i_Wo_emb_tgt = dynet::transpose(_decoder.get()->get_wrd_embedding_matrix(cg));// weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
+	dynet::Expression i_Wo_emb_tgt = _decoder.get()->get_wrd_embedding_matrix(cg);// num_units x |V_T|; weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
 
 	// compute the logit and linear projections
-	dynet::Expression i_r = dynet::affine_transform({i_Wo_bias, i_Wo_emb_tgt, i_tgt_ctx});// ((|V_T|, (Ly-1)), batch_size)
+	dynet::Expression i_r = dynet::affine_transform_t({i_Wo_bias, i_Wo_emb_tgt, i_tgt_ctx});// ((|V_T|, (Ly-1)), batch_size)
 
-	std::vector<dynet::Expression> v_errors;
+	// targets and masks over the whole ((|V_T|, Ly-1), batch_size) logit tensor; padded positions are masked out
 	unsigned tlen = _decoder.get()->_batch_tlen;
-	std::vector<unsigned> next_words(tsents.size());
-	for (unsigned t = 0; t < tlen - 1; ++t) {// shifted right
-		for(size_t bs = 0; bs < tsents.size(); bs++){
-			next_words[bs] = (tsents[bs].size() > (t + 1)) ? (unsigned)tsents[bs][t + 1] : _tfc._sm._kTGT_EOS;
-			if (tsents[bs].size() > t) {
-				stats._words_tgt++;
-				if (tsents[bs][t] == _tfc._sm._kTGT_UNK) stats._words_tgt_unk++;
-			}
+	unsigned ctx_len = i_r.dim()[1];
+	std::vector<unsigned> next_words(ctx_len * tsents.size(), _tfc._sm._kTGT_EOS);
+	std::vector<float> masks(ctx_len * tsents.size(), 0.f);
+	for(size_t bs = 0; bs < tsents.size(); bs++){
+		for (unsigned t = 0; t + 1 < tsents[bs].size() && t < ctx_len; ++t) {// shifted right
+			next_words[bs * ctx_len + t] = (unsigned)tsents[bs][t + 1];
+			masks[bs * ctx_len + t] = 1.f;
 		}
 
-		// get the prediction at timestep t
-		//dynet::Expression i_r_t = dynet::select_cols(i_r, {t});// shifted right, ((|V_T|, 1), batch_size)
-		dynet::Expression i_r_t = dynet::pick(i_r, t, 1);// shifted right, ((|V_T|, 1), batch_size)
-	
-		// log_softmax and loss
-		dynet::Expression i_err;
-		if (_tfc._use_label_smoothing && !is_eval_on_dev/*only applies in training*/)
-		{// w/ label smoothing (according to section 7.5.1 of http://www.deeplearningbook.org/contents/regularization.html) and https://arxiv.org/pdf/1512.00567v1.pdf.
-			// label smoothing regularizes a model based on a softmax with k output values by replacing the hard 0 and 1 classification targets with targets of \epsilon / (k−1) and 1 − \epsilon, respectively!
-			dynet::Expression i_log_softmax = dynet::log_softmax(i_r_t);
-			dynet::Expression i_pre_loss = -dynet::pick(i_log_softmax, next_words);
-			dynet::Expression i_ls_loss = -dynet::sum_elems(i_log_softmax) / (_tfc._tgt_vocab_size - 1);// or -dynet::mean_elems(i_log_softmax)
-			i_err = (1.f - _tfc._label_smoothing_weight) * i_pre_loss + _tfc._label_smoothing_weight * i_ls_loss;
+		for (unsigned t = 0; t < std::min(tlen - 1, (unsigned)tsents[bs].size()); ++t) {
+			stats._words_tgt++;
+			if (tsents[bs][t] == _tfc._sm._kTGT_UNK) stats._words_tgt_unk++;
 		}
-		else 
-			i_err = dynet::pickneglogsoftmax(i_r_t, next_words);
-
-		v_errors.push_back(i_err);
 	}
 
+	// fused log_softmax and loss (w/ label smoothing only applies in training), see dynet::softmax_cross_entropy
+	float ls_weight = (_tfc._use_label_smoothing && !is_eval_on_dev) ? _tfc._label_smoothing_weight : 0.f;
+	std::vector<dynet::Expression> v_errors(1, dynet::softmax_cross_entropy(i_r, next_words, masks, ls_weight));
+
 	dynet::Expression i_tloss = dynet::sum_batches(dynet::sum(v_errors));
 
 	return i_tloss;
 }
 
+dynet::Expression TransformerLModel::compute_logits(dynet::ComputationGraph &cg
+	, const WordIdSentences& tsents)
+{
+	// decode target (a single pass over all positions of all sentences)
+	dynet::Expression i_tgt_ctx = _decoder.get()->build_graph(cg, tsents);// ((num_units, Ly), batch_size)
+	unsigned tlen = _decoder.get()->_batch_tlen;
+	if (i_tgt_ctx.dim()[1] == tlen)// the last position has nothing to predict
+		i_tgt_ctx = dynet::pick_range(i_tgt_ctx, 0, tlen - 1, 1);// ((num_units, Ly-1), batch_size)
+
+	// output linear projections (w/ bias)
+	dynet::Expression i_Wo_bias = dynet::parameter(cg, _p_Wo_bias);
+	dynet::Expression i_Wo_emb_tgt = _decoder.get()->get_wrd_embedding_matrix(cg);// num_units x |V_T|; weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
+	dynet::Expression i_r = dynet::affine_transform_t({i_Wo_bias, i_Wo_emb_tgt, i_tgt_ctx});// ((|V_T|, (Ly-1)), batch_size)
+
+	// one batch element per (sentence, position) so that a single softmax covers all positions
+	return dynet::reshape(i_r, dynet::Dim({_tfc._tgt_vocab_size}, (tlen - 1) * tsents.size()));// ((|V_T|, 1), (Ly-1) * batch_size)
+}
+
 std::string TransformerLModel::sample(dynet::ComputationGraph& cg, WordIdSentence &target, const std::string& prefix)
 {
 	_tfc._is_training = false;
@@ -478,12 +474,12 @@ dynet::ParameterCollection& TransformerLModel::get_model_parameters(){
 
 void TransformerLModel::initialise_params_from_file(const std::string &params_file)
 {
-	dynet::load_dynet_model(params_file, _all_params.get());// FIXME: use binary streaming instead for saving disk spaces?
+	dynet::load_dynet_model(params_file, _all_params.get());// text or binary format (detected from the file header)
 }
 
 void TransformerLModel::save_params_to_file(const std::string &params_file)
 {
-	dynet::save_dynet_model(params_file, _all_params.get());// FIXME: use binary streaming instead for saving disk spaces?
+	dynet::save_dynet_model(params_file, _all_params.get(), true/*binary, memory-mappable on loading*/);
 }
 
 void TransformerLModel::set_dropout(bool is_activated){
@@ -26,6 +26,9 @@ using namespace boost::program_options;
 
 // hyper-paramaters for training
 unsigned MINIBATCH_SIZE = 1;
+unsigned BUCKET_WIDTH = 0;
+unsigned SRC_TOKEN_BUDGET = 0;
+unsigned TGT_TOKEN_BUDGET = 0;
 
 bool DEBUGGING_FLAG = false;
 
@@ -84,6 +87,7 @@ int main(int argc, char** argv) {
 		("train,t", value<std::vector<std::string>>(), "file containing training sentences, with each line consisting of source ||| target.")		
 		("devel,d", value<std::string>(), "file containing development sentences.")
 		("max-seq-len", value<unsigned>()->default_value(0), "limit the sentence length (either source or target); none by default")
+		("train-cache", value<std::string>()->default_value(""), "binary cache of the pre-tokenised (first) training corpus and its vocabularies; built on first use, then memory-mapped instead of re-reading the corpus; none by default")
 		("src-vocab", value<std::string>()->default_value(""), "file containing source vocabulary file; none by default (will be built from train file)")
 		("tgt-vocab", value<std::string>()->default_value(""), "file containing target vocabulary file; none by default (will be built from train file)")
 		("train-percent", value<unsigned>()->default_value(100), "use <num> percent of sentences in training data; full by default")
@@ -91,7 +95,12 @@ int main(int argc, char** argv) {
 		("shared-embeddings", "use shared source and target embeddings (in case that source and target use the same vocabulary; none by default")
 		//-----------------------------------------
 		("minibatch-size,b", value<unsigned>()->default_value(1), "impose the minibatch size for training (support both GPU and CPU); single batch by default")
+		("bucket-width", value<unsigned>()->default_value(0), "use bucketed batching, grouping sentences whose source and target lengths fall in the same buckets of <num> tokens; none by default")
+		("src-token-budget", value<unsigned>()->default_value(0), "impose the maximum no. of padded source tokens per minibatch in bucketed batching; --minibatch-size by default")
+		("tgt-token-budget", value<unsigned>()->default_value(0), "impose the maximum no. of padded target tokens per minibatch in bucketed batching; --minibatch-size by default")
 		("dynet-autobatch", value<unsigned>()->default_value(0), "impose the auto-batch mode (support both GPU and CPU); no by default")
+		("dynet-threads", value<unsigned>()->default_value(1), "impose the no. of CPU threads used within each operation (CPU only); 1 by default")
+		("dynet-graph-threads", value<unsigned>()->default_value(1), "impose the no. of CPU threads running independent operations of the computation graph concurrently (CPU only); 1 by default")
 		//-----------------------------------------
 		("sgd-trainer", value<unsigned>()->default_value(0), "use specific SGD trainer (0: vanilla SGD; 1: momentum SGD; 2: Adagrad; 3: AdaDelta; 4: Adam; 5: RMSProp; 6: cyclical SGD)")
 		("sparse-updates", value<bool>()->default_value(true), "enable/disable sparse update(s) for lookup parameter(s); true by default")
@@ -186,6 +195,9 @@ int main(int argc, char** argv) {
 	SAMPLING_TRAINING = vm.count("sampling");
 	PRINT_GRAPHVIZ = vm.count("print-graphviz");
 	MINIBATCH_SIZE = vm["minibatch-size"].as<unsigned>();
+	BUCKET_WIDTH = vm["bucket-width"].as<unsigned>();
+	SRC_TOKEN_BUDGET = vm["src-token-budget"].as<unsigned>();
+	TGT_TOKEN_BUDGET = vm["tgt-token-budget"].as<unsigned>();
 
 	// load fixed vocabularies from files if required
 	dynet::Dict sd, td;
@@ -271,15 +283,32 @@ bool load_data(const variables_map& vm
 	std::vector<std::string> train_paths = vm["train"].as<std::vector<std::string>>();// to handle multiple training data
 	if (train_paths.size() > 2) TRANSFORMER_RUNTIME_ASSERT("Invalid -t or --train parameter. Only maximum 2 training corpora provided!");	
 	cerr << endl << "Reading training data from " << train_paths[0] << "...\n";
-	if (vm.count("shared-embeddings"))
-		train_cor = read_corpus(train_paths[0], &sd, &sd, true, vm["max-seq-len"].as<unsigned>(), r2l_target & !swap);
-	else
-		train_cor = read_corpus(train_paths[0], &sd, &td, true, vm["max-seq-len"].as<unsigned>(), r2l_target & !swap);
-	if ("" == vm["src-vocab"].as<std::string>() 
-		&& "" == vm["tgt-vocab"].as<std::string>()) // if not using external vocabularies
+	std::string train_cache = vm["train-cache"].as<std::string>();
+	if ("" != train_cache 
+		&& load_corpus_cache(train_cache, train_paths[0], train_cor, sd, td, vm["max-seq-len"].as<unsigned>(), r2l_target & !swap
+			, vm.count("shared-embeddings"), vm["src-vocab"].as<std::string>(), vm["tgt-vocab"].as<std::string>()))
 	{
-		sd.freeze(); // no new word types allowed
-		td.freeze(); // no new word types allowed
+		// sentinel ids from the cached vocabularies
+		sm._kSRC_SOS = sd.convert("<s>");
+		sm._kSRC_EOS = sd.convert("</s>");
+		sm._kTGT_SOS = td.convert("<s>");
+		sm._kTGT_EOS = td.convert("</s>");
+	}
+	else{
+		if (vm.count("shared-embeddings"))
+			train_cor = read_corpus(train_paths[0], &sd, &sd, true, vm["max-seq-len"].as<unsigned>(), r2l_target & !swap);
+		else
+			train_cor = read_corpus(train_paths[0], &sd, &td, true, vm["max-seq-len"].as<unsigned>(), r2l_target & !swap);
+		if ("" == vm["src-vocab"].as<std::string>() 
+			&& "" == vm["tgt-vocab"].as<std::string>()) // if not using external vocabularies
+		{
+			sd.freeze(); // no new word types allowed
+			td.freeze(); // no new word types allowed
+		}
+
+		if ("" != train_cache)// one-time conversion, later runs map the cache instead
+			save_corpus_cache(train_cache, train_paths[0], train_cor, sd, td, vm["max-seq-len"].as<unsigned>(), r2l_target & !swap
+				, vm.count("shared-embeddings"), vm["src-vocab"].as<std::string>(), vm["tgt-vocab"].as<std::string>());
 	}
 	if (train_paths.size() == 2)// incremental training
 	{
@@ -393,7 +422,13 @@ void run_train(transformer::TransformerModel &tf, WordIdCorpus &train_cor, WordI
 	std::vector<std::vector<WordIdSentence> > train_trg_minibatch;
 	std::vector<size_t> train_ids_minibatch, dev_ids_minibatch;
 	size_t minibatch_size = MINIBATCH_SIZE;
-	create_minibatches(train_cor, minibatch_size, train_src_minibatch, train_trg_minibatch, train_ids_minibatch);
+	if (BUCKET_WIDTH > 0)
+		create_bucketed_minibatches(train_cor
+			, (SRC_TOKEN_BUDGET > 0) ? SRC_TOKEN_BUDGET : minibatch_size, (TGT_TOKEN_BUDGET > 0) ? TGT_TOKEN_BUDGET : minibatch_size
+			, BUCKET_WIDTH
+			, train_src_minibatch, train_trg_minibatch, train_ids_minibatch);
+	else
+		create_minibatches(train_cor, minibatch_size, train_src_minibatch, train_trg_minibatch, train_ids_minibatch);
   
 	double best_loss = 9e+99;
 	
@@ -407,6 +442,7 @@ void run_train(transformer::TransformerModel &tf, WordIdCorpus &train_cor, WordI
 	unsigned sid = 0, id = 0, last_print = 0;
 	MyTimer timer_epoch("completed in"), timer_iteration("completed in");
 	unsigned epoch = 0, cpt = 0/*count of patience*/;
+	size_t src_toks = 0, src_padded_toks = 0, tgt_toks = 0, tgt_padded_toks = 0;// for the padding ratio of each epoch
 	while (epoch < max_epochs) {
 		transformer::ModelStats tstats;
 
@@ -418,6 +454,9 @@ void run_train(transformer::TransformerModel &tf, WordIdCorpus &train_cor, WordI
 				cerr << "***Epoch " << epoch << " is finished. ";
 				timer_epoch.show();
 
+				cerr << "***Padding ratio (s & t): " << 100.f * (src_padded_toks - src_toks) / std::max(src_padded_toks, (size_t)1) << "% & " << 100.f * (tgt_padded_toks - tgt_toks) / std::max(tgt_padded_toks, (size_t)1) << "%" << endl;
+				src_toks = src_padded_toks = tgt_toks = tgt_padded_toks = 0;
+
 				epoch++;
 
 				id = 0;
@@ -446,6 +485,8 @@ void run_train(transformer::TransformerModel &tf, WordIdCorpus &train_cor, WordI
 	
 			transformer::ModelStats ctstats;
 			Expression i_xent = tf.build_graph(cg, train_src_minibatch[train_ids_minibatch[id]], train_trg_minibatch[train_ids_minibatch[id]], ctstats);
+			count_padding(train_src_minibatch[train_ids_minibatch[id]], src_toks, src_padded_toks);
+			count_padding(train_trg_minibatch[train_ids_minibatch[id]], tgt_toks, tgt_padded_toks);
 	
 			if (PRINT_GRAPHVIZ) {
 				cerr << "***********************************************************************************" << endl;
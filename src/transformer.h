@@ -33,6 +33,17 @@ struct EncoderLayer{
 
 	~EncoderLayer(){}
 
+	void quantize(){
+		_self_attention_sublayer.quantize();
+		_feed_forward_sublayer.quantize();
+	}
+
+	void rebind(TransformerConfig& tfc){
+		_self_attention_sublayer.rebind(tfc);
+		_feed_forward_sublayer.rebind(tfc);
+		_p_tfc = &tfc;
+	}
+
 	// multi-head attention sub-layer
 	MultiHeadAttentionLayer _self_attention_sublayer;
 
@@ -61,28 +72,15 @@ struct EncoderLayer{
 		// multi-head attention sub-layer
 		dynet::Expression i_mh_att = _self_attention_sublayer.build_graph(cg, i_encl, i_encl, self_mask);// ((num_units, Lx), batch_size)	
 
-		// dropout to the above sub-layer
-		if (_p_tfc->_use_dropout && _p_tfc->_encoder_sublayer_dropout_rate > 0.f)
-#ifdef USE_COLWISE_DROPOUT
-			i_mh_att = dynet::dropout_dim(i_mh_att, 1/*col-major*/, _p_tfc->_encoder_sublayer_dropout_rate);// col-wise dropout
-#else
-			i_mh_att = dynet::dropout(i_mh_att, _p_tfc->_encoder_sublayer_dropout_rate);// full dropout
-#endif
-
-		// w/ residual connection
-		i_encl = i_encl + i_mh_att;// ((num_units, Lx), batch_size)
-
-		// position-wise layer normalisation 1
-		i_encl = layer_norm_colwise_3(i_encl, i_ln1_g, i_ln1_b);// ((num_units, Lx), batch_size)
+		// dropout to the output of sub-layer, w/ residual connection, then position-wise layer normalisation 1 (fused)
+		i_encl = residual_layer_norm(i_encl, i_mh_att, i_ln1_g, i_ln1_b
+			, _p_tfc->_use_dropout ? _p_tfc->_encoder_sublayer_dropout_rate : 0.f);// ((num_units, Lx), batch_size)
 
 		// position-wise feed-forward sub-layer
 		dynet::Expression i_ff = _feed_forward_sublayer.build_graph(cg, i_encl);// ((num_units, Lx), batch_size)
 
-		// w/ residual connection
-		i_encl = i_encl + i_ff;// ((num_units, Lx), batch_size)
-
-		// position-wise layer normalisation 2
-		i_encl = layer_norm_colwise_3(i_encl, i_ln2_g, i_ln2_b);// ((num_units, Lx), batch_size)
+		// w/ residual connection, then position-wise layer normalisation 2 (fused)
+		i_encl = residual_layer_norm(i_encl, i_ff, i_ln2_g, i_ln2_b);// ((num_units, Lx), batch_size)
 
 		return i_encl;
 	}
@@ -118,6 +116,18 @@ struct Encoder{
 
 	~Encoder(){}
 
+	void quantize(){
+		for (auto& layer : _v_enc_layers) layer.quantize();
+	}
+
+	// bind a copy of this encoder to the configuration of its new owner (see TransformerModel::replicate)
+	// Note: RNN builders keep per-graph state, hence the copy gets its own (sharing the parameters).
+	void rebind(TransformerConfig& tfc){
+		for (auto& p_rnn : _v_p_src_rnns) p_rnn.reset(new dynet::LSTMBuilder(*p_rnn));
+		for (auto& layer : _v_enc_layers) layer.rebind(tfc);
+		_p_tfc = &tfc;
+	}
+
 	dynet::LookupParameter _p_embed_s;// source embeddings
 
 	dynet::LookupParameter _p_embed_pos;// position embeddings
@@ -288,6 +298,80 @@ struct Encoder{
 typedef std::shared_ptr<Encoder> EncoderPointer;
 //---
 
+//--- Decoder State
+// This keeps the self-attention keys and values of all positions decoded so far, for each decoder layer and each hypothesis (row) being decoded together, 
+// in buffers outside the computation graph, so that an incremental decoding step only needs to compute the newest position 
+// and the whole step can be reverted once its scores are read. A decoding step goes as:
+//	TransformerModel::step_forward -> read the scores -> TransformerModel::update_decoder_state -> cg.revert() -> DecoderState::select (rows of the next step)
+struct DecoderState{
+	explicit DecoderState(){}
+	explicit DecoderState(unsigned nlayers, unsigned num_units)
+		: _v_keys(nlayers), _v_values(nlayers), _v_keys_t(nlayers), _v_values_t(nlayers), _num_units(num_units)
+	{}
+
+	~DecoderState(){}
+
+	// preallocate the buffers for up to max_len positions of max_rows hypotheses
+	void reserve(unsigned max_len, unsigned max_rows)
+	{
+		size_t size = (size_t)_num_units * max_len * max_rows;
+		for (unsigned l = 0; l < _v_keys.size(); l++){
+			_v_keys[l].reserve(size);
+			_v_values[l].reserve(size);
+		}
+		_buffer.reserve(size);
+	}
+
+	// append the newest position of the last step to the cache, keeping (and reordering) the rows of the last step given by rows (backpointers of the next step's hypotheses)
+	void select(const std::vector<unsigned>& rows)
+	{
+		if (_v_keys.empty()){// nothing cached (e.g., hybrid model)
+			_t++;
+			_rows = rows.size();
+			return;
+		}
+		if (_v_keys_t[0].empty()) TRANSFORMER_RUNTIME_ASSERT("DecoderState::select: no newest position to be cached!");
+
+		unsigned last_rows = _v_keys_t[0].size() / _num_units;
+		for (auto& row : rows)
+			if (row >= last_rows) TRANSFORMER_RUNTIME_ASSERT("DecoderState::select: invalid row!");
+
+		for (unsigned l = 0; l < _v_keys.size(); l++){
+			gather(rows, _v_keys[l], _v_keys_t[l]);
+			gather(rows, _v_values[l], _v_values_t[l]);
+		}
+
+		_t++;
+		_rows = rows.size();
+	}
+
+	std::vector<std::vector<float>> _v_keys;// per layer, ((num_units, _t), _rows), col-major
+	std::vector<std::vector<float>> _v_values;// per layer, ((num_units, _t), _rows), col-major
+	std::vector<std::vector<float>> _v_keys_t;// per layer, ((num_units, 1), no. of rows of the last step), not cached yet
+	std::vector<std::vector<float>> _v_values_t;// per layer, ((num_units, 1), no. of rows of the last step), not cached yet
+	unsigned _num_units = 0;
+	unsigned _t = 0;// number of cached positions
+	unsigned _rows = 0;// number of cached hypotheses
+
+protected:
+	std::vector<float> _buffer;// swapped with the cache of each layer in turn
+
+	void gather(const std::vector<unsigned>& rows, std::vector<float>& cache, std::vector<float>& newest)
+	{
+		size_t old_size = (size_t)_num_units * _t, new_size = old_size + _num_units;// per row
+		_buffer.resize(new_size * rows.size());
+		for (unsigned r = 0; r < rows.size(); r++){
+			float* dst = _buffer.data() + r * new_size;
+			std::copy_n(cache.data() + rows[r] * old_size, old_size, dst);
+			std::copy_n(newest.data() + rows[r] * _num_units, _num_units, dst + old_size);
+		}
+
+		cache.swap(_buffer);
+		newest.clear();
+	}
+};
+//---
+
 //--- Decoder Layer
 struct DecoderLayer{
 	explicit DecoderLayer(DyNetModel* mod, TransformerConfig& tfc)
@@ -308,6 +392,19 @@ struct DecoderLayer{
 
 	~DecoderLayer(){}	
 
+	void quantize(){
+		_self_attention_sublayer.quantize();
+		_src_attention_sublayer.quantize();
+		_feed_forward_sublayer.quantize();
+	}
+
+	void rebind(TransformerConfig& tfc){
+		_self_attention_sublayer.rebind(tfc);
+		_src_attention_sublayer.rebind(tfc);
+		_feed_forward_sublayer.rebind(tfc);
+		_p_tfc = &tfc;
+	}
+
 	// multi-head attention sub-layers
 	MultiHeadAttentionLayer _self_attention_sublayer;// self-attention
 	MultiHeadAttentionLayer _src_attention_sublayer;// source attention
@@ -329,6 +426,40 @@ struct DecoderLayer{
 		, const MaskBase& self_mask
 		, const MaskBase& src_mask)
 	{	
+		// multi-head self attention sub-layer
+		dynet::Expression i_mh_self_att = _self_attention_sublayer.build_graph(cg, i_dec_inp, i_dec_inp, self_mask);// ((num_units, Ly), batch_size)
+
+		// source keys and values
+		dynet::Expression i_src_K, i_src_V;
+		_src_attention_sublayer.compute_keys_values(cg, i_enc_inp, i_src_K, i_src_V);
+
+		return build_remaining_sublayers(cg, i_src_K, i_src_V, i_dec_inp, i_mh_self_att, src_mask);
+	}
+
+	// incremental version (for decoding only): i_dec_inp holds the newest position only
+	dynet::Expression build_graph_incremental(dynet::ComputationGraph &cg
+		, const dynet::Expression& i_src_K/*precomputed source keys, see MultiHeadAttentionLayer::compute_keys_values*/
+		, const dynet::Expression& i_src_V/*precomputed source values*/
+		, const dynet::Expression& i_dec_inp/*((num_units, 1), batch_size)*/
+		, const MaskBase& src_mask
+		, const dynet::Expression& i_K_cache
+		, const dynet::Expression& i_V_cache
+		, dynet::Expression& i_K_t
+		, dynet::Expression& i_V_t)
+	{
+		// multi-head self attention sub-layer (over the cached keys and values)
+		dynet::Expression i_mh_self_att = _self_attention_sublayer.build_graph_incremental(cg, i_dec_inp, i_K_cache, i_V_cache, i_K_t, i_V_t);// ((num_units, 1), batch_size)
+
+		return build_remaining_sublayers(cg, i_src_K, i_src_V, i_dec_inp, i_mh_self_att, src_mask);
+	}
+
+	dynet::Expression build_remaining_sublayers(dynet::ComputationGraph &cg
+		, const dynet::Expression& i_src_K
+		, const dynet::Expression& i_src_V
+		, const dynet::Expression& i_dec_inp
+		, const dynet::Expression& i_self_att
+		, const MaskBase& src_mask)
+	{
 		// get expressions for layer normalisation, e.g., i_ln1_g, i_ln1_b, i_ln2_g, i_ln2_b, i_ln3_g, i_ln3_b
 		dynet::Expression i_ln1_g = dynet::parameter(cg, _p_ln1_g);
 		dynet::Expression i_ln1_b = dynet::parameter(cg, _p_ln1_b);
@@ -338,49 +469,24 @@ struct DecoderLayer{
 		dynet::Expression i_ln3_b = dynet::parameter(cg, _p_ln3_b);
 	
 		dynet::Expression i_decl = i_dec_inp;
-		
-		// multi-head self attention sub-layer
-		dynet::Expression i_mh_self_att = _self_attention_sublayer.build_graph(cg, i_decl, i_decl, self_mask);// ((num_units, Ly), batch_size)
-
-		// dropout to the output of sub-layer
-		if (_p_tfc->_use_dropout && _p_tfc->_decoder_sublayer_dropout_rate > 0.f)
-#ifdef USE_COLWISE_DROPOUT
-			i_mh_self_att = dynet::dropout_dim(i_mh_self_att, 1/*col-major*/, _p_tfc->_decoder_sublayer_dropout_rate);// col-wise dropout
-#else
-			i_mh_self_att = dynet::dropout(i_mh_self_att, _p_tfc->_decoder_sublayer_dropout_rate);// full dropout
-#endif
-
-		// w/ residual connection
-		i_decl = i_decl + i_mh_self_att;// ((num_units, Ly), batch_size)
+		dynet::Expression i_mh_self_att = i_self_att;
 
-		// layer normalisation 1
-		i_decl = layer_norm_colwise_3(i_decl, i_ln1_g, i_ln1_b);// ((num_units, Ly), batch_size)
+		// dropout to the output of sub-layer, w/ residual connection, then layer normalisation 1 (fused)
+		i_decl = residual_layer_norm(i_decl, i_mh_self_att, i_ln1_g, i_ln1_b
+			, _p_tfc->_use_dropout ? _p_tfc->_decoder_sublayer_dropout_rate : 0.f);// ((num_units, Ly), batch_size)
 
 		// multi-head source attention sub-layer
-		dynet::Expression i_mh_src_att = _src_attention_sublayer.build_graph(cg, i_decl, i_enc_inp, src_mask);// ((num_units, Ly), batch_size)
+		dynet::Expression i_mh_src_att = _src_attention_sublayer.build_graph(cg, i_decl, i_src_K, i_src_V, src_mask);// ((num_units, Ly), batch_size)
 
-		// dropout to the output of sub-layer
-		if (_p_tfc->_use_dropout && _p_tfc->_decoder_sublayer_dropout_rate > 0.f)
-#ifdef USE_COLWISE_DROPOUT
-			i_mh_src_att = dynet::dropout_dim(i_mh_src_att, 1/*col-major*/, _p_tfc->_decoder_sublayer_dropout_rate);// col-wise dropout
-#else
-			i_mh_src_att = dynet::dropout(i_mh_src_att, _p_tfc->_decoder_sublayer_dropout_rate);// full dropout
-#endif
-
-		// w/ residual connection
-		i_decl = i_decl + i_mh_src_att;
-
-		// layer normalisation 2
-		i_decl = layer_norm_colwise_3(i_decl, i_ln2_g, i_ln2_b);// ((num_units, Ly), batch_size)
+		// dropout to the output of sub-layer, w/ residual connection, then layer normalisation 2 (fused)
+		i_decl = residual_layer_norm(i_decl, i_mh_src_att, i_ln2_g, i_ln2_b
+			, _p_tfc->_use_dropout ? _p_tfc->_decoder_sublayer_dropout_rate : 0.f);// ((num_units, Ly), batch_size)
 
 		// position-wise feed-forward sub-layer
 		dynet::Expression i_ff = _feed_forward_sublayer.build_graph(cg, i_decl);// ((num_units, Ly), batch_size)
 
-		// w/ residual connection
-		i_decl = i_decl + i_ff;
-
-		// layer normalisation 3
-		i_decl = layer_norm_colwise_3(i_decl, i_ln3_g, i_ln3_b);// ((num_units, Ly), batch_size)
+		// w/ residual connection, then layer normalisation 3 (fused)
+		i_decl = residual_layer_norm(i_decl, i_ff, i_ln3_g, i_ln3_b);// ((num_units, Ly), batch_size)
 
 		return i_decl;
 	}
@@ -415,6 +521,18 @@ struct Decoder{
 
 	~Decoder(){}
 
+	void quantize(){
+		for (auto& layer : _v_dec_layers) layer.quantize();
+	}
+
+	// bind a copy of this decoder to the configuration and encoder of its new owner (see TransformerModel::replicate)
+	void rebind(TransformerConfig& tfc, Encoder* p_encoder){
+		if (_p_tgt_rnn) _p_tgt_rnn.reset(new dynet::LSTMBuilder(*_p_tgt_rnn));
+		for (auto& layer : _v_dec_layers) layer.rebind(tfc);
+		_p_tfc = &tfc;
+		_p_encoder = p_encoder;
+	}
+
 	dynet::LookupParameter _p_embed_t;// source embeddings
 	dynet::LookupParameter _p_embed_pos;// position embeddings
 
@@ -435,6 +553,13 @@ struct Decoder{
 	// decoder masks
 	MaskBase _self_mask;
 	MaskBase _src_mask;
+	// keys and values of the newest position per layer (incremental decoding only)
+	std::vector<dynet::Expression> _v_i_keys_t;
+	std::vector<dynet::Expression> _v_i_values_t;
+	// source keys and values per layer, computed once per source (incremental decoding only)
+	dynet::Expression _i_src_rep_cached;
+	std::vector<dynet::Expression> _v_i_src_keys;
+	std::vector<dynet::Expression> _v_i_src_values;
 	// ---
 
 	dynet::Expression get_wrd_embedding_matrix(dynet::ComputationGraph &cg){
@@ -549,9 +674,9 @@ struct Decoder{
 		// source-attention
 		_src_mask.create_seq_mask_expr(cg, v_seq_masks, false);
 #ifdef MULTI_HEAD_ATTENTION_PARALLEL
-		_src_mask.create_padding_positions_masks(_p_encoder->_self_mask._i_seq_mask, _p_tfc->_nheads);
+		_src_mask.create_padding_positions_masks(_p_encoder->_self_mask, _p_tfc->_nheads);
 #else 
-		_src_mask.create_padding_positions_masks(_p_encoder->_self_mask._i_seq_mask, 1);
+		_src_mask.create_padding_positions_masks(_p_encoder->_self_mask, 1);
 #endif
 
 		return i_tgt;
@@ -572,6 +697,128 @@ struct Decoder{
 	
 		return i_dec_l_out;// ((num_units, Ly), batch_size)
 	}
+
+	// --- incremental decoding
+	void compute_source_keys_values(dynet::ComputationGraph &cg
+		, const dynet::Expression& i_src_rep)
+	{
+		_v_i_src_keys.resize(_v_dec_layers.size());
+		_v_i_src_values.resize(_v_dec_layers.size());
+		for (unsigned l = 0; l < _v_dec_layers.size(); l++)
+			_v_dec_layers[l]._src_attention_sublayer.compute_keys_values(cg, i_src_rep, _v_i_src_keys[l], _v_i_src_values[l]);// ((num_units/nheads, Lx), batch_size*nheads)
+
+		_i_src_rep_cached = i_src_rep;
+	}
+
+	dynet::Expression compute_embeddings_and_masks_incremental(dynet::ComputationGraph &cg
+		, const std::vector<unsigned>& words/*newest words*/
+		, unsigned pos/*their position*/
+		, const std::vector<unsigned>& src_ids/*source batch element of each word; empty if aligned one-to-one*/)
+	{
+		// target embeddings
+		dynet::Expression i_tgt = dynet::lookup(cg, _p_embed_t, words);// ((num_units, 1), batch_size)
+
+		// scale
+		i_tgt = i_tgt * _scale_emb;// scaled embeddings
+
+		// + postional encoding
+		if (_p_tfc->_position_encoding_flag == 0 || _p_tfc->_position_encoding_flag == 2){
+			if (_p_tfc->_position_encoding == 1){// learned positional embedding 
+				std::vector<unsigned> positions(words.size(), (pos >= _p_tfc->_max_length) ? _p_tfc->_max_length - 1 : pos);// same trick as in compute_embeddings_and_masks
+				i_tgt = i_tgt + dynet::lookup(cg, _p_embed_pos, positions);
+			}
+			else if (_p_tfc->_position_encoding == 2){// sinusoidal positional encoding
+				dynet::Expression i_pos = make_sinusoidal_position_encoding(cg, i_tgt.dim(), pos);
+
+				i_tgt = i_tgt + i_pos;
+			}
+			else if (_p_tfc->_position_encoding != 0) TRANSFORMER_RUNTIME_ASSERT("Unknown positional encoding type!");
+		}
+
+		// dropout to the sums of the embeddings and the positional encodings
+		if (_p_tfc->_use_dropout && _p_tfc->_decoder_emb_dropout_rate > 0.f)
+#ifdef USE_COLWISE_DROPOUT
+			i_tgt = dynet::dropout_dim(i_tgt, 1/*col-major*/, _p_tfc->_decoder_emb_dropout_rate);// col-wise dropout
+#else
+			i_tgt = dynet::dropout(i_tgt, _p_tfc->_decoder_emb_dropout_rate);// full dropout		
+#endif
+
+		// create maskings
+		// Note: self-attention needs no masks since the newest position attends to all previous ones.
+		// source-attention
+		_src_mask.create_seq_mask_expr(cg, std::vector<std::vector<float>>(words.size(), std::vector<float>(1, 0.f)), false);
+#ifdef MULTI_HEAD_ATTENTION_PARALLEL
+		_src_mask.create_padding_positions_masks(_p_encoder->_self_mask, _p_tfc->_nheads, src_ids);
+#else 
+		_src_mask.create_padding_positions_masks(_p_encoder->_self_mask, 1, src_ids);
+#endif
+
+		return i_tgt;
+	}
+
+	dynet::Expression build_graph_incremental(dynet::ComputationGraph &cg
+		, const std::vector<unsigned>& words/*newest words*/
+		, const DecoderState& state/*one row per batch element*/
+		, const dynet::Expression& i_src_rep
+		, const std::vector<unsigned>& src_ids=std::vector<unsigned>()/*source batch element of each word; empty if aligned one-to-one*/)
+	{
+		unsigned bsize = words.size(), t = state._t;
+
+		// compute target (+ postion) embeddings at the newest position only
+		dynet::Expression i_tgt_rep = compute_embeddings_and_masks_incremental(cg, words, t, src_ids);// ((num_units, 1), batch_size)
+
+		// source keys and values (normally precomputed along with i_src_rep)
+		if (_i_src_rep_cached.pg != i_src_rep.pg || _i_src_rep_cached.graph_id != i_src_rep.graph_id || _i_src_rep_cached.i != i_src_rep.i)
+			compute_source_keys_values(cg, i_src_rep);
+
+		// select the source batch element of each batch element (e.g., several hypotheses from the same source)
+		std::vector<unsigned> head_src_ids;
+#ifdef USE_FUSED_MULTI_HEAD_ATTENTION
+		if (use_cpu_fused_nodes())
+			head_src_ids = src_ids;// source keys and values are not split into heads
+		else
+#endif
+		if (!src_ids.empty()){
+			unsigned src_bsize = i_src_rep.dim().bd;
+			for (unsigned h = 0; h < _p_tfc->_nheads; h++)
+				for (auto& id : src_ids) head_src_ids.push_back(h * src_bsize + id);// heads are concatenated along the batch dimension
+		}
+
+		_v_i_keys_t.resize(_v_dec_layers.size());
+		_v_i_values_t.resize(_v_dec_layers.size());
+
+		dynet::Expression i_dec_l_out = i_tgt_rep;
+		for (unsigned l = 0; l < _v_dec_layers.size(); l++){
+			// the cached keys and values (copied in when the step is evaluated)
+			dynet::Expression i_K_cache, i_V_cache;
+			if (t > 0){
+				i_K_cache = dynet::input(cg, dynet::Dim({_p_tfc->_num_units, t}, bsize), &state._v_keys[l]);// ((num_units, t), batch_size)
+				i_V_cache = dynet::input(cg, dynet::Dim({_p_tfc->_num_units, t}, bsize), &state._v_values[l]);// ((num_units, t), batch_size)
+			}
+
+			// stacking approach
+			dynet::Expression i_src_K = _v_i_src_keys[l], i_src_V = _v_i_src_values[l];
+			if (!head_src_ids.empty()){
+				i_src_K = dynet::pick_batch_elems(i_src_K, head_src_ids);// ((num_units/nheads, Lx), batch_size*nheads)
+				i_src_V = dynet::pick_batch_elems(i_src_V, head_src_ids);// ((num_units/nheads, Lx), batch_size*nheads)
+			}
+
+			i_dec_l_out = _v_dec_layers[l].build_graph_incremental(cg, i_src_K, i_src_V, i_dec_l_out, _src_mask, i_K_cache, i_V_cache, _v_i_keys_t[l], _v_i_values_t[l]);
+		}
+
+		return i_dec_l_out;// ((num_units, 1), batch_size)
+	}
+
+	// copy the keys and values of the newest position (from the last build_graph_incremental) out of the graph into state
+	// Note: to be called once the step is evaluated but before it is reverted; they are cached by DecoderState::select.
+	void update_state(DecoderState& state)
+	{
+		for (unsigned l = 0; l < _v_dec_layers.size(); l++){
+			state._v_keys_t[l] = dynet::as_vector(_v_i_keys_t[l].value());// ((num_units, 1), batch_size)
+			state._v_values_t[l] = dynet::as_vector(_v_i_values_t[l].value());// ((num_units, 1), batch_size)
+		}
+	}
+	// ---
 };
 typedef std::shared_ptr<Decoder> DecoderPointer;
 //---
@@ -600,6 +847,31 @@ public:
 		, const WordIdSentence &partial_sent
 		, bool log_prob
 		, std::vector<dynet::Expression> &aligns);// forward step to get softmax scores
+	dynet::Expression step_forward(dynet::ComputationGraph & cg
+		, const dynet::Expression& i_src_rep
+		, const WordIdSentence &partial_sent
+		, DecoderState& state
+		, bool log_prob
+		, std::vector<dynet::Expression> &aligns);// incremental forward step (w/ cached keys and values of partial_sent)
+	dynet::Expression step_forward(dynet::ComputationGraph & cg
+		, const dynet::Expression& i_src_rep
+		, const WordIdSentences &partial_sents/*same length*/
+		, const DecoderState& state/*one row per partial sentence*/
+		, const std::vector<unsigned>& src_ids/*source batch element of each partial sentence*/
+		, bool log_prob
+		, std::vector<dynet::Expression> &aligns);// batched incremental forward step, returning ((|V_T|, 1), batch_size) scores
+	// Note: the incremental step_forward is step_decode, then step_output. The whole step can be reverted once its scores are read and update_decoder_state is called.
+	dynet::Expression step_decode(dynet::ComputationGraph & cg
+		, const dynet::Expression& i_src_rep
+		, const WordIdSentences &partial_sents/*same length*/
+		, const DecoderState& state/*one row per partial sentence*/
+		, const std::vector<unsigned>& src_ids/*source batch element of each partial sentence*/
+		, std::vector<dynet::Expression> &aligns);// batched incremental decoder step (w/o output layer), returning ((num_units, 1), batch_size)
+	dynet::Expression step_output(dynet::ComputationGraph & cg
+		, const dynet::Expression& i_tgt_t
+		, bool log_prob);// output layer of a decoding step, returning ((|V_T|, 1), batch_size) scores
+	DecoderState init_decoder_state();
+	void update_decoder_state(DecoderState& state);// copy the keys and values of the newest position of the last (evaluated) step into state, before cg.revert()
 	std::string sample(dynet::ComputationGraph& cg, const WordIdSentence &source, WordIdSentence &target);// sampling
 	std::string greedy_decode(dynet::ComputationGraph& cg, const WordIdSentence &source, WordIdSentence &target);// greedy decoding
 	std::string beam_decode(dynet::ComputationGraph& cg, const WordIdSentence &source, WordIdSentence &target, unsigned beam_width);// beam search decoding
@@ -615,6 +887,17 @@ public:
 
 	TransformerConfig& get_config();
 
+	// restrict the output projection and softmax of step_forward to the given (sorted) target word ids; empty for the full vocabulary
+	// Note: the scores returned by step_forward are then indexed by position in this list, not by word id.
+	void set_output_shortlist(const std::vector<unsigned>& ids){ _output_shortlist = ids; }
+
+	// switch all linear projections (incl. the tied output projection) to int8 weights with per-row scales; for decoding on CPU only
+	void quantize();
+
+	// a copy sharing the parameters (and int8 weights) of this model, but with its own configuration and per-graph state
+	// Note: replicas can decode concurrently, each on its own thread under its own dynet::ExecutionContext.
+	std::shared_ptr<TransformerModel> replicate() const;
+
 protected:
 
 	DyNetModelPointer _all_params;// all model parameters live in this object pointer. This object will be automatically released once unused!
@@ -627,7 +910,13 @@ protected:
 
 	dynet::Parameter _p_Wo_bias;// bias of final linear projection layer
 
+	std::vector<unsigned> _output_shortlist;// target word ids scored by step_forward (decoding only)
+
+	std::shared_ptr<dynet::QuantizedMatrix> _q_Wo;// int8 output projection (|V_T| x num_units), if quantised
+
 	TransformerConfig _tfc;// local configuration storage
+
+	dynet::Expression project_output(dynet::ComputationGraph &cg, const dynet::Expression& i_tgt_t);// scores of the (shortlisted) vocabulary
 };
 
 TransformerModel::TransformerModel(){
@@ -660,6 +949,9 @@ dynet::Expression TransformerModel::compute_source_rep(dynet::ComputationGraph &
 	ModelStats stats;// unused
 	dynet::Expression i_src_ctx = _encoder.get()->build_graph(cg, ssents, stats);// ((num_units, Lx), batch_size)
 
+	// precompute the source keys and values of all decoder layers, which are reused at every decoding step
+	if (!_tfc._use_hybrid_model) _decoder.get()->compute_source_keys_values(cg, i_src_ctx);
+
 	return i_src_ctx;
 }
 
@@ -670,7 +962,7 @@ dynet::Expression TransformerModel::step_forward(dynet::ComputationGraph &cg
 	, std::vector<dynet::Expression> &aligns)
 {
 	// decode target
-	// IMPROVEMENT: during decoding, some parts in partial_sent will be recomputed. This is wasteful, especially for beam search decoding.
+	// Note: the whole partial_sent will be recomputed. Use the step_forward with DecoderState instead for faster decoding.
 	dynet::Expression i_tgt_ctx = _decoder.get()->build_graph(cg, WordIdSentences(1, partial_sent), i_src_rep);
 	dynet::Expression i_tgt_t;
 	if (partial_sent.size() == 1) i_tgt_t = i_tgt_ctx;
@@ -679,9 +971,7 @@ dynet::Expression TransformerModel::step_forward(dynet::ComputationGraph &cg
 		i_tgt_t = dynet::pick(i_tgt_ctx, (unsigned)(partial_sent.size() - 1), 1);// shifted right, ((|V_T|, 1), batch_size)
 
 	// output linear projections (w/ bias)
-	dynet::Expression i_Wo_bias = dynet::parameter(cg, _p_Wo_bias);
-	dynet::Expression i_Wo_emb_tgt = dynet::transpose(_decoder.get()->get_wrd_embedding_matrix(cg));// weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
-	dynet::Expression i_r_t = dynet::affine_transform({i_Wo_bias, i_Wo_emb_tgt, i_tgt_t});// |V_T| x 1 (with additional bias)
+	dynet::Expression i_r_t = project_output(cg, i_tgt_t);// |V_T| x 1 (with additional bias)
 
 	// FIXME: get the alignments for visualisation
 
@@ -692,6 +982,116 @@ dynet::Expression TransformerModel::step_forward(dynet::ComputationGraph &cg
 		return dynet::softmax(i_r_t);
 }
 
+void TransformerModel::quantize()
+{
+	_encoder.get()->quantize();
+	_decoder.get()->quantize();
+	_q_Wo.reset(new dynet::QuantizedMatrix(_decoder.get()->_p_embed_t.get_storage().all_values, true/*transposed*/));
+}
+
+std::shared_ptr<TransformerModel> TransformerModel::replicate() const
+{
+	std::shared_ptr<TransformerModel> p_tf(new TransformerModel(*this));// shares _all_params and _q_Wo
+
+	p_tf->_encoder.reset(new Encoder(*_encoder.get()));
+	p_tf->_encoder.get()->rebind(p_tf->_tfc);
+	p_tf->_decoder.reset(new Decoder(*_decoder.get()));
+	p_tf->_decoder.get()->rebind(p_tf->_tfc, p_tf->_encoder.get());
+
+	return p_tf;
+}
+
+dynet::Expression TransformerModel::project_output(dynet::ComputationGraph &cg, const dynet::Expression& i_tgt_t)
+{
+	dynet::Expression i_Wo_bias = dynet::parameter(cg, _p_Wo_bias);
+	if (_q_Wo)// int8 inference, gathering the shortlisted rows (if any) inside
+		return dynet::int8_affine_transform(i_Wo_bias, *_q_Wo, i_tgt_t, _output_shortlist);
+
+	dynet::Expression i_Wo_emb_tgt = _decoder.get()->get_wrd_embedding_matrix(cg);// num_units x |V_T|; weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
+	if (_output_shortlist.size() != 0){// gather the shortlisted rows only
+		i_Wo_bias = dynet::select_rows(i_Wo_bias, _output_shortlist);// |S|
+		i_Wo_emb_tgt = dynet::select_cols(i_Wo_emb_tgt, _output_shortlist);// num_units x |S|
+	}
+
+	return dynet::affine_transform_t({i_Wo_bias, i_Wo_emb_tgt, i_tgt_t});
+}
+
+DecoderState TransformerModel::init_decoder_state()
+{
+	return DecoderState(_tfc._use_hybrid_model ? 0 : _tfc._nlayers, _tfc._num_units);// the hybrid model caches nothing
+}
+
+void TransformerModel::update_decoder_state(DecoderState& state)
+{
+	if (!_tfc._use_hybrid_model) _decoder.get()->update_state(state);
+}
+
+dynet::Expression TransformerModel::step_forward(dynet::ComputationGraph &cg
+	, const dynet::Expression& i_src_rep
+	, const WordIdSentence &partial_sent
+	, DecoderState& state
+	, bool log_prob
+	, std::vector<dynet::Expression> &aligns)
+{
+	return step_forward(cg, i_src_rep, WordIdSentences(1, partial_sent), state, std::vector<unsigned>(), log_prob, aligns);
+}
+
+dynet::Expression TransformerModel::step_forward(dynet::ComputationGraph &cg
+	, const dynet::Expression& i_src_rep
+	, const WordIdSentences &partial_sents
+	, const DecoderState& state
+	, const std::vector<unsigned>& src_ids
+	, bool log_prob
+	, std::vector<dynet::Expression> &aligns)
+{
+	dynet::Expression i_tgt_t = step_decode(cg, i_src_rep, partial_sents, state, src_ids, aligns);
+
+	return step_output(cg, i_tgt_t, log_prob);
+}
+
+dynet::Expression TransformerModel::step_decode(dynet::ComputationGraph &cg
+	, const dynet::Expression& i_src_rep
+	, const WordIdSentences &partial_sents
+	, const DecoderState& state
+	, const std::vector<unsigned>& src_ids
+	, std::vector<dynet::Expression> &aligns)
+{
+	dynet::Expression i_tgt_t;
+	if (_tfc._use_hybrid_model){// hybrid architecture: the target RNN needs to be re-run over each partial sentence
+		if (i_src_rep.dim().bd != 1) TRANSFORMER_RUNTIME_ASSERT("step_decode: batched decoding with hybrid model requires a single source!");
+		std::vector<dynet::Expression> v_tgt_t;
+		for (auto& partial_sent : partial_sents){
+			dynet::Expression i_tgt_ctx = _decoder.get()->build_graph(cg, WordIdSentences(1, partial_sent), i_src_rep);
+			v_tgt_t.push_back((partial_sent.size() == 1) ? i_tgt_ctx : dynet::pick(i_tgt_ctx, (unsigned)(partial_sent.size() - 1), 1));
+		}
+		i_tgt_t = dynet::concatenate_to_batch(v_tgt_t);// ((num_units, 1), batch_size)
+	}
+	else{
+		if (state._t > 0 && state._rows != partial_sents.size()) TRANSFORMER_RUNTIME_ASSERT("step_decode: decoder state does not match the partial sentences!");
+		std::vector<unsigned> words(partial_sents.size());
+		for (unsigned bs = 0; bs < partial_sents.size(); bs++){
+			if (state._t + 1 != partial_sents[bs].size()) TRANSFORMER_RUNTIME_ASSERT("step_decode: decoder state does not match the partial sentence!");
+			words[bs] = (unsigned)partial_sents[bs].back();
+		}
+
+		// decode target at the newest position only
+		i_tgt_t = _decoder.get()->build_graph_incremental(cg, words, state, i_src_rep, src_ids);// ((num_units, 1), batch_size)
+	}
+
+	return i_tgt_t;
+}
+
+dynet::Expression TransformerModel::step_output(dynet::ComputationGraph &cg
+	, const dynet::Expression& i_tgt_t
+	, bool log_prob)
+{
+	// output linear projections (w/ bias)
+	dynet::Expression i_r_t = project_output(cg, i_tgt_t);// ((|V_T|, 1), batch_size) (with additional bias)
+
+	// compute softmax prediction
+	return (log_prob) ? dynet::log_softmax(i_r_t) : dynet::softmax(i_r_t);
+}
+
 dynet::Expression TransformerModel::build_graph(dynet::ComputationGraph &cg
 	, const WordIdSentences& ssents
 	, const WordIdSentences& tsents
@@ -706,7 +1106,7 @@ dynet::Expression TransformerModel::build_graph(dynet::ComputationGraph &cg
 
 	// get losses	
 	dynet::Expression i_Wo_bias = dynet::parameter(cg, _p_Wo_bias);
-	dynet::Expression i_Wo_emb_tgt = dynet::transpose(_decoder.get()->get_wrd_embedding_matrix(cg));// weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
+	dynet::Expression i_Wo_emb_tgt = _decoder.get()->get_wrd_embedding_matrix(cg);// num_units x |V_T|; weight tying (use the same weight with target word embedding matrix) following https://arxiv.org/abs/1608.05859
 
 // both of the followings work well!
 #ifndef USE_LINEAR_TRANSFORMATION_BROADCASTING 
@@ -728,7 +1128,7 @@ dynet::Expression TransformerModel::build_graph(dynet::ComputationGraph &cg
 		dynet::Expression i_tgt_t = dynet::pick(i_tgt_ctx, t, 1);// shifted right, ((|V_T|, 1), batch_size)
 
 		// output linear projections
-		dynet::Expression i_r_t = dynet::affine_transform({i_Wo_bias, i_Wo_emb_tgt, i_tgt_t});// |V_T| x 1 (with additional bias)
+		dynet::Expression i_r_t = dynet::affine_transform_t({i_Wo_bias, i_Wo_emb_tgt, i_tgt_t});// |V_T| x 1 (with additional bias)
 	
 		// log_softmax and loss
 		dynet::Expression i_err;
@@ -746,40 +1146,31 @@ dynet::Expression TransformerModel::build_graph(dynet::ComputationGraph &cg
 		v_errors.push_back(i_err);
 	}
 #else // Note: this way is much faster!
-	// compute the logit and linear projections
-	dynet::Expression i_r = dynet::affine_transform({i_Wo_bias, i_Wo_emb_tgt, i_tgt_ctx});// ((|V_T|, (Ly-1)), batch_size)
-
-	std::vector<dynet::Expression> v_errors;
+	// gather the real (non-padded) target positions, so that the output projection and softmax only run on packed real tokens
 	unsigned tlen = _decoder.get()->_batch_tlen;
-	std::vector<unsigned> next_words(tsents.size());
-	for (unsigned t = 0; t < tlen - 1; ++t) {// shifted right
-		for(size_t bs = 0; bs < tsents.size(); bs++){
-			next_words[bs] = (tsents[bs].size() > (t + 1)) ? (unsigned)tsents[bs][t + 1] : _tfc._sm._kTGT_EOS;
-			if (tsents[bs].size() > t) {
-				stats._words_tgt++;
-				if (tsents[bs][t] == _tfc._sm._kTGT_UNK) stats._words_tgt_unk++;
-			}
+	unsigned ctx_len = i_tgt_ctx.dim()[1];// Ly-1 during training (shifted right), Ly otherwise
+	std::vector<unsigned> real_ids, next_words;
+	for(size_t bs = 0; bs < tsents.size(); bs++){
+		for (unsigned t = 0; t + 1 < tsents[bs].size(); ++t) {// shifted right
+			real_ids.push_back(bs * ctx_len + t);
+			next_words.push_back((unsigned)tsents[bs][t + 1]);
 		}
 
-		// get the prediction at timestep t
-		//dynet::Expression i_r_t = dynet::select_cols(i_r, {t});// shifted right, ((|V_T|, 1), batch_size)
-		dynet::Expression i_r_t = dynet::pick(i_r, t, 1);// shifted right, ((|V_T|, 1), batch_size)
-	
-		// log_softmax and loss
-		dynet::Expression i_err;
-		if (_tfc._use_label_smoothing && !is_eval_on_dev/*only applies in training*/)
-		{// w/ label smoothing (according to section 7.5.1 of http://www.deeplearningbook.org/contents/regularization.html) and https://arxiv.org/pdf/1512.00567v1.pdf.
-			// label smoothing regularizes a model based on a softmax with k output values by replacing the hard 0 and 1 classification targets with targets of \epsilon / (k−1) and 1 − \epsilon, respectively!
-			dynet::Expression i_log_softmax = dynet::log_softmax(i_r_t);
-			dynet::Expression i_pre_loss = -dynet::pick(i_log_softmax, next_words);
-			dynet::Expression i_ls_loss = -dynet::sum_elems(i_log_softmax) / (_tfc._tgt_vocab_size - 1);// or -dynet::mean_elems(i_log_softmax)
-			i_err = (1.f - _tfc._label_smoothing_weight) * i_pre_loss + _tfc._label_smoothing_weight * i_ls_loss;
+		for (unsigned t = 0; t < std::min(tlen - 1, (unsigned)tsents[bs].size()); ++t) {
+			stats._words_tgt++;
+			if (tsents[bs][t] == _tfc._sm._kTGT_UNK) stats._words_tgt_unk++;
 		}
-		else 
-			i_err = dynet::pickneglogsoftmax(i_r_t, next_words);
-
-		v_errors.push_back(i_err);
 	}
+	dynet::Expression i_tgt_real = dynet::pick_batch_elems(dynet::reshape(i_tgt_ctx, dynet::Dim({_tfc._num_units}, ctx_len * tsents.size())), real_ids);// ((num_units, 1), no. of real tokens)
+
+	// compute the logit and linear projections
+	dynet::Expression i_r = dynet::affine_transform_t({i_Wo_bias, i_Wo_emb_tgt, i_tgt_real});// ((|V_T|, 1), no. of real tokens)
+
+	// fused log_softmax and loss (w/ label smoothing only applies in training), see dynet::softmax_cross_entropy
+	float ls_weight = (_tfc._use_label_smoothing && !is_eval_on_dev) ? _tfc._label_smoothing_weight : 0.f;
+	dynet::Expression i_err = dynet::softmax_cross_entropy(i_r, next_words, {}, ls_weight);// scalar
+
+	std::vector<dynet::Expression> v_errors(1, i_err);
 #endif
 
 	dynet::Expression i_tloss = dynet::sum_batches(dynet::sum(v_errors));
@@ -800,6 +1191,7 @@ std::string TransformerModel::sample(dynet::ComputationGraph& cg, const WordIdSe
 	target.push_back(sos_sym); 
 
 	dynet::Expression i_src_rep = this->compute_source_rep(cg, WordIdSentences(1, source)/*pseudo batch (1)*/);
+	DecoderState state = this->init_decoder_state();
 
 	std::vector<dynet::Expression> aligns;// FIXME: unused
 	std::stringstream ss;
@@ -808,8 +1200,8 @@ std::string TransformerModel::sample(dynet::ComputationGraph& cg, const WordIdSe
 	while (target.back() != eos_sym) 
 	{
 		cg.checkpoint();
-				
-		dynet::Expression ydist = this->step_forward(cg, i_src_rep, target, false, aligns);
+
+		dynet::Expression ydist = this->step_forward(cg, i_src_rep, target, state, false, aligns);
 
 		auto dist = dynet::as_vector(cg.incremental_forward(ydist));
 		double p = rand01();
@@ -828,7 +1220,9 @@ std::string TransformerModel::sample(dynet::ComputationGraph& cg, const WordIdSe
 		t += 1;
 		if (_tfc._position_encoding == 1 && t >= _tfc._max_length) break;// to prevent over-length sample in learned positional encoding
 
+		this->update_decoder_state(state);
 		cg.revert();
+		state.select(std::vector<unsigned>(1, 0));
 	}
 
 	_tfc._is_training = true;
@@ -849,6 +1243,7 @@ std::string TransformerModel::greedy_decode(dynet::ComputationGraph& cg, const W
 	target.push_back(sos_sym); 
 
 	dynet::Expression i_src_rep = this->compute_source_rep(cg, WordIdSentences(1, source)/*pseudo batch (1)*/);
+	DecoderState state = this->init_decoder_state();
 	
 	std::vector<dynet::Expression> aligns;// FIXME: unused
 	std::stringstream ss;
@@ -857,8 +1252,8 @@ std::string TransformerModel::greedy_decode(dynet::ComputationGraph& cg, const W
 	while (target.back() != eos_sym) 
 	{
 		cg.checkpoint();
-			
-		dynet::Expression i_ydist = this->step_forward(cg, i_src_rep, target, false, aligns);
+
+		dynet::Expression i_ydist = this->step_forward(cg, i_src_rep, target, state, false, aligns);
 
 		// find the argmax next word (greedy)
 		unsigned w = 0;
@@ -883,7 +1278,9 @@ std::string TransformerModel::greedy_decode(dynet::ComputationGraph& cg, const W
 		t += 1;
 		if (_tfc._position_encoding == 1 && t >= _tfc._max_length) break;// to prevent over-length sample in learned positional encoding
 
+		this->update_decoder_state(state);
 		cg.revert();
+		state.select(std::vector<unsigned>(1, 0));
 	}
 
 	_tfc._is_training = true;
@@ -895,8 +1292,8 @@ struct Hypothesis {
 	Hypothesis() {};
 	Hypothesis(int tgt, float cst, std::vector<Expression> &al)
 		: target({tgt}), cost(cst), costs({1.f}), aligns(al) {}
-	Hypothesis(int tgt, float cst, Hypothesis &last, std::vector<Expression> &al)
-		: target(last.target), costs(last.costs), aligns(al) {
+	Hypothesis(int tgt, float cst, Hypothesis &last, std::vector<Expression> &al, unsigned r)
+		: target(last.target), costs(last.costs), aligns(al), row(r) {
 		target.push_back(tgt);
 		cost = last.cost - std::log(cst);
 		costs.push_back(cst); 
@@ -906,6 +1303,7 @@ struct Hypothesis {
 	float cost;
 	std::vector<float> costs;
 	std::vector<Expression> aligns;
+	unsigned row = 0;// row of the decoder state (at the last step) extended by this hypothesis
 };
 
 std::string TransformerModel::beam_decode(dynet::ComputationGraph& cg, const WordIdSentence &source, WordIdSentence &target, unsigned beam_width)// FIXME: to be tested?
@@ -927,36 +1325,55 @@ std::string TransformerModel::beam_decode(dynet::ComputationGraph& cg, const Wor
 	std::vector<Hypothesis> chart;
 	chart.push_back(Hypothesis(sos_sym, 0.0f, aligns));
 
-	std::vector<unsigned> vocab(boost::copy_range<std::vector<unsigned>>(boost::irange(0u, tdict.size())));
+	// the cached keys and values of all hypotheses in the chart (one row each)
+	DecoderState state = this->init_decoder_state();
+	state.reserve(2*source.size(), beam_width);
+
 	std::vector<Hypothesis> completed;
 
-	for (unsigned steps = 0; completed.size() < beam_width && steps < 2*source.size(); ++steps) {
-		std::vector<Hypothesis> new_chart;
+	for (unsigned steps = 0; completed.size() < beam_width && steps < 2*source.size() && chart.size() != 0; ++steps) {
+		if (steps > 0) {// keep the rows of the surviving hypotheses
+			std::vector<unsigned> rows;
+			for (auto& h : chart) rows.push_back(h.row);
+			state.select(rows);
+		}
 
-		for (auto& hprev: chart) {
-			cg.checkpoint();
-		
-			dynet::Expression i_ydist = this->step_forward(cg, i_src_rep, hprev.target, false, aligns);
+		cg.checkpoint();
+
+		// forward all hypotheses in the chart together
+		WordIdSentences partial_sents;
+		for (auto& h : chart) partial_sents.push_back(h.target);
+		dynet::Expression i_ydist = this->step_forward(cg, i_src_rep, partial_sents, state, std::vector<unsigned>(chart.size(), 0), false, aligns);// ((|V_T|, 1), chart size)
+
+		auto ydist = dynet::as_vector(cg.incremental_forward(i_ydist));
+		unsigned vocab_size = ydist.size() / chart.size();
+
+		std::vector<Hypothesis> new_chart;
+		for (unsigned k = 0; k < chart.size(); k++) {
+			Hypothesis& hprev = chart[k];
+			const float* dist = ydist.data() + k * vocab_size;
 
 			// find the top k best next words
-			auto ydist = dynet::as_vector(cg.incremental_forward(i_ydist));
-			std::partial_sort(vocab.begin(), vocab.begin()+beam_width, vocab.end(), 
-				[&ydist](unsigned v1, unsigned v2) { return ydist[v1] > ydist[v2]; });
+			std::vector<TopKEntry> topk;
+			topk_scan(dist, 0, vocab_size, 0.f, 0, beam_width, topk);
+			topk_sort(topk);
 
 			// add to chart
-			for (auto vi = vocab.begin(); vi < vocab.begin() + beam_width; ++vi) {
+			for (auto& e : topk) {
+				unsigned vi = e.id;
 				//if (new_chart.size() < beam_width) {
-					Hypothesis hnew(*vi, ydist[*vi]/*hprev.cost - std::log(ydist[*vi])*/, hprev, aligns);
-					if (*vi == (unsigned int)eos_sym)
+					Hypothesis hnew(vi, dist[vi]/*hprev.cost - std::log(dist[vi])*/, hprev, aligns, k);
+					if (vi == (unsigned int)eos_sym)
 						completed.push_back(hnew);
 					else
 						new_chart.push_back(hnew);
 				//} 
 			}
-	
-			cg.revert();
 		}
 
+		this->update_decoder_state(state);
+		cg.revert();
+
 		if (new_chart.size() > beam_width) {
 			// sort new_chart by score, to get kbest candidates
 			std::partial_sort(new_chart.begin(), new_chart.begin()+beam_width, new_chart.end(),
@@ -989,12 +1406,12 @@ dynet::ParameterCollection& TransformerModel::get_model_parameters(){
 
 void TransformerModel::initialise_params_from_file(const std::string &params_file)
 {
-	dynet::load_dynet_model(params_file, _all_params.get());// FIXME: use binary streaming instead for saving disk spaces?
+	dynet::load_dynet_model(params_file, _all_params.get());// text or binary format (detected from the file header)
 }
 
 void TransformerModel::save_params_to_file(const std::string &params_file)
 {
-	dynet::save_dynet_model(params_file, _all_params.get());// FIXME: use binary streaming instead for saving disk spaces?
+	dynet::save_dynet_model(params_file, _all_params.get(), true/*binary, memory-mappable on loading*/);
 }
 
 void TransformerModel::set_dropout(bool is_activated){